@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal harness for audiobridge_bench.
+//
+// A benchmark times a batch function with measure(), which repeats the batch
+// until it has run for the minimum time and keeps the fastest of a few
+// rounds, then records a named figure with report(). Names are
+// "<group>/<case>" and must stay stable: they are the keys used to compare a
+// run against a stored baseline.
+
+struct BenchResult {
+    std::string name;
+    double      value = 0.0;
+    std::string unit;
+    bool        higherIsBetter = false;
+};
+
+class BenchContext {
+public:
+    BenchContext(std::string filter, double minSeconds)
+        : m_filter(std::move(filter)), m_minSeconds(minSeconds) {}
+
+    // True if benchmarks under this name should run at all
+    bool selected(const std::string& name) const {
+        return m_filter.empty() || name.find(m_filter) != std::string::npos;
+    }
+
+    // Runs 'batch' (which does 'opsPerBatch' operations) repeatedly and
+    // returns the best observed nanoseconds per operation
+    template <class Fn>
+    double measure(uint64_t opsPerBatch, Fn&& batch) {
+        using Clock = std::chrono::steady_clock;
+        batch();  // warm-up: caches, page faults, branch predictors
+
+        double best = 0.0;
+        for (int round = 0; round < kRounds; ++round) {
+            uint64_t batches = 0;
+            auto start = Clock::now();
+            std::chrono::duration<double> elapsed{};
+            do {
+                batch();
+                ++batches;
+                elapsed = Clock::now() - start;
+            } while (elapsed.count() < m_minSeconds / kRounds);
+
+            double ns = elapsed.count() * 1e9 / static_cast<double>(batches * opsPerBatch);
+            if (round == 0 || ns < best) best = ns;
+        }
+        return best;
+    }
+
+    void report(const std::string& name, double value, const std::string& unit, bool higherIsBetter);
+    // A benchmark whose figure cannot be trusted (the code under test did
+    // the wrong thing): reported on stderr, and the run exits with 1
+    void fail(const std::string& name, const std::string& message);
+    size_t failures() const { return m_failures; }
+
+    const std::vector<BenchResult>& results() const { return m_results; }
+    double minSeconds() const { return m_minSeconds; }
+
+private:
+    static constexpr int kRounds = 3;
+
+    std::string              m_filter;
+    double                   m_minSeconds;
+    std::vector<BenchResult> m_results;
+    size_t                   m_failures = 0;
+};
+
+// Keeps the optimizer from discarding a computed value
+template <class T>
+inline void benchKeep(const T& value) {
+    static volatile T sink;
+    sink = value;
+    (void)sink;
+}
+
+// Benchmark groups, one per source file
+void benchRingBuffer(BenchContext& ctx);
+void benchKernels(BenchContext& ctx);
+void benchPipeline(BenchContext& ctx);
+void benchResampler(BenchContext& ctx);
+void benchContention(BenchContext& ctx);
+void benchFft(BenchContext& ctx);
+void benchDsp(BenchContext& ctx);
+void benchNegotiation(BenchContext& ctx);
+void benchFormatPlan(BenchContext& ctx);
+void benchClock(BenchContext& ctx);
+void benchVerify(BenchContext& ctx);
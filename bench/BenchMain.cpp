@@ -0,0 +1,164 @@
+// audiobridge_bench: microbenchmarks for the audio core.
+//
+//   audiobridge_bench [--filter <text>] [--time <seconds>]
+//                     [--json <out.json>] [--baseline <base.json>] [--tolerance <percent>]
+//
+// With --baseline every result is compared to the stored run; a result that
+// is worse by more than the tolerance (default 10%) is flagged and the exit
+// code is 1. So it is when a benchmark finds the code under test misbehaving.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include "Bench.h"
+
+void BenchContext::report(const std::string& name, double value, const std::string& unit,
+                          bool higherIsBetter) {
+    m_results.push_back({ name, value, unit, higherIsBetter });
+    std::printf("%-52s %12.2f %s\n", name.c_str(), value, unit.c_str());
+    std::fflush(stdout);
+}
+
+void BenchContext::fail(const std::string& name, const std::string& message) {
+    ++m_failures;
+    std::fprintf(stderr, "FAILED %s: %s\n", name.c_str(), message.c_str());
+    std::fflush(stderr);
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static bool writeJson(const char* path, const std::vector<BenchResult>& results) {
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"version\": 1,\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        std::fprintf(f, "    {\"name\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\"}%s\n",
+                     jsonEscape(r.name).c_str(), r.value, jsonEscape(r.unit).c_str(),
+                     r.higherIsBetter ? "higher" : "lower", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+// Reads the name/value pairs back from a file written by writeJson()
+static bool readJson(const char* path, std::map<std::string, double>& values) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+
+    size_t pos = 0;
+    while ((pos = text.find("\"name\":", pos)) != std::string::npos) {
+        size_t q1 = text.find('"', pos + 7);
+        if (q1 == std::string::npos) break;
+        size_t q2 = q1 + 1;
+        std::string name;
+        while (q2 < text.size() && text[q2] != '"') {
+            if (text[q2] == '\\' && q2 + 1 < text.size()) ++q2;
+            name += text[q2++];
+        }
+        size_t v = text.find("\"value\":", q2);
+        if (v == std::string::npos) break;
+        values[name] = std::strtod(text.c_str() + v + 8, nullptr);
+        pos = v;
+    }
+    return true;
+}
+
+static int compareWithBaseline(const std::vector<BenchResult>& results,
+                               const std::map<std::string, double>& baseline, double tolerance) {
+    int regressions = 0;
+    std::printf("\n%-52s %12s %12s %8s\n", "comparison", "baseline", "current", "change");
+    for (const BenchResult& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second == 0.0) continue;
+
+        // Positive change = improvement, whichever direction is better
+        double change = (r.value - it->second) / it->second * 100.0;
+        if (!r.higherIsBetter) change = -change;
+        bool regressed = change < -tolerance;
+        if (regressed) ++regressions;
+
+        std::printf("%-52s %12.2f %12.2f %+7.1f%%%s\n", r.name.c_str(), it->second, r.value,
+                    change, regressed ? "  REGRESSION" : "");
+    }
+    std::printf("\n%d regression(s) beyond %.0f%%\n", regressions, tolerance);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    double minSeconds = 0.3;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    double tolerance = 10.0;
+
+    for (int i = 1; i < argc; ++i) {
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", argv[i]);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (std::strcmp(argv[i], "--filter") == 0)         filter = next();
+        else if (std::strcmp(argv[i], "--time") == 0)      minSeconds = std::atof(next());
+        else if (std::strcmp(argv[i], "--json") == 0)      jsonPath = next();
+        else if (std::strcmp(argv[i], "--baseline") == 0)  baselinePath = next();
+        else if (std::strcmp(argv[i], "--tolerance") == 0) tolerance = std::atof(next());
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--filter <text>] [--time <seconds>] [--json <out.json>]\n"
+                         "          [--baseline <base.json>] [--tolerance <percent>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    BenchContext ctx(filter, minSeconds);
+    benchRingBuffer(ctx);
+    benchKernels(ctx);
+    benchPipeline(ctx);
+    benchResampler(ctx);
+    benchContention(ctx);
+    benchFft(ctx);
+    benchDsp(ctx);
+    benchNegotiation(ctx);
+    benchFormatPlan(ctx);
+    benchClock(ctx);
+    benchVerify(ctx);
+
+    // No figures from a broken run: they would end up in a baseline
+    if (ctx.failures() > 0) {
+        std::fprintf(stderr, "%zu benchmark(s) failed\n", ctx.failures());
+        return 1;
+    }
+
+    if (jsonPath && !writeJson(jsonPath, ctx.results())) {
+        std::fprintf(stderr, "cannot write %s\n", jsonPath);
+        return 2;
+    }
+
+    if (baselinePath) {
+        std::map<std::string, double> baseline;
+        if (!readJson(baselinePath, baseline)) {
+            std::fprintf(stderr, "cannot read %s\n", baselinePath);
+            return 2;
+        }
+        if (compareWithBaseline(ctx.results(), baseline, tolerance) > 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include "Bench.h"
+#include "ClockEstimator.h"
+
+// A device clock with a known error, observed once per 10 ms period for
+// 'seconds' with up to +-'jitterMs' of uniform timestamp jitter (a fixed
+// LCG, so every run sees the same timestamps)
+static void feedClock(ClockEstimator& clock, UINT32 nominalRate, double ppm,
+                      double seconds, double jitterMs, uint32_t seed) {
+    clock.reset(nominalRate);
+    const double rate = nominalRate * (1.0 + ppm * 1e-6);
+    const UINT64 periodFrames = nominalRate / 100;
+    const INT64 originNs = 1000000000;
+    uint32_t state = seed;
+    UINT64 position = 0;
+    while (static_cast<double>(position) / rate < seconds) {
+        position += periodFrames;
+        state = state * 1664525u + 1013904223u;
+        const double jitter = ((state >> 8) / 16777216.0 * 2.0 - 1.0) * jitterMs * 1e6;
+        const double trueNs = static_cast<double>(position) / rate * 1e9;
+        clock.observe(position, originNs + static_cast<INT64>(trueNs + jitter));
+    }
+}
+
+// Estimation accuracy on synthetic timestamps: capture 48 kHz at +50 ppm,
+// render 48 kHz at -30 ppm, 12 s of 10 ms periods with 1 ms of jitter. The
+// error figures are |estimate - truth| in ppm; the bound is what the
+// estimator claims for the ratio. The run fails when there is no estimate
+// or the ratio misses the truth by more than the bound. The cost is one
+// estimate() over a full window.
+void benchClock(BenchContext& ctx) {
+    const std::string errorName = "clock/ratio-error";
+    const std::string boundName = "clock/ratio-bound";
+    const std::string rateName = "clock/rate-error";
+    const std::string costName = "clock/estimate";
+    if (!ctx.selected(errorName) && !ctx.selected(boundName) &&
+        !ctx.selected(rateName) && !ctx.selected(costName)) return;
+
+    const double capturePpm = 50.0;
+    const double renderPpm = -30.0;
+    ClockEstimator capture;
+    ClockEstimator render;
+    feedClock(capture, 48000, capturePpm, 12.0, 1.0, 1);
+    feedClock(render, 48000, renderPpm, 12.0, 1.0, 2);
+
+    const ClockEstimate cap = capture.estimate();
+    const ClockEstimate ren = render.estimate();
+    const ClockRatio ratio = clockRatio(cap, ren);
+    const double truePpm = ((1.0 + capturePpm * 1e-6) / (1.0 + renderPpm * 1e-6) - 1.0) * 1e6;
+    if (!cap.valid || !ren.valid) {
+        ctx.fail(errorName, "no estimate from 12 s of timestamps");
+        return;
+    }
+    if (std::fabs(ratio.ppm - truePpm) > ratio.ppmBound) {
+        ctx.fail(errorName, "ratio off by more than its confidence bound");
+        return;
+    }
+
+    if (ctx.selected(errorName)) ctx.report(errorName, std::fabs(ratio.ppm - truePpm), "ppm", false);
+    if (ctx.selected(boundName)) ctx.report(boundName, ratio.ppmBound, "ppm", false);
+    if (ctx.selected(rateName))  ctx.report(rateName, std::fabs(cap.ppm - capturePpm), "ppm", false);
+
+    if (ctx.selected(costName)) {
+        const double ns = ctx.measure(1, [&] { benchKeep(capture.estimate().rateHz); });
+        ctx.report(costName, ns / 1000.0, "us", false);
+    }
+}
@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "RealtimeThread.h"
+#include "RingBuffer.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Producer and consumer on two different cores, passing fixed chunks through
+// an SPSC ring. Compares index layouts:
+//
+//   shared   head and tail on one cache line, reloaded on every call
+//   padded   head and tail on separate lines, reloaded on every call
+//   cached   separate lines, the other side's index cached locally and
+//            reloaded only when the ring looks full or empty
+//   ring     RingBuffer itself
+//
+// Per variant it reports ns per chunk, how often a side had to load the
+// other side's index per chunk (each such load that sees a new value is a
+// cache-line transfer) and, where the kernel exposes them, L1D read misses
+// per chunk counted on both threads.
+
+namespace {
+
+template <bool kPadded>
+struct alignas(kPadded ? 64 : alignof(size_t)) RingSide {
+    std::atomic<size_t> index{0};
+    size_t              cache = 0;      // last seen value of the other side's index
+    uint64_t            reloads = 0;    // loads of the other side's index
+};
+
+template <bool kPadded, bool kCached>
+class IndexRing {
+public:
+    explicit IndexRing(size_t capacity) : m_buffer(capacity), m_capacity(capacity) {}
+
+    size_t write(const uint8_t* src, size_t bytes) {
+        size_t h = m_sides.producer.index.load(std::memory_order_relaxed);
+        size_t space = m_capacity - 1 - used(h, m_sides.producer.cache);
+        if (!kCached || space < bytes) {
+            m_sides.producer.cache = m_sides.consumer.index.load(std::memory_order_acquire);
+            ++m_sides.producer.reloads;
+            space = m_capacity - 1 - used(h, m_sides.producer.cache);
+        }
+        size_t n = (std::min)(bytes, space);
+        if (n == 0) return 0;
+
+        size_t first = (std::min)(n, m_capacity - h);
+        std::memcpy(m_buffer.data() + h, src, first);
+        if (n > first) std::memcpy(m_buffer.data(), src + first, n - first);
+        m_sides.producer.index.store((h + n) % m_capacity, std::memory_order_release);
+        return n;
+    }
+
+    size_t read(uint8_t* dst, size_t bytes) {
+        size_t t = m_sides.consumer.index.load(std::memory_order_relaxed);
+        size_t avail = used(m_sides.consumer.cache, t);
+        if (!kCached || avail < bytes) {
+            m_sides.consumer.cache = m_sides.producer.index.load(std::memory_order_acquire);
+            ++m_sides.consumer.reloads;
+            avail = used(m_sides.consumer.cache, t);
+        }
+        size_t n = (std::min)(bytes, avail);
+        if (n == 0) return 0;
+
+        size_t first = (std::min)(n, m_capacity - t);
+        std::memcpy(dst, m_buffer.data() + t, first);
+        if (n > first) std::memcpy(dst + first, m_buffer.data(), n - first);
+        m_sides.consumer.index.store((t + n) % m_capacity, std::memory_order_release);
+        return n;
+    }
+
+    uint64_t reloads() const { return m_sides.producer.reloads + m_sides.consumer.reloads; }
+
+private:
+    size_t used(size_t h, size_t t) const {
+        return (h >= t) ? (h - t) : (m_capacity - t + h);
+    }
+
+    std::vector<uint8_t> m_buffer;
+    size_t               m_capacity;
+    struct alignas(64) Sides {
+        RingSide<kPadded> producer;
+        RingSide<kPadded> consumer;
+    } m_sides;
+};
+
+// RingBuffer keeps no reload counter
+struct PlainRing : RingBuffer {
+    using RingBuffer::RingBuffer;
+    uint64_t reloads() const { return 0; }
+};
+
+// Hardware L1D read misses of the calling thread, if the kernel allows it
+class MissCounter {
+public:
+    MissCounter() {
+#ifdef __linux__
+        perf_event_attr attr = {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~MissCounter() {
+#ifdef __linux__
+        if (m_fd >= 0) close(m_fd);
+#endif
+    }
+
+    bool valid() const { return m_fd >= 0; }
+
+    uint64_t value() const {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (m_fd >= 0 && ::read(m_fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+        return count;
+    }
+
+    MissCounter(const MissCounter&) = delete;
+    MissCounter& operator=(const MissCounter&) = delete;
+
+private:
+    int m_fd = -1;
+};
+
+struct PairResult {
+    double   seconds = 0.0;
+    uint64_t reloads = 0;
+    uint64_t misses = 0;
+    bool     missesValid = false;
+};
+
+// Spins briefly, then gives the core away: on a single core the other side
+// cannot make progress while we spin
+inline void backoff(unsigned& spins) {
+    if (++spins < 64) return;
+    spins = 0;
+    std::this_thread::yield();
+}
+
+RealtimePolicy pinTo(int cpu) {
+    RealtimePolicy policy;
+    policy.realtime = false;
+    policy.flushDenormals = false;
+    policy.cpuMask = (cpu >= 0 && cpu < 64) ? (1ull << cpu) : 0;
+    return policy;
+}
+
+template <class Ring>
+PairResult runPair(size_t capacity, size_t chunk, uint64_t ops, int producerCpu, int consumerCpu) {
+    Ring ring(capacity);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<int> counted{0};
+
+    auto side = [&](bool producer) {
+        RealtimeThreadScope pin(pinTo(producer ? producerCpu : consumerCpu), ThreadRole::Worker);
+        std::vector<uint8_t> data(chunk, producer ? 0x5a : 0);
+        MissCounter counter;
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+        uint64_t start = counter.value();
+        unsigned spins = 0;
+        for (uint64_t i = 0; i < ops; ++i) {
+            size_t done = 0;
+            while (done < chunk) {
+                size_t n = producer ? ring.write(data.data() + done, chunk - done)
+                                    : ring.read(data.data() + done, chunk - done);
+                if (n == 0) backoff(spins);
+                done += n;
+            }
+        }
+        if (counter.valid()) {
+            misses.fetch_add(counter.value() - start);
+            counted.fetch_add(1);
+        }
+        benchKeep(data[0]);
+    };
+
+    std::thread producer(side, true);
+    std::thread consumer(side, false);
+    while (ready.load() < 2) std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    producer.join();
+    consumer.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    PairResult r;
+    r.seconds = elapsed.count();
+    r.reloads = ring.reloads();
+    r.misses = misses.load();
+    r.missesValid = counted.load() == 2;
+    return r;
+}
+
+template <class Ring>
+void runVariant(BenchContext& ctx, const std::string& variant, size_t chunk,
+                int producerCpu, int consumerCpu, bool countReloads) {
+    const std::string name = "contention/" + variant + "/chunk=" + std::to_string(chunk);
+    if (!ctx.selected(name)) return;
+
+    const size_t capacity = 16384 + 7;   // odd size, so chunks straddle the wrap
+
+    // Size the run from a short calibration, then keep the best of three
+    const uint64_t calibrationOps = 20000;
+    PairResult cal = runPair<Ring>(capacity, chunk, calibrationOps, producerCpu, consumerCpu);
+    double perOp = (std::max)(cal.seconds / calibrationOps, 1e-9);
+    uint64_t ops = static_cast<uint64_t>(ctx.minSeconds() / 3.0 / perOp);
+    ops = (std::min)((std::max)(ops, calibrationOps), uint64_t(50000000));
+
+    PairResult best;
+    for (int round = 0; round < 3; ++round) {
+        PairResult r = runPair<Ring>(capacity, chunk, ops, producerCpu, consumerCpu);
+        if (round == 0 || r.seconds < best.seconds) best = r;
+    }
+
+    const double n = static_cast<double>(ops);
+    ctx.report(name, best.seconds * 1e9 / n, "ns/op", false);
+    if (countReloads)
+        ctx.report(name + "/reloads", static_cast<double>(best.reloads) / n, "loads/op", false);
+    if (best.missesValid)
+        ctx.report(name + "/l1d_misses", static_cast<double>(best.misses) / n, "misses/op", false);
+}
+
+} // namespace
+
+void benchContention(BenchContext& ctx) {
+    // Two distinct cores when there are any; on a single core the threads
+    // share it and the figures mostly measure context switches
+    const unsigned cores = std::thread::hardware_concurrency();
+    const int producerCpu = cores >= 2 ? 0 : -1;
+    const int consumerCpu = cores >= 2 ? 1 : -1;
+    if (cores < 2 && ctx.selected("contention/"))
+        std::printf("contention: single core, producer and consumer are not separated\n");
+
+    const size_t chunks[] = { 64, 1024 };
+    for (size_t chunk : chunks) {
+        runVariant<IndexRing<false, false>>(ctx, "shared", chunk, producerCpu, consumerCpu, true);
+        runVariant<IndexRing<true,  false>>(ctx, "padded", chunk, producerCpu, consumerCpu, true);
+        runVariant<IndexRing<true,  true>>(ctx,  "cached", chunk, producerCpu, consumerCpu, true);
+        runVariant<PlainRing>(ctx,               "ring",   chunk, producerCpu, consumerCpu, false);
+    }
+}
@@ -0,0 +1,86 @@
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "DspChain.h"
+
+// Insert chain cost per stage, in ns per frame over a 10 ms block at
+// 48 kHz. Each figure is a chain of just that stage, so it includes the
+// conversion to padded float and back; eq4 is a cascade of four sections.
+// Every batch starts from a fresh copy of the test block (included in the
+// figure) so that repeated in-place gain or filtering cannot drift into
+// denormals or clipping. params/poll is what an idle live-parameter queue
+// costs the render thread per period.
+void benchDsp(BenchContext& ctx) {
+    auto eq = [](BiquadType type, float hz, float q, float db) {
+        DspStageConfig s;
+        s.type = DspStageType::Eq;
+        s.filter = type;
+        s.frequencyHz = hz;
+        s.q = q;
+        s.gainDb = db;
+        return s;
+    };
+    DspStageConfig gain;
+    gain.type = DspStageType::Gain;
+    gain.gainDb = -3.0f;
+    DspStageConfig dcblock;
+    dcblock.type = DspStageType::DcBlock;
+    dcblock.frequencyHz = 10.0f;
+    DspStageConfig gate;
+    gate.type = DspStageType::Gate;
+    gate.thresholdDb = -50.0f;
+
+    struct Case {
+        std::string                 name;
+        std::vector<DspStageConfig> stages;
+    };
+    const std::vector<Case> cases = {
+        { "gain",    { gain } },
+        { "eq",      { eq(BiquadType::Peak, 1000.0f, 1.0f, 3.0f) } },
+        { "eq4",     { eq(BiquadType::HighPass, 40.0f, 0.7f, 0.0f), eq(BiquadType::Peak, 1000.0f, 1.0f, 3.0f),
+                       eq(BiquadType::Notch, 19000.0f, 8.0f, 0.0f), eq(BiquadType::HighShelf, 8000.0f, 0.7f, -2.0f) } },
+        { "dcblock", { dcblock } },
+        { "gate",    { gate } },
+    };
+
+    const uint32_t frames = 480;
+    for (uint16_t channels : { 2, 8 }) {
+        for (SampleType type : { SampleType::Float32, SampleType::Int16 }) {
+            AudioFormat format = makeAudioFormat(48000, channels, type);
+            std::vector<float> source(static_cast<size_t>(frames) * channels);
+            for (size_t i = 0; i < source.size(); ++i)
+                source[i] = 0.5f * std::sin(static_cast<float>(i / channels) * 0.05f);
+            std::vector<uint8_t> input(static_cast<size_t>(frames) * format.blockAlign());
+            samplesFromFloat(type, source.data(), input.data(), source.size());
+            std::vector<uint8_t> block(input.size());
+
+            const std::string suffix = std::string("/") + std::to_string(channels) + "ch"
+                                     + (type == SampleType::Float32 ? "_f32" : "_s16");
+            for (const Case& c : cases) {
+                const std::string name = "dsp/" + c.name + suffix;
+                if (!ctx.selected(name)) continue;
+
+                DspChain chain;
+                chain.init(format, c.stages);
+                double ns = ctx.measure(frames, [&] {
+                    std::memcpy(block.data(), input.data(), block.size());
+                    chain.process(block.data(), frames);
+                    benchKeep(block[1]);
+                });
+                ctx.report(name, ns, "ns/frame", false);
+            }
+        }
+    }
+
+    const std::string pollName = "params/poll";
+    if (ctx.selected(pollName)) {
+        ParamQueue params;
+        ParamCommand command;
+        double ns = ctx.measure(1, [&] {
+            benchKeep(params.poll(command));
+        });
+        ctx.report(pollName, ns, "ns/period", false);
+    }
+}
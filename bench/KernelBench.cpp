@@ -0,0 +1,82 @@
+#include <cmath>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "AudioKernels.h"
+#include "SampleFormat.h"
+
+static const char* typeName(SampleType t) {
+    switch (t) {
+        case SampleType::Int16:   return "s16";
+        case SampleType::Int24:   return "s24";
+        case SampleType::Int32:   return "s32";
+        case SampleType::Float32: return "f32";
+        default:                  return "unknown";
+    }
+}
+
+// Format conversion and block kernels, in ns per sample over a 10 ms
+// stereo block at 48 kHz.
+void benchKernels(BenchContext& ctx) {
+    const size_t samples = 960;
+    const SampleType types[] = { SampleType::Int16, SampleType::Int24,
+                                 SampleType::Int32, SampleType::Float32 };
+
+    std::vector<float> floats(samples);
+    for (size_t i = 0; i < samples; ++i)
+        floats[i] = 0.5f * std::sin(static_cast<float>(i) * 0.05f);
+
+    for (SampleType t : types) {
+        std::vector<uint8_t> raw(samples * bytesPerSample(t));
+        samplesFromFloat(t, floats.data(), raw.data(), samples);
+        std::vector<float> back(samples);
+        const std::string suffix = typeName(t);
+
+        std::string name = "kernel/to_float/" + suffix;
+        if (ctx.selected(name)) {
+            double ns = ctx.measure(samples, [&] {
+                samplesToFloat(t, raw.data(), back.data(), samples);
+                benchKeep(back[1]);
+            });
+            ctx.report(name, ns, "ns/sample", false);
+        }
+
+        name = "kernel/from_float/" + suffix;
+        if (ctx.selected(name)) {
+            double ns = ctx.measure(samples, [&] {
+                samplesFromFloat(t, floats.data(), raw.data(), samples);
+                benchKeep(raw[1]);
+            });
+            ctx.report(name, ns, "ns/sample", false);
+        }
+
+        name = "kernel/peak/" + suffix;
+        if (ctx.selected(name)) {
+            double ns = ctx.measure(samples, [&] {
+                benchKeep(peakAbs(t, raw.data(), samples));
+            });
+            ctx.report(name, ns, "ns/sample", false);
+        }
+
+        name = "kernel/levels/" + suffix;
+        if (ctx.selected(name)) {
+            float peak[2] = {}, sumSquares[2] = {};
+            uint32_t clips[2] = {};
+            double ns = ctx.measure(samples, [&] {
+                benchKeep(accumulateLevels(t, raw.data(), static_cast<uint32_t>(samples / 2), 2,
+                                           peak, sumSquares, clips));
+            });
+            ctx.report(name, ns, "ns/sample", false);
+        }
+
+        name = "kernel/ramp/" + suffix;
+        if (ctx.selected(name)) {
+            std::vector<uint8_t> out(raw.size());
+            double ns = ctx.measure(samples, [&] {
+                applyRamp(t, raw.data(), out.data(), static_cast<uint32_t>(samples / 2), 2, 0.0f, 1.0f);
+                benchKeep(out[1]);
+            });
+            ctx.report(name, ns, "ns/sample", false);
+        }
+    }
+}
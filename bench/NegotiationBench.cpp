@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include "Bench.h"
+#include "FormatCache.h"
+#include "FormatPlanner.h"
+#include "MockDeviceCaps.h"
+
+// Exclusive-mode startup against a mock driver that only takes the last
+// stereo candidate (44.1 kHz 16-bit) and wants 64-frame aligned periods:
+// the full candidate walk, and the same start with the result cached. The
+// figures are simulated driver time in ms (MockDeviceCaps' default costs),
+// not time spent in the negotiation code itself.
+void benchNegotiation(BenchContext& ctx) {
+    const std::string coldName = "negotiate/cold";
+    const std::string cachedName = "negotiate/cached";
+    if (!ctx.selected(coldName) && !ctx.selected(cachedName)) return;
+
+    MockDeviceCaps caps;
+    AudioFormat format = makeAudioFormat(44100, 2, SampleType::Int16);
+    caps.supported.push_back(format);
+    caps.alignFrames = 64;
+
+    const std::string path = (std::filesystem::temp_directory_path() / "audiobridge_bench_formats.ini").string();
+    std::remove(path.c_str());
+    const std::string key = formatCacheKey("render", "{mock}", nullptr);
+    const std::vector<AudioFormat> candidates = exclusiveCandidates();
+
+    NegotiatedFormat result;
+    NegotiationReport report;
+    HRESULT hr = negotiateCached(caps, candidates, path, key, result, &report);
+    const double coldMs = caps.simulatedMs();
+    if (FAILED(hr)) {
+        std::remove(path.c_str());
+        ctx.fail(coldName, "negotiation failed");
+        return;
+    }
+
+    caps.reactivate();
+    caps.resetCounters();
+    NegotiatedFormat cached;
+    hr = negotiateCached(caps, candidates, path, key, cached, &report);
+    const double cachedMs = caps.simulatedMs();
+    std::remove(path.c_str());
+    if (FAILED(hr)) {
+        ctx.fail(cachedName, "negotiation failed on the second start");
+        return;
+    }
+    if (!report.cacheHit) {
+        ctx.fail(cachedName, "second start missed the cache");
+        return;
+    }
+    if (cached.format != result.format || cached.period != result.period) {
+        ctx.fail(cachedName, "second start opened a different format or period");
+        return;
+    }
+
+    if (ctx.selected(coldName))   ctx.report(coldName, coldMs, "ms", false);
+    if (ctx.selected(cachedName)) ctx.report(cachedName, cachedMs, "ms", false);
+}
+
+// A capture device that prefers 48 kHz float but also takes 44.1 kHz 16-bit,
+// against a render device that only takes 44.1 kHz 16-bit: the conversion
+// cost (FormatPlanner's units, 100 = resampling) when each device negotiates
+// on its own, and when both are planned together.
+void benchFormatPlan(BenchContext& ctx) {
+    const std::string greedyName = "negotiate/separate-cost";
+    const std::string planName = "negotiate/planned-cost";
+    if (!ctx.selected(greedyName) && !ctx.selected(planName)) return;
+
+    MockDeviceCaps capture, render;
+    capture.supported.push_back(makeAudioFormat(48000, 2, SampleType::Float32));
+    capture.supported.push_back(makeAudioFormat(44100, 2, SampleType::Int16));
+    render.supported.push_back(makeAudioFormat(44100, 2, SampleType::Int16));
+
+    const std::vector<AudioFormat> candidates = exclusiveCandidates();
+    NegotiatedFormat captureAlone, renderAlone;
+    negotiateExclusiveFormat(capture, candidates, nullptr, captureAlone, nullptr);
+    negotiateExclusiveFormat(render, exclusiveCandidates(&captureAlone.format), nullptr, renderAlone, nullptr);
+
+    FormatPlan plan;
+    planExclusiveRoute(capture, render, "{capture}", "{render}", std::string(), plan);
+
+    if (ctx.selected(greedyName))
+        ctx.report(greedyName, conversionCost(captureAlone.format, renderAlone.format), "cost", false);
+    if (ctx.selected(planName)) ctx.report(planName, plan.cost, "cost", false);
+}
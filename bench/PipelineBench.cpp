@@ -0,0 +1,129 @@
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "AudioEndpoint.h"
+#include "MappedFile.h"
+#include "WavFile.h"
+
+// Endpoints without a thread of their own: the benchmark drives one capture
+// packet and one render period per operation, as fast as possible, through
+// the same deliver()/pull() path the device backends use.
+class BenchCapture : public CaptureEndpoint {
+public:
+    void init(const AudioFormat& format, RingBuffer* ring, bool gate) {
+        m_format = format;
+        setRingBuffer(ring);
+        setGateOptions(gate, -90.0f, 10);
+        initPipeline();
+    }
+    HRESULT start() override { return S_OK; }
+    void    stop() override {}
+
+    using CaptureEndpoint::deliver;
+};
+
+class BenchRender : public RenderEndpoint {
+public:
+    void init(const AudioFormat& format, RingBuffer* ring) {
+        m_format = format;
+        setRingBuffer(ring);
+        initPipeline();
+        resetPipeline();
+    }
+    HRESULT start() override { return S_OK; }
+    void    stop() override {}
+
+    using RenderEndpoint::pull;
+};
+
+static void runPipeline(BenchContext& ctx, const std::string& name, SampleType type,
+                        bool tone, bool toFile) {
+    if (!ctx.selected(name)) return;
+
+    const AudioFormat format = makeAudioFormat(48000, 2, type);
+    const uint32_t frames = 480;
+    const size_t bytes = static_cast<size_t>(frames) * format.blockAlign();
+
+    std::vector<float> floats(static_cast<size_t>(frames) * 2, 0.0f);
+    if (tone) {
+        for (uint32_t i = 0; i < frames; ++i)
+            floats[2 * i] = floats[2 * i + 1] = 0.1f * std::sin(static_cast<float>(i) * 0.0576f);
+    }
+    std::vector<uint8_t> packet(bytes), period(bytes);
+    samplesFromFloat(type, floats.data(), packet.data(), floats.size());
+
+    RingBuffer ring(48000 * 8 / 2);
+    BenchCapture capture;
+    BenchRender render;
+    capture.init(format, &ring, true);
+    render.init(format, &ring);
+
+    const uint64_t ops = 100;
+
+    // Same as the WAV render backend: periods are rendered straight into a
+    // mapped file, and silent ones are zeroed there
+    MappedFile sink;
+    const std::string sinkPath =
+        (std::filesystem::temp_directory_path() / "audiobridge_bench.wav").string();
+    if (toFile) {
+        if (FAILED(sink.create(sinkPath, kWav64HeaderBytes + ops * bytes))) return;
+        buildWav64Header(sink.data(), format, ops * bytes);
+    }
+
+    double ns = ctx.measure(ops * frames, [&] {
+        for (uint64_t i = 0; i < ops; ++i) {
+            capture.deliver(packet.data(), frames);
+            uint8_t* target = toFile ? sink.data() + kWav64HeaderBytes + i * bytes : period.data();
+            bool silent = render.pull(target, frames);
+            if (toFile && silent) std::memset(target, 0, bytes);
+            benchKeep(target[0]);
+        }
+    });
+    if (toFile) {
+        sink.close();
+        std::error_code ec;
+        std::filesystem::remove(sinkPath, ec);
+    }
+
+    ctx.report(name, ns, "ns/frame", false);
+}
+
+// Render side alone with the ring always empty: the concealment path
+static void runUnderrun(BenchContext& ctx) {
+    const std::string name = "pipeline/underrun/f32";
+    if (!ctx.selected(name)) return;
+
+    const AudioFormat format = makeAudioFormat(48000, 2, SampleType::Float32);
+    const uint32_t frames = 480;
+    RingBuffer ring(48000 * 8 / 2);
+    BenchRender render;
+    render.init(format, &ring);
+    std::vector<uint8_t> period(static_cast<size_t>(frames) * format.blockAlign());
+
+    // Give the concealer some history to repeat
+    std::vector<float> tone(static_cast<size_t>(frames) * 2);
+    for (uint32_t i = 0; i < frames; ++i)
+        tone[2 * i] = tone[2 * i + 1] = 0.1f * std::sin(static_cast<float>(i) * 0.0576f);
+
+    const uint64_t ops = 100;
+    double ns = ctx.measure(ops * frames, [&] {
+        for (uint64_t i = 0; i < ops; ++i) {
+            if (i % 10 == 0) ring.write(tone.data(), tone.size() * sizeof(float));
+            render.pull(period.data(), frames);
+        }
+        benchKeep(period[0]);
+    });
+    ctx.report(name, ns, "ns/frame", false);
+}
+
+void benchPipeline(BenchContext& ctx) {
+    runPipeline(ctx, "pipeline/null/f32",    SampleType::Float32, true,  false);
+    runPipeline(ctx, "pipeline/null/s16",    SampleType::Int16,   true,  false);
+    runPipeline(ctx, "pipeline/null/silent", SampleType::Float32, false, false);
+    runPipeline(ctx, "pipeline/file/f32",    SampleType::Float32, true,  true);
+    runPipeline(ctx, "pipeline/file/s16",    SampleType::Int16,   true,  true);
+    runUnderrun(ctx);
+}
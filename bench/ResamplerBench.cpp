@@ -0,0 +1,59 @@
+#include <cmath>
+#include <string>
+#include <vector>
+#include "Bench.h"
+
+#ifdef _WIN32
+#include <mfapi.h>
+#include "AudioResampler.h"
+#include "SampleFormat.h"
+
+// MF resampler cost in ns per input frame, per conversion and filter length.
+void benchResampler(BenchContext& ctx) {
+    const struct { uint32_t from, to; } ratios[] = {
+        { 44100, 48000 }, { 48000, 44100 }, { 48000, 96000 }, { 96000, 48000 },
+    };
+    const int qualities[] = { 15, 30, 60 };
+
+    CoInitializeGuard comGuard(COINIT_MULTITHREADED);
+    if (FAILED(MFStartup(MF_VERSION))) return;
+
+    for (auto& r : ratios) {
+        for (int q : qualities) {
+            std::string name = "resampler/" + std::to_string(r.from) + "to" + std::to_string(r.to)
+                             + "/q" + std::to_string(q);
+            if (!ctx.selected(name)) continue;
+
+            WAVEFORMATEXTENSIBLE in  = waveFormatFromAudio(makeAudioFormat(r.from, 2, SampleType::Float32));
+            WAVEFORMATEXTENSIBLE out = waveFormatFromAudio(makeAudioFormat(r.to, 2, SampleType::Float32));
+
+            const uint32_t frames = 512;     // 4 KB of stereo float, the router's chunk
+            std::vector<float> block(static_cast<size_t>(frames) * 2);
+            for (uint32_t i = 0; i < frames; ++i)
+                block[2 * i] = block[2 * i + 1] = 0.1f * std::sin(static_cast<float>(i) * 0.05f);
+            const DWORD bytes = static_cast<DWORD>(block.size() * sizeof(float));
+
+            AudioResampler resampler;
+            resampler.setQuality(q);
+            if (FAILED(resampler.init(&in.Format, &out.Format, bytes))) continue;
+
+            ArenaVector<BYTE> outBuf;
+            outBuf.reserve(bytes * 4);
+            const uint64_t ops = 20;
+            double ns = ctx.measure(ops * frames, [&] {
+                for (uint64_t i = 0; i < ops; ++i) {
+                    outBuf.clear();
+                    resampler.process(reinterpret_cast<const BYTE*>(block.data()), bytes, outBuf);
+                }
+                benchKeep(outBuf.size());
+            });
+            ctx.report(name, ns, "ns/frame", false);
+        }
+    }
+
+    MFShutdown();
+}
+#else
+// The resampler is the Media Foundation DSP, which only exists on Windows
+void benchResampler(BenchContext&) {}
+#endif
@@ -0,0 +1,56 @@
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "RingBuffer.h"
+
+// Single-threaded write/read round trips: measures the copy and index
+// arithmetic, not cross-core traffic.
+void benchRingBuffer(BenchContext& ctx) {
+    const size_t chunks[] = { 64, 256, 1024, 4096, 16384 };
+
+    for (size_t chunk : chunks) {
+        // 'rare': a large ring that wraps once every many calls.
+        // 'often': a ring of about four chunks with an odd size, so most
+        // wraps split a chunk into two copies.
+        const struct { const char* name; size_t capacity; } shapes[] = {
+            { "rare",  1u << 20 },
+            { "often", chunk * 4 + 7 },
+        };
+
+        for (auto& shape : shapes) {
+            std::string name = "ring/copy/chunk=" + std::to_string(chunk) + "/wrap=" + shape.name;
+            if (!ctx.selected(name)) continue;
+
+            RingBuffer ring(shape.capacity);
+            std::vector<uint8_t> src(chunk, 0x5a), dst(chunk);
+            const uint64_t ops = 1024;
+
+            double ns = ctx.measure(ops, [&] {
+                for (uint64_t i = 0; i < ops; ++i) {
+                    ring.write(src.data(), chunk);
+                    ring.read(dst.data(), chunk);
+                }
+                benchKeep(dst[0]);
+            });
+            ctx.report(name, static_cast<double>(chunk) / ns * 1e3, "MB/s", true);
+        }
+    }
+
+    // Silence markers: queueing and skipping a run without touching data
+    {
+        const std::string name = "ring/silence/chunk=4096";
+        if (ctx.selected(name)) {
+            RingBuffer ring(1u << 20);
+            const uint64_t ops = 1024;
+            double ns = ctx.measure(ops, [&] {
+                for (uint64_t i = 0; i < ops; ++i) {
+                    ring.writeSilence(4096);
+                    bool silent = false;
+                    size_t run = ring.nextRun(silent);
+                    ring.skip(run);
+                }
+            });
+            ctx.report(name, ns, "ns/op", false);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "PassthroughVerifier.h"
+#include "RingBuffer.h"
+
+// One 10 ms period of 48 kHz stereo float through the capture ring, written
+// and read back on one thread: plain, and through the passthrough verifier.
+// The difference is what verification adds to both period threads together.
+void benchVerify(BenchContext& ctx) {
+    const std::string plainName = "verify/period/plain";
+    const std::string checkedName = "verify/period/checked";
+    if (!ctx.selected(plainName) && !ctx.selected(checkedName)) return;
+
+    const size_t period = 480 * 8;
+    std::vector<uint8_t> src(period), dst(period);
+    for (size_t i = 0; i < period; ++i) src[i] = static_cast<uint8_t>(i * 31 + 7);
+    const uint64_t ops = 256;
+
+    if (ctx.selected(plainName)) {
+        RingBuffer ring(period * 4 + 7);
+        double ns = ctx.measure(ops, [&] {
+            for (uint64_t i = 0; i < ops; ++i) {
+                ring.write(src.data(), period);
+                ring.read(dst.data(), period);
+            }
+            benchKeep(dst[0]);
+        });
+        ctx.report(plainName, ns, "ns/period", false);
+    }
+
+    if (ctx.selected(checkedName)) {
+        AudioArena arena;
+        RingBuffer ring(period * 4 + 7, &arena);
+        PassthroughVerifier verifier;
+        verifier.init(&arena, 1);
+        double ns = ctx.measure(ops, [&] {
+            for (uint64_t i = 0; i < ops; ++i) {
+                verifier.write(ring, src.data(), period);
+                size_t n = ring.read(dst.data(), period);
+                verifier.check(dst.data(), n);
+            }
+            benchKeep(dst[0]);
+        });
+        // Clean passthrough flagged as faulty: the verifier is broken and
+        // the figure means nothing
+        const VerifyStats stats = verifier.stats();
+        if (stats.dropped + stats.duplicated + stats.corrupted > 0) {
+            ctx.fail(checkedName, "faults reported on clean passthrough");
+            return;
+        }
+        ctx.report(checkedName, ns, "ns/period", false);
+    }
+}
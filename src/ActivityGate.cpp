@@ -0,0 +1,96 @@
+#include "ActivityGate.h"
+#include "AudioKernels.h"
+#include <algorithm>
+#include <cmath>
+
+void ActivityGate::init(const AudioFormat& format, bool enabled, float thresholdDb,
+                        uint32_t holdMs, AudioArena* arena, uint32_t fadeMs) {
+    m_format = format;
+    m_blockAlign = format.blockAlign();
+    m_enabled = enabled && format.isValid();
+    m_threshold = std::pow(10.0f, thresholdDb / 20.0f);
+    m_holdFrames = static_cast<uint32_t>(static_cast<uint64_t>(format.sampleRate) * holdMs / 1000);
+    m_fadeFrames = (std::max)(format.sampleRate * fadeMs / 1000, 1u);
+    m_scratch = ArenaVector<uint8_t>(static_cast<size_t>(m_fadeFrames) * m_blockAlign, 0,
+                                     ArenaAllocator<uint8_t>(arena));
+    m_belowFrames = 0;
+    m_fadeInPos = 0;
+    m_state.store(GateState::Active, std::memory_order_relaxed);
+}
+
+void ActivityGate::writeFaded(RingBuffer& ring, const uint8_t* data, uint32_t frames, bool fadeIn) {
+    uint32_t n = fadeIn ? (std::min)(m_fadeInPos, frames) : (std::min)(m_fadeFrames, frames);
+    float g0, g1;
+    if (fadeIn) {
+        g0 = 1.0f - static_cast<float>(m_fadeInPos) / m_fadeFrames;
+        g1 = 1.0f - static_cast<float>(m_fadeInPos - n) / m_fadeFrames;
+        m_fadeInPos -= n;
+    } else {
+        g0 = 1.0f;
+        g1 = 1.0f - static_cast<float>(n) / m_fadeFrames;
+    }
+
+    applyRamp(m_format.type, data, m_scratch.data(), n, m_format.channels, g0, g1);
+    ring.write(m_scratch.data(), static_cast<size_t>(n) * m_blockAlign);
+
+    size_t rest = static_cast<size_t>(frames - n) * m_blockAlign;
+    if (rest == 0) return;
+    if (fadeIn)
+        ring.write(data + static_cast<size_t>(n) * m_blockAlign, rest);
+    else
+        ring.writeSilence(rest);
+}
+
+void ActivityGate::write(RingBuffer& ring, const uint8_t* data, uint32_t frames) {
+    if (!m_enabled) {
+        ring.write(data, static_cast<size_t>(frames) * m_blockAlign);
+        return;
+    }
+    write(ring, data, frames, peakAbs(m_format.type, data, static_cast<size_t>(frames) * m_format.channels));
+}
+
+void ActivityGate::write(RingBuffer& ring, const uint8_t* data, uint32_t frames, float peak) {
+    const size_t bytes = static_cast<size_t>(frames) * m_blockAlign;
+    if (!m_enabled) {
+        ring.write(data, bytes);
+        return;
+    }
+
+    GateState st = m_state.load(std::memory_order_relaxed);
+
+    if (peak >= m_threshold) {
+        m_belowFrames = 0;
+        if (st == GateState::Idle) m_fadeInPos = m_fadeFrames;
+        m_state.store(GateState::Active, std::memory_order_relaxed);
+    } else if (st == GateState::Idle) {
+        ring.writeSilence(bytes);
+        return;
+    } else {
+        m_belowFrames += frames;
+        if (m_belowFrames >= m_holdFrames) {
+            // Hold time over: fade out at the start of this packet and go idle
+            m_state.store(GateState::Idle, std::memory_order_relaxed);
+            m_fadeInPos = 0;
+            writeFaded(ring, data, frames, false);
+            return;
+        }
+        m_state.store(GateState::Hold, std::memory_order_relaxed);
+    }
+
+    if (m_fadeInPos > 0)
+        writeFaded(ring, data, frames, true);
+    else
+        ring.write(data, bytes);
+}
+
+void ActivityGate::writeSilence(RingBuffer& ring, uint32_t frames) {
+    ring.writeSilence(static_cast<size_t>(frames) * m_blockAlign);
+    if (!m_enabled) return;
+
+    GateState st = m_state.load(std::memory_order_relaxed);
+    if (st == GateState::Idle) return;
+
+    m_belowFrames += frames;
+    m_state.store(m_belowFrames >= m_holdFrames ? GateState::Idle : GateState::Hold,
+                  std::memory_order_relaxed);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "SampleFormat.h"
+#include "RingBuffer.h"
+
+enum class GateState : uint8_t {
+    Active,     // signal above threshold
+    Hold,       // below threshold, still passing audio until the hold time ends
+    Idle        // input is forwarded as silence markers; downstream stages bypass
+};
+
+// Signal-activity gate at the head of the pipeline.
+//
+// Each capture packet is measured (vectorized block peak) against a threshold.
+// After the input has stayed below it for the hold time, the gate closes with
+// a short fade-out and further packets are queued as silence markers, which
+// the resampler and render stages skip without processing. The first packet
+// above threshold reopens the gate with a short fade-in.
+class ActivityGate {
+public:
+    void init(const AudioFormat& format, bool enabled, float thresholdDb,
+              uint32_t holdMs, AudioArena* arena = nullptr, uint32_t fadeMs = 5);
+
+    // Producer side: route a capture packet (or a silent packet) into the ring
+    void write(RingBuffer& ring, const uint8_t* data, uint32_t frames);
+    // Same, with the packet's peak already measured by the caller
+    void write(RingBuffer& ring, const uint8_t* data, uint32_t frames, float peak);
+    void writeSilence(RingBuffer& ring, uint32_t frames);
+
+    GateState state()   const { return m_state.load(std::memory_order_relaxed); }
+    bool      enabled() const { return m_enabled; }
+
+private:
+    void writeFaded(RingBuffer& ring, const uint8_t* data, uint32_t frames, bool fadeIn);
+
+    AudioFormat            m_format;
+    uint32_t               m_blockAlign = 0;
+    bool                   m_enabled = false;
+    float                  m_threshold = 0.0f;     // linear, full scale = 1.0
+    uint32_t               m_holdFrames = 0;
+    uint32_t               m_fadeFrames = 0;
+    uint32_t               m_belowFrames = 0;      // consecutive frames below threshold
+    uint32_t               m_fadeInPos = 0;        // frames of fade-in still to apply
+    ArenaVector<uint8_t>   m_scratch;              // fadeFrames of faded audio
+    std::atomic<GateState> m_state{GateState::Active};
+};
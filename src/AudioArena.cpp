@@ -0,0 +1,97 @@
+#include "AudioArena.h"
+#include <algorithm>
+#include <cstdint>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Chunks are at least this large so a route typically needs only a few
+static constexpr size_t kMinChunkBytes = 256 * 1024;
+
+static size_t pageSize() {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+#else
+    long ps = sysconf(_SC_PAGESIZE);
+    return ps > 0 ? static_cast<size_t>(ps) : 4096;
+#endif
+}
+
+void* AudioArena::allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!m_chunks.empty()) {
+            Chunk& c = m_chunks.back();
+            uintptr_t start = reinterpret_cast<uintptr_t>(c.base) + c.used;
+            uintptr_t aligned = (start + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+            size_t offset = static_cast<size_t>(aligned - reinterpret_cast<uintptr_t>(c.base));
+            if (offset + bytes <= c.size) {
+                m_usedBytes += offset + bytes - c.used;
+                c.used = offset + bytes;
+                return c.base + offset;
+            }
+        }
+        if (!addChunk(bytes + alignment)) break;
+    }
+    throw std::bad_alloc();
+}
+
+AudioArena::Chunk* AudioArena::addChunk(size_t minBytes) {
+    const size_t page = pageSize();
+    size_t size = (std::max)(minBytes, kMinChunkBytes);
+    size = (size + page - 1) / page * page;
+
+#ifdef _WIN32
+    void* p = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!p) return nullptr;
+#else
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+#endif
+    uint8_t* base = static_cast<uint8_t*>(p);
+
+    // Prefault: a write per page makes the OS back it now, not on the audio thread
+    for (size_t off = 0; off < size; off += page)
+        base[off] = 0;
+
+    bool locked = false;
+#ifdef _WIN32
+    locked = VirtualLock(base, size) != 0;
+    if (!locked) {
+        // The default working set minimum only allows a few locked pages
+        SIZE_T minWs = 0, maxWs = 0;
+        if (GetProcessWorkingSetSize(GetCurrentProcess(), &minWs, &maxWs) &&
+            SetProcessWorkingSetSize(GetCurrentProcess(), minWs + size, maxWs + size)) {
+            locked = VirtualLock(base, size) != 0;
+        }
+    }
+#else
+    locked = mlock(base, size) == 0;
+#endif
+
+    m_chunks.push_back({ base, size, 0, locked });
+    m_mappedBytes += size;
+    if (locked) m_lockedBytes += size;
+    return &m_chunks.back();
+}
+
+void AudioArena::release() {
+    for (auto& c : m_chunks) {
+#ifdef _WIN32
+        if (c.locked) VirtualUnlock(c.base, c.size);
+        VirtualFree(c.base, 0, MEM_RELEASE);
+#else
+        if (c.locked) munlock(c.base, c.size);
+        munmap(c.base, c.size);
+#endif
+    }
+    m_chunks.clear();
+    m_mappedBytes = 0;
+    m_lockedBytes = 0;
+    m_usedBytes = 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "Platform.h"
+
+// Memory for buffers that realtime threads touch.
+//
+// Memory is mapped in page-aligned chunks. Every page is written once
+// (prefaulted) and then locked in RAM (mlock / VirtualLock) when the chunk is
+// created, so the audio threads never take a page fault on these buffers.
+// Locking can be refused (RLIMIT_MEMLOCK, working set quota); the memory is
+// still prefaulted then, and lockedBytes() shows what was actually locked.
+//
+// Allocation is a bump pointer and individual blocks are never freed: fill
+// the arena while setting up a route and release() it after everything that
+// points into it is gone. Endpoints may be set up on two threads at once, so
+// allocate() takes a lock; the audio threads never allocate.
+class AudioArena {
+public:
+    AudioArena() = default;
+    ~AudioArena() { release(); }
+
+    // Throws std::bad_alloc if no memory could be mapped
+    void* allocate(size_t bytes, size_t alignment = 64);
+
+    // Unlocks and unmaps all chunks
+    void release();
+
+    size_t mappedBytes() const { return m_mappedBytes; }
+    size_t lockedBytes() const { return m_lockedBytes; }
+    size_t usedBytes()   const { return m_usedBytes; }
+
+    AudioArena(const AudioArena&) = delete;
+    AudioArena& operator=(const AudioArena&) = delete;
+
+private:
+    struct Chunk {
+        uint8_t* base;
+        size_t   size;
+        size_t   used;
+        bool     locked;
+    };
+
+    Chunk* addChunk(size_t minBytes);
+
+    std::mutex         m_mutex;
+    std::vector<Chunk> m_chunks;
+    size_t m_mappedBytes = 0;
+    size_t m_lockedBytes = 0;
+    size_t m_usedBytes = 0;
+};
+
+// std allocator that takes memory from an AudioArena, or from the heap when
+// no arena is set. Arena blocks are reclaimed with the arena, so deallocate
+// does nothing for them.
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    AudioArena* arena = nullptr;
+
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(AudioArena* a) noexcept : arena(a) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        if (arena) return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T) > 64 ? alignof(T) : 64));
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        if (!arena) std::allocator<T>().deallocate(p, n);
+    }
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
+
+// Vector for realtime-thread buffers. Size it during setup, e.g.
+//   m_buf = ArenaVector<float>(n, 0.0f, ArenaAllocator<float>(arena));
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,101 @@
+#include "AudioEndpoint.h"
+#include "StartupTrace.h"
+
+// ── Capture ───────────────────────────────────────────────────────
+
+void CaptureEndpoint::setGateOptions(bool enabled, float thresholdDb, UINT32 holdMs) {
+    m_gateEnabled = enabled;
+    m_gateThresholdDb = thresholdDb;
+    m_gateHoldMs = holdMs;
+}
+
+void CaptureEndpoint::initPipeline() {
+    m_gate.init(m_format, m_gateEnabled, m_gateThresholdDb, m_gateHoldMs, m_arena);
+    m_meter.init(m_format);
+}
+
+// ── Render ────────────────────────────────────────────────────────
+
+void RenderEndpoint::initPipeline() {
+    m_dsp.init(m_format, m_insertConfig, m_arena, m_outputGainDb, m_mute);
+    m_concealer.init(m_format, m_arena);
+    m_meter.init(m_format);
+}
+
+void RenderEndpoint::resetPipeline() {
+    // Counters and the first-period stamp run for the life of the endpoint,
+    // across a watchdog restart
+    m_drained.store(false, std::memory_order_relaxed);
+    m_dsp.reset();
+    m_concealer.reset();
+    m_meter.reset();
+}
+
+bool RenderEndpoint::pull(uint8_t* data, uint32_t frames) {
+    const size_t blockAlign = m_format.blockAlign();
+    const size_t bytesNeeded = static_cast<size_t>(frames) * blockAlign;
+
+    if (m_firstPeriodNs.load(std::memory_order_relaxed) == 0)
+        m_firstPeriodNs.store(startupClockNs(), std::memory_order_relaxed);
+    m_periods.fetch_add(1, std::memory_order_relaxed);
+
+    // Live parameter changes take effect at this period boundary
+    if (m_params) {
+        ParamCommand command;
+        while (m_params->poll(command)) {
+            m_dsp.apply(command);
+            m_params->retire(command.params);
+        }
+    }
+
+    // Past the end of a finite stream: silence, but not an underrun
+    if (m_ringBuffer->drained()) {
+        m_drained.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    // A whole period of queued silence: leave the buffer alone and let the
+    // backend signal silence (e.g. AUDCLNT_BUFFERFLAGS_SILENT)
+    bool silentRun = false;
+    size_t run = m_ringBuffer->nextRun(silentRun, bytesNeeded);
+    if (silentRun && run >= bytesNeeded && !m_concealer.isConcealing()) {
+        m_ringBuffer->skip(bytesNeeded);
+        if (m_verifier) m_verifier->checkSilence(bytesNeeded);
+        m_concealer.pushSilence();
+        m_meter.processSilence(frames);
+        if (m_recorder) m_recorder->pushSilence(frames);
+        if (m_analyzer) m_analyzer->pushSilence(frames);
+        return true;
+    }
+
+    size_t bytesRead = m_ringBuffer->read(data, bytesNeeded);
+    uint32_t framesRead = static_cast<uint32_t>(bytesRead / blockAlign);
+    // As read, before the inserts change anything
+    if (m_verifier) m_verifier->check(data, bytesRead);
+
+    // Before concealment, so a gap is bridged with processed audio
+    m_dsp.process(data, framesRead);
+
+    // Smooths the boundaries of any gap, and on underrun fills the
+    // remainder with concealment (fading to silence on long gaps)
+    bool silent = m_concealer.process(data, framesRead, frames);
+
+    if (bytesRead < bytesNeeded) {
+        m_underruns.fetch_add(1, std::memory_order_relaxed);
+        m_concealedFrames.store(m_concealer.concealedFrames(), std::memory_order_relaxed);
+    }
+
+    // Metered while the period is still in cache from the copy above
+    if (silent) m_meter.processSilence(frames);
+    else        m_meter.process(data, frames);
+
+    if (m_recorder) {
+        if (silent) m_recorder->pushSilence(frames);
+        else        m_recorder->push(data, frames);
+    }
+    if (m_analyzer) {
+        if (silent) m_analyzer->pushSilence(frames);
+        else        m_analyzer->push(data, frames);
+    }
+    return silent;
+}
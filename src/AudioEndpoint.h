@@ -0,0 +1,272 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include "Platform.h"
+#include "SampleFormat.h"
+#include "RingBuffer.h"
+#include "ActivityGate.h"
+#include "PacketConcealer.h"
+#include "RealtimeThread.h"
+#include "AudioRecorder.h"
+#include "DspChain.h"
+#include "LevelMeter.h"
+#include "SpectrumAnalyzer.h"
+#include "ClockEstimator.h"
+#include "PassthroughVerifier.h"
+
+// Backends a route endpoint can be bound to.
+enum class EndpointBackend {
+    Wasapi,     // Windows audio device (device ID)
+    File,       // WAV file (path)
+    Null,       // no device: capture generates silence or a test tone, render discards
+    Rtp,        // RTP over UDP ("host:port"): capture receives, render sends
+    SharedMemory    // named shared-memory ring to another process
+};
+
+// RTP backend settings.
+struct RtpOptions {
+    UINT32 payloadType    = 96;     // dynamic payload type announced by the sender
+    UINT32 jitterMinMs    = 10;     // receive buffer target bounds
+    UINT32 jitterMaxMs    = 200;
+    // Sender-side impairments for testing: share of packets dropped, and
+    // share sent after the packet that follows them
+    float  lossPercent    = 0.0f;
+    float  reorderPercent = 0.0f;
+};
+
+// Counters of the network and shared-memory backends; empty for the others.
+struct TransportStats {
+    const char* transport = nullptr;    // "rtp", "shm"; null for device and file backends
+    UINT64 packets   = 0;   // rtp: sent or received
+    UINT64 lost      = 0;   // rtp receive: missing when due (concealed); send: dropped on purpose
+    UINT64 late      = 0;   // rtp receive: arrived after being concealed
+    UINT64 reordered = 0;   // rtp send: held back on purpose
+    UINT64 skipped   = 0;   // rtp receive: dropped to shrink the buffer (sender clock fast)
+    UINT64 inserted  = 0;   // rtp receive: concealed to grow the buffer (sender clock slow)
+    UINT64 position  = 0;   // shm: frames the producer has written
+    UINT64 droppedFrames = 0;   // shm send: the reader did not keep up
+    float  jitterMs  = 0.0f;    // rtp receive: interarrival jitter (RFC 3550)
+    float  bufferMs  = 0.0f;    // receive buffer or shared ring fill
+    float  targetMs  = 0.0f;    // rtp receive: buffer target
+};
+
+// How a route endpoint is opened. Which fields apply depends on the backend.
+struct EndpointConfig {
+    EndpointBackend backend   = EndpointBackend::Wasapi;
+    std::string     device;             // WASAPI device ID, file path (UTF-8), RTP host:port or segment name
+    bool            exclusive = false;  // WASAPI exclusive mode
+    AudioFormat     format;             // Null/File: stream format (unset = follow capture)
+    float           toneHz    = 0.0f;   // Null capture: test tone frequency, 0 = silence
+    bool            loop      = true;   // File capture: restart at end of file
+    bool            paced     = true;   // Null/File: real-time rate, or as fast as the other side allows
+    RtpOptions      rtp;
+    UINT32          bufferMs  = 100;    // Shared memory: ring length when creating the segment
+};
+
+// Common part of all capture backends.
+//
+// Backends hand every packet to deliver() or deliverSilence(); the activity
+// gate then decides what goes into the ring buffer.
+class CaptureEndpoint {
+public:
+    virtual ~CaptureEndpoint() = default;
+
+    virtual HRESULT start() = 0;
+    virtual void    stop() = 0;
+
+    void setRingBuffer(RingBuffer* rb) { m_ringBuffer = rb; }
+    void setGateOptions(bool enabled, float thresholdDb, UINT32 holdMs);
+    void setRealtimePolicy(const RealtimePolicy& policy) { m_rtPolicy = policy; }
+    // Buffers used on the period thread come from here; must outlive the endpoint
+    void setArena(AudioArena* arena) { m_arena = arena; }
+    // Every delivered packet is also queued to the recorder; set before start()
+    void setRecorder(AudioRecorder* recorder) { m_recorder = recorder; }
+    // ... and offered to the spectrum analyzer tap
+    void setAnalyzer(SpectrumAnalyzer* analyzer) { m_analyzer = analyzer; }
+    // Packets go into the ring through the verifier, untouched by the gate;
+    // set before start()
+    void setVerifier(PassthroughVerifier* verifier) { m_verifier = verifier; }
+
+    const AudioFormat& format() const { return m_format; }
+    UINT32    bufferFrames() const { return m_bufferFrames; }
+    bool      isRunning()    const { return m_running.load(std::memory_order_relaxed); }
+    // A finite source (a file without looping) has delivered all of it
+    bool      isFinished()   const { return m_finished.load(std::memory_order_relaxed); }
+    // Bypassed while a verifier is set
+    bool      gateEnabled()  const { return m_gate.enabled() && !m_verifier; }
+    GateState gateState()    const { return m_gate.state(); }
+    LevelSnapshot levels()   const { return m_meter.snapshot(); }
+    RealtimeReport threadReport() const { return m_threadReport.load(); }
+    virtual TransportStats transportStats() const { return {}; }
+
+    // Watchdog: packets delivered so far, and how often that has to happen
+    // while running (0 = no fixed pace to supervise)
+    UINT64 periodCount() const { return m_periods.load(std::memory_order_relaxed); }
+    virtual double periodMs() const {
+        return m_format.sampleRate ? 1000.0 * m_bufferFrames / m_format.sampleRate : 0.0;
+    }
+    // Reopen the device after a stall, keeping format and ring. Backends
+    // without a device to reopen return S_FALSE and the watchdog only waits.
+    virtual HRESULT recover() { return S_FALSE; }
+    // Rate the device clock runs at, measured against the steady clock
+    ClockEstimate clockEstimate() const { return m_clock.estimate(); }
+
+protected:
+    // Called by the backend once m_format is final
+    void initPipeline();
+    // Period thread: 'position' frames had been captured at 'timeNs'
+    // (startupClockNs() scale); resetClock() before the thread starts
+    void observeClock(UINT64 position, INT64 timeNs) { m_clock.observe(position, timeNs); }
+    void resetClock() { m_clock.reset(m_format.sampleRate); }
+
+    void deliver(const uint8_t* data, uint32_t frames) {
+        m_periods.fetch_add(1, std::memory_order_relaxed);
+        if (m_recorder) m_recorder->push(data, frames);
+        if (m_analyzer) m_analyzer->push(data, frames);
+        // One pass over the packet serves both the meter and the gate
+        float peak = m_meter.process(data, frames);
+        if (m_verifier) m_verifier->write(*m_ringBuffer, data, static_cast<size_t>(frames) * m_format.blockAlign());
+        else            m_gate.write(*m_ringBuffer, data, frames, peak);
+    }
+    void deliverSilence(uint32_t frames) {
+        m_periods.fetch_add(1, std::memory_order_relaxed);
+        if (m_recorder) m_recorder->pushSilence(frames);
+        if (m_analyzer) m_analyzer->pushSilence(frames);
+        m_meter.processSilence(frames);
+        if (m_verifier) m_verifier->writeSilence(*m_ringBuffer, static_cast<size_t>(frames) * m_format.blockAlign());
+        else            m_gate.writeSilence(*m_ringBuffer, frames);
+    }
+    // Called after the last packet of a finite source
+    void endOfStream() {
+        m_finished.store(true, std::memory_order_relaxed);
+        m_ringBuffer->markEnd();
+    }
+
+    AudioFormat       m_format;
+    UINT32            m_bufferFrames = 0;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_finished{false};
+    RingBuffer*       m_ringBuffer = nullptr;
+    // The backend's period thread applies the policy and publishes the result
+    RealtimePolicy     m_rtPolicy;
+    RealtimeReportSlot m_threadReport;
+    AudioArena*        m_arena = nullptr;
+    AudioRecorder*     m_recorder = nullptr;
+    SpectrumAnalyzer*  m_analyzer = nullptr;
+    PassthroughVerifier* m_verifier = nullptr;
+
+private:
+    ActivityGate      m_gate;
+    LevelMeter        m_meter;
+    bool              m_gateEnabled = false;
+    float             m_gateThresholdDb = -90.0f;
+    UINT32            m_gateHoldMs = 500;
+    std::atomic<UINT64> m_periods{0};
+    ClockEstimator    m_clock;
+};
+
+// Common part of all render backends.
+//
+// Backends call pull() once per device period. It reads from the ring buffer,
+// runs the insert chain, conceals shortfalls and keeps the underrun statistics.
+class RenderEndpoint {
+public:
+    virtual ~RenderEndpoint() = default;
+
+    virtual HRESULT start() = 0;
+    virtual void    stop() = 0;
+
+    void setRingBuffer(RingBuffer* rb) { m_ringBuffer = rb; }
+    void setRealtimePolicy(const RealtimePolicy& policy) { m_rtPolicy = policy; }
+    // Buffers used on the period thread come from here; must outlive the endpoint
+    void setArena(AudioArena* arena) { m_arena = arena; }
+    // Every rendered period is also queued to the recorder; set before start()
+    void setRecorder(AudioRecorder* recorder) { m_recorder = recorder; }
+    // ... and offered to the spectrum analyzer tap
+    void setAnalyzer(SpectrumAnalyzer* analyzer) { m_analyzer = analyzer; }
+    // Everything read from the ring is checked against what capture wrote;
+    // set before start()
+    void setVerifier(PassthroughVerifier* verifier) { m_verifier = verifier; }
+    // Insert chain run on every period; set before init()
+    void setInserts(const std::vector<DspStageConfig>& inserts) { m_insertConfig = inserts; }
+    // Initial output gain and mute; set before init()
+    void setOutput(float gainDb, bool mute) { m_outputGainDb = gainDb; m_mute = mute; }
+    // Live parameter changes, polled once per period; set before start()
+    void setParamQueue(ParamQueue* params) { m_params = params; }
+    // Control thread, while running: parameters for a live insert change
+    DspParamSet* prepareInsert(UINT32 index, const DspStageConfig& config) const {
+        return m_dsp.prepareInsert(index, config);
+    }
+
+    const AudioFormat& format() const { return m_format; }
+    UINT32 bufferFrames()  const { return m_bufferFrames; }
+    bool   isRunning()     const { return m_running.load(std::memory_order_relaxed); }
+    UINT32 insertStages()  const { return m_dsp.stageCount(); }
+    UINT64 underrunCount() const { return m_underruns.load(std::memory_order_relaxed); }
+    UINT64 concealedFrameCount() const { return m_concealedFrames.load(std::memory_order_relaxed); }
+    // The source ended its stream and everything has been played
+    bool   isDrained()     const { return m_drained.load(std::memory_order_relaxed); }
+    LevelSnapshot levels() const { return m_meter.snapshot(); }
+    RealtimeReport threadReport() const { return m_threadReport.load(); }
+    virtual TransportStats transportStats() const { return {}; }
+    // startupClockNs() of the first period since start(), 0 before it
+    INT64  firstPeriodNs() const { return m_firstPeriodNs.load(std::memory_order_relaxed); }
+    // Watchdog: periods pulled so far, and how often that has to happen
+    // while running (0 = no fixed pace to supervise)
+    UINT64 periodCount() const { return m_periods.load(std::memory_order_relaxed); }
+    virtual double periodMs() const {
+        return m_format.sampleRate ? 1000.0 * m_bufferFrames / m_format.sampleRate : 0.0;
+    }
+    // Reopen the device after a stall, keeping format, ring and insert
+    // settings. Backends without a device to reopen return S_FALSE.
+    virtual HRESULT recover() { return S_FALSE; }
+    // Rate the device clock runs at, measured against the steady clock
+    ClockEstimate clockEstimate() const { return m_clock.estimate(); }
+
+protected:
+    // Called by the backend once m_format is final
+    void initPipeline();
+    // Period thread: 'position' frames had been played at 'timeNs'
+    // (startupClockNs() scale); resetClock() before the thread starts
+    void observeClock(UINT64 position, INT64 timeNs) { m_clock.observe(position, timeNs); }
+    void resetClock() { m_clock.reset(m_format.sampleRate); }
+    // Called by the backend from start()
+    void resetPipeline();
+    // Throw away queued bytes the device has no room for
+    size_t discardQueued(size_t bytes) {
+        const size_t skipped = m_ringBuffer->skip(bytes);
+        if (m_verifier) m_verifier->discard(skipped);
+        return skipped;
+    }
+
+    // Fill one device period. Returns true if the period is silent, in which
+    // case 'data' may have been left untouched (a whole silence run was skipped).
+    bool pull(uint8_t* data, uint32_t frames);
+
+    AudioFormat         m_format;
+    UINT32              m_bufferFrames = 0;
+    std::atomic<bool>   m_running{false};
+    RingBuffer*         m_ringBuffer = nullptr;
+    RealtimePolicy      m_rtPolicy;
+    RealtimeReportSlot  m_threadReport;
+    AudioArena*         m_arena = nullptr;
+    AudioRecorder*      m_recorder = nullptr;
+    SpectrumAnalyzer*   m_analyzer = nullptr;
+    ParamQueue*         m_params = nullptr;
+    PassthroughVerifier* m_verifier = nullptr;
+
+private:
+    std::vector<DspStageConfig> m_insertConfig;
+    float               m_outputGainDb = 0.0f;
+    bool                m_mute = false;
+    DspChain            m_dsp;
+    PacketConcealer     m_concealer;
+    LevelMeter          m_meter;
+    std::atomic<UINT64> m_underruns{0};
+    std::atomic<UINT64> m_concealedFrames{0};
+    std::atomic<bool>   m_drained{false};
+    std::atomic<INT64>  m_firstPeriodNs{0};
+    std::atomic<UINT64> m_periods{0};
+    ClockEstimator      m_clock;
+};
@@ -0,0 +1,181 @@
+#include "AudioKernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIOBRIDGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static float peakAbsFloat(const float* p, size_t n) {
+    size_t i = 0;
+    float peak = 0.0f;
+#ifdef AUDIOBRIDGE_SSE2
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 vmax = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_and_ps(_mm_loadu_ps(p + i), absMask);
+        __m128 b = _mm_and_ps(_mm_loadu_ps(p + i + 4), absMask);
+        vmax = _mm_max_ps(vmax, _mm_max_ps(a, b));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, vmax);
+    peak = lanes[0];
+    for (int k = 1; k < 4; ++k) if (lanes[k] > peak) peak = lanes[k];
+#endif
+    for (; i < n; ++i) {
+        float a = std::fabs(p[i]);
+        if (a > peak) peak = a;
+    }
+    return peak;
+}
+
+static float peakAbsInt16(const int16_t* p, size_t n) {
+    size_t i = 0;
+    int peak = 0;
+#ifdef AUDIOBRIDGE_SSE2
+    __m128i vmax = _mm_setzero_si128();
+    __m128i vmin = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        vmax = _mm_max_epi16(vmax, v);
+        vmin = _mm_min_epi16(vmin, v);
+    }
+    alignas(16) int16_t hi[8], lo[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(hi), vmax);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lo), vmin);
+    for (int k = 0; k < 8; ++k) {
+        if (hi[k] > peak)  peak = hi[k];
+        if (-lo[k] > peak) peak = -lo[k];
+    }
+#endif
+    for (; i < n; ++i) {
+        int a = p[i] < 0 ? -p[i] : p[i];
+        if (a > peak) peak = a;
+    }
+    return peak * (1.0f / 32768.0f);
+}
+
+float peakAbs(SampleType type, const uint8_t* data, size_t samples) {
+    switch (type) {
+        case SampleType::Float32:
+            return peakAbsFloat(reinterpret_cast<const float*>(data), samples);
+        case SampleType::Int16:
+            return peakAbsInt16(reinterpret_cast<const int16_t*>(data), samples);
+        default: {
+            const uint32_t step = bytesPerSample(type);
+            float peak = 0.0f;
+            for (size_t i = 0; i < samples; ++i) {
+                float a = std::fabs(loadSample(type, data + i * step));
+                if (a > peak) peak = a;
+            }
+            return peak;
+        }
+    }
+}
+
+static float accumulateLevelsScalar(SampleType type, const uint8_t* data, uint32_t frames,
+                                    uint32_t channels, float* peak, float* sumSquares, uint32_t* clips) {
+    const uint32_t step = bytesPerSample(type);
+    float blockPeak = 0.0f;
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            float v = loadSample(type, data + (static_cast<size_t>(f) * channels + c) * step);
+            float a = std::fabs(v);
+            if (a > peak[c]) peak[c] = a;
+            if (a > blockPeak) blockPeak = a;
+            sumSquares[c] += v * v;
+            if (a >= kClipLevel) ++clips[c];
+        }
+    }
+    return blockPeak;
+}
+
+#ifdef AUDIOBRIDGE_SSE2
+// Four samples per step. With 1, 2 or 4 channels every lane always holds
+// the same channel (lane % channels), so the lanes fold into the channels
+// once at the end.
+struct LevelLanes {
+    __m128  absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128  clipLevel = _mm_set1_ps(kClipLevel);
+    __m128  peak = _mm_setzero_ps();
+    __m128  sum = _mm_setzero_ps();
+    __m128i clips = _mm_setzero_si128();
+
+    void add(__m128 v) {
+        __m128 a = _mm_and_ps(v, absMask);
+        peak = _mm_max_ps(peak, a);
+        sum = _mm_add_ps(sum, _mm_mul_ps(v, v));
+        // The compare mask is -1 per clipped lane
+        clips = _mm_sub_epi32(clips, _mm_castps_si128(_mm_cmpge_ps(a, clipLevel)));
+    }
+
+    // Returns the largest lane peak
+    float fold(uint32_t channels, float* peakOut, float* sumOut, uint32_t* clipsOut) const {
+        alignas(16) float p[4], s[4];
+        alignas(16) int32_t c[4];
+        _mm_store_ps(p, peak);
+        _mm_store_ps(s, sum);
+        _mm_store_si128(reinterpret_cast<__m128i*>(c), clips);
+        float blockPeak = 0.0f;
+        for (uint32_t k = 0; k < 4; ++k) {
+            uint32_t ch = k % channels;
+            if (p[k] > peakOut[ch]) peakOut[ch] = p[k];
+            if (p[k] > blockPeak) blockPeak = p[k];
+            sumOut[ch] += s[k];
+            clipsOut[ch] += static_cast<uint32_t>(c[k]);
+        }
+        return blockPeak;
+    }
+};
+#endif
+
+float accumulateLevels(SampleType type, const uint8_t* data, uint32_t frames, uint32_t channels,
+                       float* peak, float* sumSquares, uint32_t* clips) {
+#ifdef AUDIOBRIDGE_SSE2
+    const bool lanesFit = channels == 1 || channels == 2 || channels == 4;
+    if (lanesFit && (type == SampleType::Float32 || type == SampleType::Int16)) {
+        const size_t samples = static_cast<size_t>(frames) * channels;
+        LevelLanes lanes;
+        size_t i = 0;
+        if (type == SampleType::Float32) {
+            const float* p = reinterpret_cast<const float*>(data);
+            for (; i + 4 <= samples; i += 4) lanes.add(_mm_loadu_ps(p + i));
+        } else {
+            const int16_t* p = reinterpret_cast<const int16_t*>(data);
+            const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+            for (; i + 8 <= samples; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                // Sign-extend to 32 bits by unpacking into the high halves
+                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+                lanes.add(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                lanes.add(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+            }
+        }
+        float blockPeak = lanes.fold(channels, peak, sumSquares, clips);
+
+        // Tail: i is a whole number of frames since 4 % channels == 0
+        const uint32_t done = static_cast<uint32_t>(i / channels);
+        const uint32_t step = bytesPerSample(type);
+        float tailPeak = accumulateLevelsScalar(type, data + i * step, frames - done, channels,
+                                                peak, sumSquares, clips);
+        return (std::max)(blockPeak, tailPeak);
+    }
+#endif
+    return accumulateLevelsScalar(type, data, frames, channels, peak, sumSquares, clips);
+}
+
+void applyRamp(SampleType type, const uint8_t* src, uint8_t* dst,
+               uint32_t frames, uint32_t channels, float gainStart, float gainEnd) {
+    const uint32_t step = bytesPerSample(type);
+    const float inc = frames > 0 ? (gainEnd - gainStart) / frames : 0.0f;
+    float g = gainStart;
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            size_t off = (static_cast<size_t>(f) * channels + c) * step;
+            storeSample(type, dst + off, loadSample(type, src + off) * g);
+        }
+        g += inc;
+    }
+}
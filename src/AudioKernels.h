@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "SampleFormat.h"
+
+// Block-level sample kernels shared by the analysis and processing stages.
+// SSE2 paths are used where available; everything else falls back to scalar.
+
+// Largest absolute sample value in the block, normalized to full scale.
+float peakAbs(SampleType type, const uint8_t* data, size_t samples);
+
+// Multiply samples by a linear ramp from gainStart towards gainEnd
+// (gainEnd is reached one step past the last sample).
+void applyRamp(SampleType type, const uint8_t* src, uint8_t* dst,
+               uint32_t frames, uint32_t channels, float gainStart, float gainEnd);
+
+// Samples at or above this magnitude count as clipped (int16 full scale)
+constexpr float kClipLevel = 32767.0f / 32768.0f;
+
+// Per-channel level statistics of an interleaved block, accumulated into
+// the caller's arrays (one entry per channel): peak is raised to the block
+// peak, the squares of the samples are added to sumSquares and samples at
+// kClipLevel or above are counted in clips. Returns the peak over all
+// channels.
+float accumulateLevels(SampleType type, const uint8_t* data, uint32_t frames, uint32_t channels,
+                       float* peak, float* sumSquares, uint32_t* clips);
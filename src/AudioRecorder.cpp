@@ -0,0 +1,181 @@
+#include "AudioRecorder.h"
+#include "RealtimeThread.h"
+#include "WavFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Writes go out in blocks of at least this size, from a staging buffer of
+// four times that
+static constexpr size_t kWriteBlockBytes = 256 * 1024;
+// File space is reserved this far ahead of the data
+static constexpr uint64_t kPreallocateBytes = 64ull * 1024 * 1024;
+static constexpr auto kPollInterval = std::chrono::milliseconds(20);
+static constexpr auto kHeaderInterval = std::chrono::seconds(5);
+
+static bool seekFile(FILE* f, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(f, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(f, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+AudioRecorder::~AudioRecorder() {
+    stop();
+}
+
+HRESULT AudioRecorder::start(const std::string& path, const AudioFormat& format, UINT32 bufferMs,
+                             AudioArena* arena) {
+    stop();
+    if (!format.isValid()) return E_INVALIDARG;
+
+    m_file = openFileUtf8(path.c_str(), "wb");
+    if (!m_file) return E_ACCESSDENIED;
+    // Every write is already a large block
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+    if (!writeWav64Header(m_file, format, 0)) {
+        std::fclose(m_file);
+        m_file = nullptr;
+        return E_FAIL;
+    }
+
+    m_format = format;
+    m_blockAlign = format.blockAlign();
+    const size_t frames = (std::max)(static_cast<size_t>(format.sampleRate) * bufferMs / 1000,
+                                     static_cast<size_t>(format.sampleRate / 10));
+    m_ring = std::make_unique<RingBuffer>(frames * m_blockAlign + 1, arena);
+    m_staging.assign(kWriteBlockBytes * 4, 0);
+    m_stagingUsed = 0;
+    m_dataBytes = 0;
+    m_allocatedBytes = 0;
+    reserveSpace(kWav64HeaderBytes);
+
+    m_writeFailed.store(false);
+    m_recordedFrames.store(0);
+    m_droppedFrames.store(0);
+    m_running.store(true);
+    m_thread = std::thread(&AudioRecorder::writerLoop, this);
+    return S_OK;
+}
+
+void AudioRecorder::stop() {
+    if (m_thread.joinable()) {
+        m_running.store(false);
+        m_thread.join();
+    }
+    m_running.store(false);
+
+    if (m_file) {
+        writeStaging();
+        updateHeader();
+#ifndef _WIN32
+        // Give back the space reserved past the end of the data
+        std::fflush(m_file);
+        int rc = ftruncate(fileno(m_file), static_cast<off_t>(kWav64HeaderBytes + m_dataBytes));
+        (void)rc;
+#endif
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    m_ring.reset();
+    m_staging = std::vector<uint8_t>();
+}
+
+void AudioRecorder::writerLoop() {
+    lowerThreadPriority();
+    auto nextHeader = std::chrono::steady_clock::now() + kHeaderInterval;
+
+    while (m_running.load()) {
+        drain(false);
+        if (std::chrono::steady_clock::now() >= nextHeader) {
+            nextHeader += kHeaderInterval;
+            writeStaging();
+            updateHeader();
+        }
+        std::this_thread::sleep_for(kPollInterval);
+    }
+
+    // The feeding endpoint is stopped by now: take everything that is left
+    drain(true);
+}
+
+void AudioRecorder::drain(bool flush) {
+    for (;;) {
+        bool silent = false;
+        size_t run = m_ring->nextRun(silent, m_staging.size() - m_stagingUsed);
+        if (run == 0) break;
+
+        size_t n = (std::min)(run, m_staging.size() - m_stagingUsed);
+        if (silent) {
+            m_ring->skip(n);
+            std::memset(m_staging.data() + m_stagingUsed, 0, n);
+        } else {
+            m_ring->read(m_staging.data() + m_stagingUsed, n);
+        }
+        m_stagingUsed += n;
+        if (m_stagingUsed == m_staging.size()) writeStaging();
+    }
+
+    if (flush || m_stagingUsed >= kWriteBlockBytes) writeStaging();
+}
+
+void AudioRecorder::writeStaging() {
+    if (m_stagingUsed == 0 || !m_file) return;
+
+    // Whole frames only: the ring is fed in whole frames, so this only
+    // holds back a remainder if a write was short
+    const size_t bytes = m_stagingUsed - m_stagingUsed % m_blockAlign;
+    if (m_writeFailed.load(std::memory_order_relaxed)) {
+        m_droppedFrames.fetch_add(bytes / m_blockAlign, std::memory_order_relaxed);
+    } else {
+        reserveSpace(kWav64HeaderBytes + m_dataBytes + bytes);
+        size_t written = std::fwrite(m_staging.data(), 1, bytes, m_file);
+        written -= written % m_blockAlign;
+        m_dataBytes += written;
+        m_recordedFrames.fetch_add(written / m_blockAlign, std::memory_order_relaxed);
+        if (written < bytes) {
+            // Disk full or gone: keep draining so the audio side never
+            // backs up, and count the rest as dropped
+            m_writeFailed.store(true, std::memory_order_relaxed);
+            m_droppedFrames.fetch_add((bytes - written) / m_blockAlign, std::memory_order_relaxed);
+            seekFile(m_file, kWav64HeaderBytes + m_dataBytes);
+        }
+    }
+
+    std::memmove(m_staging.data(), m_staging.data() + bytes, m_stagingUsed - bytes);
+    m_stagingUsed -= bytes;
+}
+
+void AudioRecorder::updateHeader() {
+    if (!m_file || !seekFile(m_file, 0)) return;
+    writeWav64Header(m_file, m_format, m_dataBytes);
+    seekFile(m_file, kWav64HeaderBytes + m_dataBytes);
+}
+
+// Reserves file space in large steps so the file system can keep a
+// long recording contiguous
+void AudioRecorder::reserveSpace(uint64_t fileBytes) {
+    if (fileBytes <= m_allocatedBytes) return;
+    const uint64_t target = fileBytes + kPreallocateBytes;
+#ifdef _WIN32
+    HANDLE h = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+    FILE_ALLOCATION_INFO info = {};
+    info.AllocationSize.QuadPart = static_cast<LONGLONG>(target);
+    // Allocation past the end of file is released again on close
+    if (h != INVALID_HANDLE_VALUE)
+        SetFileInformationByHandle(h, FileAllocationInfo, &info, sizeof(info));
+#elif defined(__linux__)
+    // KEEP_SIZE: the file length still follows the data; stop() trims the rest
+    fallocate(fileno(m_file), FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(target));
+#endif
+    // Not retried on failure: reservation is only an optimization
+    m_allocatedBytes = target;
+}
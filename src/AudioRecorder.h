@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Platform.h"
+#include "SampleFormat.h"
+#include "RingBuffer.h"
+
+// Where a route's recording (or analyzer) tap sits.
+enum class RecordTap {
+    Capture,    // capture packets as delivered, before any resampling
+    Render      // render periods as played, after resampling and concealment
+};
+
+// Records a stream to a WAV file (RF64 beyond 4 GB) without touching the
+// timing of the audio thread that feeds it.
+//
+// The audio thread copies each block into a side ring and never waits: a
+// block that does not fit is dropped and counted. A low-priority writer
+// thread drains the ring in large sequential writes, keeps the file
+// allocation ahead of the data and rewrites the header every few seconds,
+// so an interrupted recording is still playable up to the last update.
+class AudioRecorder {
+public:
+    AudioRecorder() = default;
+    ~AudioRecorder();
+
+    // Creates the file and starts the writer thread. The side ring holds
+    // 'bufferMs' of audio and comes from 'arena', since the audio thread
+    // writes to it.
+    HRESULT start(const std::string& path, const AudioFormat& format, UINT32 bufferMs,
+                  AudioArena* arena);
+    // Writes what is still queued, finalizes the header and closes the file
+    void    stop();
+
+    // Audio thread: queue one block, or drop it whole if the writer is behind
+    void push(const uint8_t* data, uint32_t frames) {
+        const size_t bytes = static_cast<size_t>(frames) * m_blockAlign;
+        if (m_ring->canWrite(bytes))
+            m_ring->write(data, bytes);
+        else
+            m_droppedFrames.fetch_add(frames, std::memory_order_relaxed);
+    }
+    void pushSilence(uint32_t frames) {
+        const size_t bytes = static_cast<size_t>(frames) * m_blockAlign;
+        if (m_ring->canWrite(bytes))
+            m_ring->writeSilence(bytes);
+        else
+            m_droppedFrames.fetch_add(frames, std::memory_order_relaxed);
+    }
+
+    const AudioFormat& format() const { return m_format; }
+    bool   isRecording()    const { return m_running.load(std::memory_order_relaxed); }
+    bool   writeFailed()    const { return m_writeFailed.load(std::memory_order_relaxed); }
+    UINT64 recordedFrames() const { return m_recordedFrames.load(std::memory_order_relaxed); }
+    UINT64 droppedFrames()  const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+    AudioRecorder(const AudioRecorder&) = delete;
+    AudioRecorder& operator=(const AudioRecorder&) = delete;
+
+private:
+    void writerLoop();
+    // Moves queued audio into the staging buffer and writes it out once a
+    // large block has collected, or everything when 'flush' is set
+    void drain(bool flush);
+    void writeStaging();
+    void updateHeader();
+    void reserveSpace(uint64_t fileBytes);
+
+    AudioFormat                 m_format;
+    size_t                      m_blockAlign = 0;
+    std::unique_ptr<RingBuffer> m_ring;
+
+    // Writer thread only
+    FILE*                m_file = nullptr;
+    std::vector<uint8_t> m_staging;
+    size_t               m_stagingUsed = 0;
+    uint64_t             m_dataBytes = 0;        // sample bytes in the file
+    uint64_t             m_allocatedBytes = 0;   // file space reserved so far
+
+    std::thread         m_thread;
+    std::atomic<bool>   m_running{false};
+    std::atomic<bool>   m_writeFailed{false};
+    std::atomic<UINT64> m_recordedFrames{0};
+    std::atomic<UINT64> m_droppedFrames{0};
+};
@@ -5,10 +5,87 @@
 #include <wmcodecdsp.h>
 #include <ks.h>
 #include <ksmedia.h>
+#include <algorithm>
+
+// IMFMediaBuffer over a fixed block of caller-owned memory. Lets the
+// resampler reuse one input and one output sample instead of creating COM
+// objects and heap buffers for every block on the pipeline thread.
+class FixedMediaBuffer : public IMFMediaBuffer {
+public:
+    FixedMediaBuffer(BYTE* data, DWORD maxLength) : m_data(data), m_maxLength(maxLength) {}
+
+    STDMETHODIMP QueryInterface(REFIID riid, void** ppv) override {
+        if (!ppv) return E_POINTER;
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IMFMediaBuffer)) {
+            *ppv = static_cast<IMFMediaBuffer*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef() override { return InterlockedIncrement(&m_refs); }
+    STDMETHODIMP_(ULONG) Release() override {
+        ULONG refs = InterlockedDecrement(&m_refs);
+        if (refs == 0) delete this;
+        return refs;
+    }
+
+    STDMETHODIMP Lock(BYTE** ppbBuffer, DWORD* pcbMaxLength, DWORD* pcbCurrentLength) override {
+        if (!ppbBuffer) return E_POINTER;
+        *ppbBuffer = m_data;
+        if (pcbMaxLength) *pcbMaxLength = m_maxLength;
+        if (pcbCurrentLength) *pcbCurrentLength = m_length;
+        return S_OK;
+    }
+    STDMETHODIMP Unlock() override { return S_OK; }
+    STDMETHODIMP GetCurrentLength(DWORD* pcbCurrentLength) override {
+        if (!pcbCurrentLength) return E_POINTER;
+        *pcbCurrentLength = m_length;
+        return S_OK;
+    }
+    STDMETHODIMP SetCurrentLength(DWORD cbCurrentLength) override {
+        if (cbCurrentLength > m_maxLength) return E_INVALIDARG;
+        m_length = cbCurrentLength;
+        return S_OK;
+    }
+    STDMETHODIMP GetMaxLength(DWORD* pcbMaxLength) override {
+        if (!pcbMaxLength) return E_POINTER;
+        *pcbMaxLength = m_maxLength;
+        return S_OK;
+    }
+
+private:
+    virtual ~FixedMediaBuffer() = default;
+
+    volatile LONG m_refs = 1;
+    BYTE*         m_data;
+    DWORD         m_maxLength;
+    DWORD         m_length = 0;
+};
+
+static HRESULT createFixedSample(BYTE* data, DWORD maxLength,
+                                 IMFSample** ppSample, IMFMediaBuffer** ppBuffer) {
+    ComPtr<IMFSample> sample;
+    RETURN_IF_FAILED(MFCreateSample(&sample));
+
+    ComPtr<IMFMediaBuffer> buffer;
+    buffer.Attach(new (std::nothrow) FixedMediaBuffer(data, maxLength));
+    if (!buffer) return E_OUTOFMEMORY;
+    RETURN_IF_FAILED(sample->AddBuffer(buffer.Get()));
+
+    *ppSample = sample.Detach();
+    *ppBuffer = buffer.Detach();
+    return S_OK;
+}
 
 AudioResampler::AudioResampler() {}
 
 AudioResampler::~AudioResampler() {
+    m_inSample.Reset();
+    m_outSample.Reset();
+    m_inBuffer.Reset();
+    m_outBuffer.Reset();
     m_transform.Reset();
 }
 
@@ -28,7 +105,8 @@ static bool formatsMatch(const WAVEFORMATEX* a, const WAVEFORMATEX* b) {
     return true;
 }
 
-HRESULT AudioResampler::init(const WAVEFORMATEX* inputFormat, const WAVEFORMATEX* outputFormat) {
+HRESULT AudioResampler::init(const WAVEFORMATEX* inputFormat, const WAVEFORMATEX* outputFormat,
+                             DWORD maxInputBytes, AudioArena* arena) {
     m_needed = false;
 
     if (formatsMatch(inputFormat, outputFormat)) {
@@ -44,7 +122,7 @@ HRESULT AudioResampler::init(const WAVEFORMATEX* inputFormat, const WAVEFORMATEX
     // Set quality to best
     ComPtr<IWMResamplerProps> resamplerProps;
     if (SUCCEEDED(m_transform.As(&resamplerProps))) {
-        resamplerProps->SetHalfFilterLength(60); // max quality
+        resamplerProps->SetHalfFilterLength(m_halfFilterLength); // 60 = max quality
     }
 
     // Set input type
@@ -57,6 +135,19 @@ HRESULT AudioResampler::init(const WAVEFORMATEX* inputFormat, const WAVEFORMATEX
     RETURN_IF_FAILED(createMediaType(outputFormat, &outputType));
     RETURN_IF_FAILED(m_transform->SetOutputType(0, outputType.Get(), 0));
 
+    // Output per call: the converted input plus the filter delay, with margin.
+    // A larger result just takes several ProcessOutput calls to drain.
+    MFT_OUTPUT_STREAM_INFO streamInfo = {};
+    RETURN_IF_FAILED(m_transform->GetOutputStreamInfo(0, &streamInfo));
+    const double ratio = static_cast<double>(outputFormat->nAvgBytesPerSec) / inputFormat->nAvgBytesPerSec;
+    DWORD outBytes = static_cast<DWORD>(maxInputBytes * ratio) * 2 + 4096;
+    outBytes = (std::max)(outBytes, streamInfo.cbSize);
+
+    m_inStorage = ArenaVector<BYTE>(maxInputBytes, 0, ArenaAllocator<BYTE>(arena));
+    m_outStorage = ArenaVector<BYTE>(outBytes, 0, ArenaAllocator<BYTE>(arena));
+    RETURN_IF_FAILED(createFixedSample(m_inStorage.data(), maxInputBytes, &m_inSample, &m_inBuffer));
+    RETURN_IF_FAILED(createFixedSample(m_outStorage.data(), outBytes, &m_outSample, &m_outBuffer));
+
     // Send stream start message
     RETURN_IF_FAILED(m_transform->ProcessMessage(MFT_MESSAGE_NOTIFY_BEGIN_STREAMING, 0));
     RETURN_IF_FAILED(m_transform->ProcessMessage(MFT_MESSAGE_NOTIFY_START_OF_STREAM, 0));
@@ -104,74 +195,52 @@ HRESULT AudioResampler::createMediaType(const WAVEFORMATEX* wfx, IMFMediaType**
 }
 
 HRESULT AudioResampler::process(const BYTE* inData, DWORD inBytes,
-                                 std::vector<BYTE>& outBuffer) {
+                                 ArenaVector<BYTE>& outBuffer) {
     if (!m_transform) return E_NOT_VALID_STATE;
 
-    // Create input sample
-    ComPtr<IMFSample> inputSample;
-    RETURN_IF_FAILED(MFCreateSample(&inputSample));
-
-    ComPtr<IMFMediaBuffer> inputBuffer;
-    RETURN_IF_FAILED(MFCreateMemoryBuffer(inBytes, &inputBuffer));
+    while (inBytes > 0) {
+        DWORD chunk = (std::min)(inBytes, static_cast<DWORD>(m_inStorage.size()));
+        memcpy(m_inStorage.data(), inData, chunk);
+        RETURN_IF_FAILED(m_inBuffer->SetCurrentLength(chunk));
 
-    BYTE* bufPtr = nullptr;
-    RETURN_IF_FAILED(inputBuffer->Lock(&bufPtr, nullptr, nullptr));
-    memcpy(bufPtr, inData, inBytes);
-    RETURN_IF_FAILED(inputBuffer->Unlock());
-    RETURN_IF_FAILED(inputBuffer->SetCurrentLength(inBytes));
+        // Feed to transform; draining all output below releases the sample
+        // again, so the same one can be used for the next block
+        HRESULT hr = m_transform->ProcessInput(0, m_inSample.Get(), 0);
+        if (FAILED(hr)) return hr;
+        RETURN_IF_FAILED(drainOutput(outBuffer));
 
-    RETURN_IF_FAILED(inputSample->AddBuffer(inputBuffer.Get()));
-
-    // Feed to transform
-    HRESULT hr = m_transform->ProcessInput(0, inputSample.Get(), 0);
-    if (FAILED(hr)) return hr;
-
-    // Drain all output
-    return drainOutput(outBuffer);
+        inData += chunk;
+        inBytes -= chunk;
+    }
+    return S_OK;
 }
 
-HRESULT AudioResampler::drainOutput(std::vector<BYTE>& outBuffer) {
+HRESULT AudioResampler::drainOutput(ArenaVector<BYTE>& outBuffer) {
     for (;;) {
-        MFT_OUTPUT_STREAM_INFO streamInfo = {};
-        RETURN_IF_FAILED(m_transform->GetOutputStreamInfo(0, &streamInfo));
-
-        ComPtr<IMFSample> outputSample;
-        ComPtr<IMFMediaBuffer> outputMediaBuf;
-
-        DWORD allocSize = (streamInfo.cbSize > 0) ? streamInfo.cbSize : 65536;
-
-        RETURN_IF_FAILED(MFCreateSample(&outputSample));
-        RETURN_IF_FAILED(MFCreateMemoryBuffer(allocSize, &outputMediaBuf));
-        RETURN_IF_FAILED(outputSample->AddBuffer(outputMediaBuf.Get()));
+        RETURN_IF_FAILED(m_outBuffer->SetCurrentLength(0));
 
         MFT_OUTPUT_DATA_BUFFER outputData = {};
-        outputData.pSample = outputSample.Get();
+        outputData.pSample = m_outSample.Get();
 
         DWORD status = 0;
         HRESULT hr = m_transform->ProcessOutput(0, 1, &outputData, &status);
+        if (outputData.pEvents) outputData.pEvents->Release();
 
         if (hr == MF_E_TRANSFORM_NEED_MORE_INPUT) {
             return S_OK; // No more output available
         }
         RETURN_IF_FAILED(hr);
 
-        // Extract data from output sample
-        ComPtr<IMFMediaBuffer> buf;
-        RETURN_IF_FAILED(outputData.pSample->ConvertToContiguousBuffer(&buf));
-
-        BYTE* data = nullptr;
         DWORD dataLen = 0;
-        RETURN_IF_FAILED(buf->Lock(&data, nullptr, &dataLen));
+        RETURN_IF_FAILED(m_outBuffer->GetCurrentLength(&dataLen));
 
         size_t prevSize = outBuffer.size();
         outBuffer.resize(prevSize + dataLen);
-        memcpy(outBuffer.data() + prevSize, data, dataLen);
-
-        buf->Unlock();
+        memcpy(outBuffer.data() + prevSize, m_outStorage.data(), dataLen);
     }
 }
 
-HRESULT AudioResampler::flush(std::vector<BYTE>& outBuffer) {
+HRESULT AudioResampler::flush(ArenaVector<BYTE>& outBuffer) {
     if (!m_transform) return E_NOT_VALID_STATE;
 
     RETURN_IF_FAILED(m_transform->ProcessMessage(MFT_MESSAGE_COMMAND_DRAIN, 0));
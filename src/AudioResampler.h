@@ -6,6 +6,7 @@
 #include <mmreg.h>
 #include <vector>
 #include "ComHelper.h"
+#include "AudioArena.h"
 
 class AudioResampler {
 public:
@@ -14,22 +15,39 @@ public:
 
     // Initialize with input and output WAVEFORMATEX.
     // Returns S_FALSE if no resampling is needed (formats match).
-    HRESULT init(const WAVEFORMATEX* inputFormat, const WAVEFORMATEX* outputFormat);
+    // The input and output sample buffers (sized for maxInputBytes per
+    // transform call) are allocated here, from the arena when given, and
+    // reused by every process() call.
+    HRESULT init(const WAVEFORMATEX* inputFormat, const WAVEFORMATEX* outputFormat,
+                 DWORD maxInputBytes = 4096, AudioArena* arena = nullptr);
 
     // Process a block of audio data. Output is appended to outBuffer.
     HRESULT process(const BYTE* inData, DWORD inBytes,
-                    std::vector<BYTE>& outBuffer);
+                    ArenaVector<BYTE>& outBuffer);
 
     // Flush any remaining data in the resampler.
-    HRESULT flush(std::vector<BYTE>& outBuffer);
+    HRESULT flush(ArenaVector<BYTE>& outBuffer);
+
+    // Filter half length 1..60 (default 60, best quality); set before init()
+    void setQuality(int halfFilterLength) { m_halfFilterLength = halfFilterLength; }
 
     bool isNeeded() const { return m_needed; }
 
 private:
     HRESULT createMediaType(const WAVEFORMATEX* wfx, IMFMediaType** ppType);
-    HRESULT drainOutput(std::vector<BYTE>& outBuffer);
+    HRESULT drainOutput(ArenaVector<BYTE>& outBuffer);
+
+    // Backing memory of m_inBuffer/m_outBuffer; declared first so it is
+    // released after the COM objects that point into it
+    ArenaVector<BYTE>    m_inStorage;
+    ArenaVector<BYTE>    m_outStorage;
 
     ComPtr<IMFTransform> m_transform;
+    ComPtr<IMFSample>      m_inSample;
+    ComPtr<IMFMediaBuffer> m_inBuffer;
+    ComPtr<IMFSample>      m_outSample;
+    ComPtr<IMFMediaBuffer> m_outBuffer;
     bool                 m_needed = false;
+    int                  m_halfFilterLength = 60;
     DWORD                m_outputStreamId = 0;
 };
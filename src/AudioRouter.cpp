@@ -1,5 +1,23 @@
 #include "AudioRouter.h"
+#include "EndpointFactory.h"
+#include "RealtimeCheck.h"
+#include <chrono>
+#include <cmath>
+#include <cwchar>
+#ifdef _WIN32
 #include <mfapi.h>
+#endif
+
+static std::wstring hresultText(HRESULT hr) {
+    wchar_t buf[16];
+    swprintf(buf, 16, L"0x%08X", static_cast<unsigned>(hr));
+    return buf;
+}
+
+// Bytes the resampler stage takes from the capture ring per pass
+static constexpr size_t kResampleChunk = 4096;
+// How often the watchdog looks at the endpoints' period counts
+static constexpr UINT32 kWatchdogTickMs = 20;
 
 AudioRouter::AudioRouter() {}
 
@@ -7,77 +25,212 @@ AudioRouter::~AudioRouter() {
     stop();
 }
 
-HRESULT AudioRouter::start(const std::wstring& captureDeviceId,
-                            const std::wstring& renderDeviceId,
-                            bool exclusive) {
+HRESULT AudioRouter::start(const RouteConfig& config, WorkerPool* pool) {
     // Stop any existing session
     stop();
 
     m_errorMessage.clear();
+    HRESULT hr = S_OK;
+    // Phases timed below, and in the endpoint init paths, land in m_startup
+    StartupTrace::Scope trace(m_startup);
 
+#ifdef _WIN32
     // MFStartup for resampler
-    HRESULT hr = MFStartup(MF_VERSION);
+    {
+        StartupTimer timer("mf startup");
+        hr = MFStartup(MF_VERSION);
+    }
     if (FAILED(hr)) {
         m_errorMessage = L"MFStartup mislukt";
         m_state.store(RouterState::Error);
         return hr;
     }
+    m_mfStarted = true;
+#endif
 
     // Ring buffer: 500ms at 48kHz stereo 32-bit float = ~192KB
     // Generous size to absorb jitter between capture and render clocks
     const size_t ringBufferSize = 48000 * 8 * 500 / 1000;
-    m_captureToRender = std::make_unique<RingBuffer>(ringBufferSize);
+    m_captureToRender = std::make_unique<RingBuffer>(ringBufferSize, &m_arena);
 
-    // Init capture
-    m_capture = std::make_unique<WasapiCapture>();
-    hr = m_capture->init(captureDeviceId, exclusive, m_captureToRender.get());
-    if (FAILED(hr)) {
-        m_errorMessage = L"Capture init mislukt (0x" + std::to_wstring(hr) + L")";
+    // Both ends exclusive: choose their formats together. Without a plan
+    // each end negotiates on its own, as below.
+    FormatPlan plan;
+    bool planned = false;
+    {
+        StartupTimer timer("format plan");
+        planned = (planRouteFormats(config, plan) == S_OK);
+    }
+
+    // Capture and render init talk to different drivers and mostly wait on
+    // them, so they run side by side. Render cannot wait for the capture
+    // format it would like to match: it gets the planned format, or a guess
+    // at what capture will open, and is set up again below if the guess
+    // turns out wrong.
+    AudioFormat guess;
+    const bool guessed = !planned && predictCaptureFormat(config, guess);
+    const AudioFormat* renderPreferred = planned ? &plan.render : guessed ? &guess : nullptr;
+
+    HRESULT captureHr = S_OK;
+    std::thread captureInit([&] {
+#ifdef _WIN32
+        CoInitializeGuard comGuard(COINIT_MULTITHREADED);
+#endif
+        StartupTrace::Branch branch(m_startup);
+        StartupTimer timer("capture init");
+        captureHr = createCaptureEndpoint(config.capture, config.options, &m_arena,
+                                          m_captureToRender.get(), planned ? &plan.capture : nullptr, m_capture);
+    });
+    {
+        StartupTimer timer("render init");
+        hr = createRenderEndpoint(config.render, config.options, &m_arena, m_captureToRender.get(),
+                                  renderPreferred, m_render);
+    }
+    captureInit.join();
+
+    if (FAILED(captureHr)) {
+        m_errorMessage = L"Capture init mislukt (" + hresultText(captureHr) + L")";
         m_state.store(RouterState::Error);
-        return hr;
+        return captureHr;
     }
 
-    // Init render - pass capture format as preferred so render tries it first
-    // This maximizes the chance both devices use the same format (no resampling needed)
-    m_render = std::make_unique<WasapiRender>();
-    hr = m_render->init(renderDeviceId, exclusive, m_captureToRender.get(),
-                        &m_capture->format());
+    // Missed or no guess: render tries the capture format first after all,
+    // as a sequential start would have, so the route can still skip
+    // resampling (and backends that adopt the capture format can open)
+    const bool missed = !planned && !(guessed && guess == m_capture->format());
+    if (missed && renderTakesPreferredFormat(config.render) &&
+        (FAILED(hr) || m_render->format() != m_capture->format())) {
+        StartupTimer timer("render init again");
+        hr = createRenderEndpoint(config.render, config.options, &m_arena, m_captureToRender.get(),
+                                  &m_capture->format(), m_render);
+    }
     if (FAILED(hr)) {
-        m_errorMessage = L"Render init mislukt (0x" + std::to_wstring(hr) + L")";
+        m_errorMessage = L"Render init mislukt (" + hresultText(hr) + L")";
         m_state.store(RouterState::Error);
         return hr;
     }
+    m_render->setParamQueue(&m_params);
+
+    if (planned && (m_capture->format() != plan.capture || m_render->format() != plan.render)) {
+        // A device refused its planned format: plan again next time
+        forgetExclusivePlan(config.capture.device, config.render.device, config.options.formatCachePath);
+        m_formatPlan = describeFormatPair(m_capture->format(), m_render->format()) + " (plan not accepted)";
+    } else {
+        m_formatPlan = planned ? plan.reason : describeFormatPair(m_capture->format(), m_render->format());
+    }
 
     // Check if resampling is needed between capture and render formats
-    m_resampler = std::make_unique<AudioResampler>();
-    hr = m_resampler->init(&m_capture->format().Format, &m_render->format().Format);
+    if (m_capture->format() != m_render->format()) {
+        StartupTimer timer("resampler init");
+#ifdef _WIN32
+        WAVEFORMATEXTENSIBLE inFmt = waveFormatFromAudio(m_capture->format());
+        WAVEFORMATEXTENSIBLE outFmt = waveFormatFromAudio(m_render->format());
+        m_resampler = std::make_unique<AudioResampler>();
+        hr = m_resampler->init(&inFmt.Format, &outFmt.Format,
+                               static_cast<DWORD>(kResampleChunk), &m_arena);
+#else
+        hr = E_NOTIMPL;
+#endif
+        if (FAILED(hr)) {
+            m_errorMessage = L"Resampler init mislukt (" + hresultText(hr) + L")";
+            m_state.store(RouterState::Error);
+            return hr;
+        }
+    }
 
-    if (hr == S_FALSE || !m_resampler->isNeeded()) {
-        // No resampling needed - render reads directly from captureToRender (already set)
-        m_resampler.reset();
-        m_resamplerToRender.reset();
-    } else if (SUCCEEDED(hr)) {
+#ifdef _WIN32
+    if (m_resampler && m_resampler->isNeeded()) {
         // Resampling needed - redirect render to read from resampler output buffer
-        m_resamplerToRender = std::make_unique<RingBuffer>(ringBufferSize);
+        m_resamplerToRender = std::make_unique<RingBuffer>(ringBufferSize, &m_arena);
         m_render->setRingBuffer(m_resamplerToRender.get());
+
+        // Room for one chunk's output so process() never grows the vector
+        const double ratio = static_cast<double>(m_render->format().sampleRate * m_render->format().blockAlign())
+                           / (m_capture->format().sampleRate * m_capture->format().blockAlign());
+        m_resampleIn = ArenaVector<BYTE>(kResampleChunk, 0, ArenaAllocator<BYTE>(&m_arena));
+        m_resampleOut = ArenaVector<BYTE>(ArenaAllocator<BYTE>(&m_arena));
+        m_resampleOut.reserve(static_cast<size_t>(kResampleChunk * ratio) * 2 + 4096);
+        m_filterFlushed = false;
+        m_endForwarded = false;
+        m_pendingOutFrames = 0.0;
+
+        m_rtPolicy = config.options.realtime;
+        m_resamplerReport.clear();
+        m_resamplerRunning.store(true);
+        StartupTimer timer("resampler thread");
+        if (pool) {
+            m_pool = pool;
+            m_resamplerJob = pool->addJob([this] { return resamplerStep(); });
+        } else {
+            m_resamplerThread = std::thread(&AudioRouter::resamplerLoop, this);
+        }
     } else {
-        m_errorMessage = L"Resampler init mislukt (0x" + std::to_wstring(hr) + L")";
-        m_state.store(RouterState::Error);
-        return hr;
+        // No resampling needed - render reads directly from captureToRender (already set)
+        m_resampler.reset();
     }
+#else
+    // The pool only runs resampler jobs
+    (void)pool;
+#endif
 
-    // Start resampler thread if needed
-    if (m_resampler && m_resampler->isNeeded()) {
-        m_resamplerStopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-        m_resamplerRunning.store(true);
-        m_resamplerThread = CreateThread(nullptr, 0, resamplerThread, this, 0, nullptr);
+    if (!config.options.recordPath.empty()) {
+        const bool atCapture = config.options.recordTap == RecordTap::Capture;
+        m_recorder = std::make_unique<AudioRecorder>();
+        {
+            StartupTimer timer("recorder");
+            hr = m_recorder->start(config.options.recordPath,
+                                   atCapture ? m_capture->format() : m_render->format(),
+                                   config.options.recordBufferMs, &m_arena);
+        }
+        if (FAILED(hr)) {
+            // The resampler stage already runs and both endpoints are open
+            stop();
+            m_errorMessage = L"Opname init mislukt (" + hresultText(hr) + L")";
+            m_state.store(RouterState::Error);
+            return hr;
+        }
+        if (atCapture) m_capture->setRecorder(m_recorder.get());
+        else           m_render->setRecorder(m_recorder.get());
+    }
+
+    if (config.options.spectrum) {
+        const bool atCapture = config.options.spectrumTap == RecordTap::Capture;
+        m_analyzer = std::make_unique<SpectrumAnalyzer>();
+        {
+            StartupTimer timer("analyzer");
+            hr = m_analyzer->start(atCapture ? m_capture->format() : m_render->format(),
+                                   config.options.spectrumOptions, &m_arena);
+        }
+        if (FAILED(hr)) {
+            stop();
+            m_errorMessage = L"Spectrumanalyse init mislukt (" + hresultText(hr) + L")";
+            m_state.store(RouterState::Error);
+            return hr;
+        }
+        if (atCapture) m_capture->setAnalyzer(m_analyzer.get());
+        else           m_render->setAnalyzer(m_analyzer.get());
+    }
+
+    // Both ends see the same bytes only without a resampler in between
+    if (config.options.verify && m_capture->format() == m_render->format()) {
+        m_verifier = std::make_unique<PassthroughVerifier>();
+        m_verifier->init(&m_arena, m_startup.beganNs());
+        m_capture->setVerifier(m_verifier.get());
+        m_render->setVerifier(m_verifier.get());
     }
 
+    // All realtime buffers exist now
+    m_arenaBytes.store(m_arena.mappedBytes());
+    m_lockedBytes.store(m_arena.lockedBytes());
+
     // Start capture FIRST so the ring buffer fills up
-    hr = m_capture->start();
+    {
+        StartupTimer timer("capture start");
+        hr = m_capture->start();
+    }
     if (FAILED(hr)) {
-        m_errorMessage = L"Capture start mislukt";
         stop();
+        m_errorMessage = L"Capture start mislukt";
         m_state.store(RouterState::Error);
         return hr;
     }
@@ -87,39 +240,60 @@ HRESULT AudioRouter::start(const std::wstring& captureDeviceId,
     RingBuffer* renderSource = m_resamplerToRender ? m_resamplerToRender.get()
                                                    : m_captureToRender.get();
     size_t preBufferTarget = static_cast<size_t>(m_render->bufferFrames())
-                             * m_render->format().Format.nBlockAlign * 2;
-    for (int wait = 0; wait < 500; ++wait) { // max 500ms wachten
-        if (renderSource->availableToRead() >= preBufferTarget)
-            break;
-        Sleep(1);
+                             * m_render->format().blockAlign() * 2;
+    {
+        StartupTimer timer("prebuffer");
+        for (int wait = 0; wait < 500; ++wait) { // max 500ms wachten
+            if (renderSource->availableToRead() >= preBufferTarget)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
     }
 
-    hr = m_render->start();
+    {
+        StartupTimer timer("render start");
+        hr = m_render->start();
+    }
     if (FAILED(hr)) {
-        m_errorMessage = L"Render start mislukt";
         stop();
+        m_errorMessage = L"Render start mislukt";
         m_state.store(RouterState::Error);
         return hr;
     }
 
+    // Supervise both ends from here on
+    const INT64 now = startupClockNs();
+    m_captureWatchdog.reset(m_capture->periodMs(), now);
+    m_renderWatchdog.reset(m_render->periodMs(), now);
+    m_watchdogStop = false;
+    m_watchdogThread = std::thread(&AudioRouter::watchdogLoop, this);
+
     m_state.store(RouterState::Running);
     return S_OK;
 }
 
 void AudioRouter::stop() {
+    // The watchdog must not reopen anything while the route comes down
+    if (m_watchdogThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_watchdogMutex);
+            m_watchdogStop = true;
+        }
+        m_watchdogWake.notify_all();
+        m_watchdogThread.join();
+    }
+
     // Stop resampler thread
     if (m_resamplerRunning.load()) {
         m_resamplerRunning.store(false);
-        if (m_resamplerStopEvent) SetEvent(m_resamplerStopEvent);
-        if (m_resamplerThread) {
-            WaitForSingleObject(m_resamplerThread, 5000);
-            CloseHandle(m_resamplerThread);
-            m_resamplerThread = nullptr;
-        }
-        if (m_resamplerStopEvent) {
-            CloseHandle(m_resamplerStopEvent);
-            m_resamplerStopEvent = nullptr;
-        }
+    }
+    if (m_resamplerThread.joinable()) {
+        m_resamplerThread.join();
+    }
+    if (m_pool) {
+        m_pool->removeJob(m_resamplerJob);
+        m_pool = nullptr;
+        m_resamplerJob = 0;
     }
 
     if (m_capture) {
@@ -131,67 +305,271 @@ void AudioRouter::stop() {
         m_render->stop();
         m_render.reset();
     }
+    // Changes sent too late for the render thread die with the route
+    m_params.clear();
+
+    // Both endpoints are stopped: the writer can drain and close the file
+    if (m_recorder) {
+        m_recorder->stop();
+        m_recorder.reset();
+    }
+    if (m_analyzer) {
+        m_analyzer->stop();
+        m_analyzer.reset();
+    }
+    m_verifier.reset();
 
+#ifdef _WIN32
     m_resampler.reset();
+#endif
     m_captureToRender.reset();
     m_resamplerToRender.reset();
+    m_resampleIn = ArenaVector<BYTE>();
+    m_resampleOut = ArenaVector<BYTE>();
 
-    MFShutdown();
+    // Nothing points into the arena anymore
+    m_arena.release();
+    m_arenaBytes.store(0);
+    m_lockedBytes.store(0);
 
+#ifdef _WIN32
+    if (m_mfStarted) {
+        MFShutdown();
+        m_mfStarted = false;
+    }
+#endif
+
+    m_formatPlan.clear();
     m_state.store(RouterState::Stopped);
 }
 
 RouterStatus AudioRouter::getStatus() const {
+    std::lock_guard<std::mutex> lock(m_endpointMutex);
     RouterStatus status;
     status.state = m_state.load();
     status.errorMessage = m_errorMessage;
+    status.arenaBytes = m_arenaBytes.load();
+    status.lockedBytes = m_lockedBytes.load();
+    status.formatPlan = m_formatPlan;
+    status.startup = m_startup.report(m_render ? m_render->firstPeriodNs() : 0);
+    status.captureWatchdog = m_captureWatchdog.stats();
+    status.renderWatchdog = m_renderWatchdog.stats();
 
-    if (m_capture) {
+    if (m_capture && !m_captureRecovering) {
         status.captureFormat = m_capture->format();
         status.captureBufferFrames = m_capture->bufferFrames();
+        status.gateEnabled = m_capture->gateEnabled();
+        status.gateState = m_capture->gateState();
+        status.captureThread = m_capture->threadReport();
+        status.captureTransport = m_capture->transportStats();
+        status.captureLevels = m_capture->levels();
+        status.captureClock = m_capture->clockEstimate();
     }
-    if (m_render) {
+    if (m_render && !m_renderRecovering) {
         status.renderFormat = m_render->format();
         status.renderBufferFrames = m_render->bufferFrames();
         status.underruns = m_render->underrunCount();
+        status.concealedFrames = m_render->concealedFrameCount();
+        status.finished = m_render->isDrained();
+        status.renderThread = m_render->threadReport();
+        status.renderTransport = m_render->transportStats();
+        status.renderLevels = m_render->levels();
+        status.insertStages = m_render->insertStages();
+        status.renderClock = m_render->clockEstimate();
+    }
+    status.clockRatio = clockRatio(status.captureClock, status.renderClock);
+    if (m_recorder) {
+        status.recording = m_recorder->isRecording();
+        status.recordFailed = m_recorder->writeFailed();
+        status.recordFormat = m_recorder->format();
+        status.recordedFrames = m_recorder->recordedFrames();
+        status.recordDroppedFrames = m_recorder->droppedFrames();
+    }
+    if (m_verifier) status.verify = m_verifier->stats();
+    if (m_analyzer) {
+        status.spectrum = m_analyzer->isRunning();
+        status.spectrumFrames = m_analyzer->frames();
+        status.spectrumDropped = m_analyzer->droppedSegments();
+        status.spectrumPeakHz = m_analyzer->peakHz();
+        status.spectrumPeakDb = m_analyzer->peakDb();
     }
+#ifdef _WIN32
     if (m_resampler) {
         status.resamplerActive = m_resampler->isNeeded();
+        status.resamplerThread = m_pool ? m_pool->threadReport() : m_resamplerReport.load();
     }
+#endif
 
     return status;
 }
 
-DWORD WINAPI AudioRouter::resamplerThread(LPVOID param) {
+bool AudioRouter::getSpectrum(SpectrumFrame& frame) const {
+    return m_analyzer && m_analyzer->latest(frame);
+}
+
+HRESULT AudioRouter::sendParam(const ParamCommand& command) {
+    if (m_params.send(command)) return S_OK;
+    delete command.params;
+    return E_PENDING;
+}
+
+HRESULT AudioRouter::setOutputGain(float gainDb) {
+    if (m_state.load() != RouterState::Running || !m_render) return E_NOT_VALID_STATE;
+    ParamCommand command;
+    command.id = ParamId::OutputGain;
+    command.value = static_cast<float>(std::pow(10.0, gainDb / 20.0));
+    return sendParam(command);
+}
+
+HRESULT AudioRouter::setMute(bool mute) {
+    if (m_state.load() != RouterState::Running || !m_render) return E_NOT_VALID_STATE;
+    ParamCommand command;
+    command.id = ParamId::Mute;
+    command.value = mute ? 1.0f : 0.0f;
+    return sendParam(command);
+}
+
+HRESULT AudioRouter::setMatrixGain(UINT32 output, UINT32 input, float gain) {
+    if (m_state.load() != RouterState::Running || !m_render) return E_NOT_VALID_STATE;
+    const UINT32 channels = m_render->format().channels;
+    if (output >= channels || input >= channels) return E_INVALIDARG;
+    ParamCommand command;
+    command.id = ParamId::MatrixGain;
+    command.index = output;
+    command.index2 = input;
+    command.value = gain;
+    return sendParam(command);
+}
+
+HRESULT AudioRouter::setInsert(UINT32 index, const DspStageConfig& stage) {
+    if (m_state.load() != RouterState::Running || !m_render) return E_NOT_VALID_STATE;
+    ParamCommand command;
+    command.id = ParamId::Insert;
+    command.index = index;
+    // Coefficients are designed here, on the caller's thread
+    command.params = m_render->prepareInsert(index, stage);
+    if (!command.params) return E_INVALIDARG;
+    return sendParam(command);
+}
+
+void AudioRouter::watchdogLoop() {
+#ifdef _WIN32
+    // recover() reopens WASAPI clients from this thread
     CoInitializeGuard comGuard(COINIT_MULTITHREADED);
-    auto* self = static_cast<AudioRouter*>(param);
-    self->resamplerLoop();
-    return 0;
+#endif
+    std::unique_lock<std::mutex> lock(m_watchdogMutex);
+    while (!m_watchdogWake.wait_for(lock, std::chrono::milliseconds(kWatchdogTickMs),
+                                    [this] { return m_watchdogStop; })) {
+        lock.unlock();
+        superviseEndpoints();
+        lock.lock();
+    }
+}
+
+// A reopen can take hundreds of ms, so it runs without m_endpointMutex;
+// getStatus() leaves the endpoint alone meanwhile
+void AudioRouter::superviseEndpoints() {
+    // A finished file has nothing more to deliver
+    if (!m_capture->isFinished()) {
+        StallWatchdog::Action action = checkEndpoint(m_captureWatchdog, m_capture->periodCount(),
+                                                     m_captureRecovering, L"Capture herstel mislukt");
+        if (action == StallWatchdog::Action::GiveUp) return;
+        if (action == StallWatchdog::Action::Recover)
+            endRecovery(m_captureWatchdog, m_captureRecovering, m_capture->recover());
+    }
+
+    StallWatchdog::Action action = checkEndpoint(m_renderWatchdog, m_render->periodCount(),
+                                                 m_renderRecovering, L"Render herstel mislukt");
+    if (action == StallWatchdog::Action::Recover)
+        endRecovery(m_renderWatchdog, m_renderRecovering, m_render->recover());
+}
+
+// Under m_endpointMutex: on Recover the endpoint is marked as recovering
+// and the caller reopens it; GiveUp puts the router in Error
+StallWatchdog::Action AudioRouter::checkEndpoint(StallWatchdog& watchdog, UINT64 periods,
+                                                 bool& recovering, const wchar_t* giveUpMessage) {
+    std::lock_guard<std::mutex> lock(m_endpointMutex);
+    // Also GiveUp when the router left Running, so the caller stops
+    if (m_state.load() != RouterState::Running) return StallWatchdog::Action::GiveUp;
+    StallWatchdog::Action action = watchdog.check(startupClockNs(), periods);
+    if (action == StallWatchdog::Action::GiveUp) {
+        m_errorMessage = giveUpMessage;
+        m_state.store(RouterState::Error);
+    }
+    if (action == StallWatchdog::Action::Recover) recovering = true;
+    return action;
+}
+
+void AudioRouter::endRecovery(StallWatchdog& watchdog, bool& recovering, HRESULT hr) {
+    std::lock_guard<std::mutex> lock(m_endpointMutex);
+    watchdog.recovered(startupClockNs(), hr);
+    recovering = false;
 }
 
 void AudioRouter::resamplerLoop() {
-    // Process audio from captureToRender → resampler → resamplerToRender
-    const size_t chunkSize = 4096; // Process in 4KB chunks
-    std::vector<BYTE> inBuf(chunkSize);
-    std::vector<BYTE> outBuf;
+#ifdef _WIN32
+    CoInitializeGuard comGuard(COINIT_MULTITHREADED);
+#endif
+    RealtimeThreadScope rt(m_rtPolicy, ThreadRole::Worker);
+    m_resamplerReport.publish(rt.report());
 
     while (m_resamplerRunning.load(std::memory_order_relaxed)) {
-        size_t avail = m_captureToRender->availableToRead();
-        if (avail == 0) {
-            // Wait a short time for data
-            WaitForSingleObject(m_resamplerStopEvent, 1);
-            continue;
+        UINT32 waitMs = resamplerStep();
+        if (waitMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
+    }
+}
+
+UINT32 AudioRouter::resamplerStep() {
+#ifdef _WIN32
+    RealtimeSection section("resampler");
+
+    // Process audio from captureToRender → resampler → resamplerToRender
+    const AudioFormat inFmt  = m_capture->format();
+    const AudioFormat outFmt = m_render->format();
+    const double ratio = static_cast<double>(outFmt.sampleRate) / inFmt.sampleRate;
+
+    bool silentRun = false;
+    size_t run = m_captureToRender->nextRun(silentRun, m_resampleIn.size());
+    if (run == 0) {
+        // End of a finite source: pass on the filter tail and the end of stream
+        if (!m_endForwarded && m_captureToRender->drained()) {
+            m_resampleOut.clear();
+            if (SUCCEEDED(m_resampler->flush(m_resampleOut)) && !m_resampleOut.empty())
+                m_resamplerToRender->write(m_resampleOut.data(), m_resampleOut.size());
+            m_resamplerToRender->markEnd();
+            m_endForwarded = true;
         }
+        // Wait a short time for data; poll less often while the gate is idle
+        return (m_capture->gateState() == GateState::Idle) ? 5 : 1;
+    }
 
-        size_t toRead = (std::min)(avail, chunkSize);
-        size_t bytesRead = m_captureToRender->read(inBuf.data(), toRead);
+    // Once one chunk of real zeros has flushed the filter, further silence
+    // bypasses the resampler and is forwarded as rate-converted markers
+    if (silentRun && m_filterFlushed) {
+        size_t skipped = m_captureToRender->skip(run);
+        m_pendingOutFrames += static_cast<double>(skipped / inFmt.blockAlign()) * ratio;
+        size_t outFrames = static_cast<size_t>(m_pendingOutFrames);
+        m_pendingOutFrames -= static_cast<double>(outFrames);
+        if (outFrames > 0)
+            m_resamplerToRender->writeSilence(outFrames * outFmt.blockAlign());
+        return 0;
+    }
+    m_filterFlushed = silentRun;
+
+    size_t toRead = (std::min)(run, m_resampleIn.size());
+    size_t bytesRead = m_captureToRender->read(m_resampleIn.data(), toRead);
 
-        if (bytesRead > 0) {
-            outBuf.clear();
-            HRESULT hr = m_resampler->process(inBuf.data(), static_cast<DWORD>(bytesRead), outBuf);
-            if (SUCCEEDED(hr) && !outBuf.empty()) {
-                m_resamplerToRender->write(outBuf.data(), outBuf.size());
-            }
+    if (bytesRead > 0) {
+        m_resampleOut.clear();
+        HRESULT hr = m_resampler->process(m_resampleIn.data(), static_cast<DWORD>(bytesRead),
+                                          m_resampleOut);
+        if (SUCCEEDED(hr) && !m_resampleOut.empty()) {
+            m_resamplerToRender->write(m_resampleOut.data(), m_resampleOut.size());
         }
     }
+    return 0;
+#else
+    return 10;
+#endif
 }
@@ -1,16 +1,27 @@
 #pragma once
 
-#include <windows.h>
 #include <string>
 #include <memory>
 #include <atomic>
-#include "WasapiCapture.h"
-#include "WasapiRender.h"
-#include "AudioResampler.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Platform.h"
+#include "AudioEndpoint.h"
+#include "RouteConfig.h"
 #include "RingBuffer.h"
+#include "WorkerPool.h"
+#include "StartupTrace.h"
+#include "StallWatchdog.h"
+#ifdef _WIN32
+#include "AudioResampler.h"
+#endif
 
 enum class RouterState {
     Stopped,
+    Starting,   // reported by RouteManager while start() runs
+    Stopping,   // ... and while stop() runs
     Running,
     Error
 };
@@ -18,12 +29,58 @@ enum class RouterState {
 struct RouterStatus {
     RouterState state = RouterState::Stopped;
     std::wstring errorMessage;
-    WAVEFORMATEXTENSIBLE captureFormat = {};
-    WAVEFORMATEXTENSIBLE renderFormat = {};
+    AudioFormat captureFormat;
+    AudioFormat renderFormat;
     UINT32 captureBufferFrames = 0;
     UINT32 renderBufferFrames = 0;
+    bool   finished = false;      // a finite source has been played to the end
     UINT64 underruns = 0;
+    UINT64 concealedFrames = 0;   // frames synthesized by render-side concealment
     bool   resamplerActive = false;
+    // How the two formats were chosen and what converting between them takes
+    std::string formatPlan;
+    // Time spent in each phase of the last start(), and until the first render period
+    StartupReport startup;
+    bool      gateEnabled = false;
+    GateState gateState = GateState::Active;
+    // Scheduling each pipeline thread actually obtained
+    RealtimeReport captureThread;
+    RealtimeReport renderThread;
+    RealtimeReport resamplerThread;   // shared pool worker when run from a pool
+    // Realtime buffers: prefaulted arena size and how much of it is locked in RAM
+    UINT64 arenaBytes = 0;
+    UINT64 lockedBytes = 0;
+    // Recording tap
+    bool        recording = false;
+    bool        recordFailed = false;   // the disk refused a write; audio since is dropped
+    AudioFormat recordFormat;
+    UINT64      recordedFrames = 0;
+    UINT64      recordDroppedFrames = 0;
+    // Render-side insert chain
+    UINT32      insertStages = 0;
+    // Spectrum analyzer tap
+    bool        spectrum = false;
+    UINT64      spectrumFrames = 0;
+    UINT64      spectrumDropped = 0;    // segments the analyzer was too slow for
+    float       spectrumPeakHz = 0.0f;  // strongest bin of the latest frame
+    float       spectrumPeakDb = 0.0f;
+    // Signal levels at the capture and render ends of the route
+    LevelSnapshot captureLevels;
+    LevelSnapshot renderLevels;
+    // Network backends (RTP)
+    TransportStats captureTransport;
+    TransportStats renderTransport;
+    // Device clock rates measured from position timestamps, and capture
+    // against render: what drift compensation has to make up
+    ClockEstimate captureClock;
+    ClockEstimate renderClock;
+    ClockRatio    clockRatio;
+    // Bit-exact passthrough check; inactive when not asked for or when the
+    // route converts
+    VerifyStats verify;
+    // Stalls of each endpoint and how the watchdog recovered from them
+    WatchdogStats captureWatchdog;
+    WatchdogStats renderWatchdog;
 };
 
 class AudioRouter {
@@ -31,30 +88,96 @@ public:
     AudioRouter();
     ~AudioRouter();
 
-    HRESULT start(const std::wstring& captureDeviceId,
-                  const std::wstring& renderDeviceId,
-                  bool exclusive);
+    // With a pool the resampler runs as a job on the shared workers,
+    // otherwise the route gets a thread of its own. The pool must outlive
+    // the running route.
+    HRESULT start(const RouteConfig& config, WorkerPool* pool = nullptr);
     void    stop();
 
     RouterStatus getStatus() const;
+    // Latest analyzer frame; false without a spectrum tap or before the first frame
+    bool getSpectrum(SpectrumFrame& frame) const;
+
+    // Live changes, applied by the render thread at its next period and
+    // ramped there. E_NOT_VALID_STATE when not running, E_INVALIDARG for a
+    // channel or insert the route does not have (or an insert of another
+    // type), E_PENDING when the queue is full.
+    HRESULT setOutputGain(float gainDb);
+    HRESULT setMute(bool mute);
+    // Linear gain from input channel to output channel (identity at start)
+    HRESULT setMatrixGain(UINT32 output, UINT32 input, float gain);
+    // Insert 'index' in config order gets new settings of the same type
+    HRESULT setInsert(UINT32 index, const DspStageConfig& stage);
 
 private:
-    static DWORD WINAPI resamplerThread(LPVOID param);
-    void resamplerLoop();
+    void   resamplerLoop();
+    // One pass of the resampler stage; returns 0 after doing work, otherwise
+    // the number of milliseconds to wait before polling again
+    UINT32 resamplerStep();
+    HRESULT sendParam(const ParamCommand& command);
+    void    watchdogLoop();
+    // One watchdog pass over both endpoints
+    void    superviseEndpoints();
+    StallWatchdog::Action checkEndpoint(StallWatchdog& watchdog, UINT64 periods,
+                                        bool& recovering, const wchar_t* giveUpMessage);
+    void    endRecovery(StallWatchdog& watchdog, bool& recovering, HRESULT hr);
 
-    std::unique_ptr<WasapiCapture>  m_capture;
-    std::unique_ptr<WasapiRender>   m_render;
-    std::unique_ptr<AudioResampler> m_resampler;
+    // Every buffer touched on the audio threads; declared first so that it
+    // outlives all stages that point into it
+    AudioArena                       m_arena;
+
+    std::unique_ptr<CaptureEndpoint> m_capture;
+    std::unique_ptr<RenderEndpoint>  m_render;
+#ifdef _WIN32
+    std::unique_ptr<AudioResampler>  m_resampler;
+    bool                             m_mfStarted = false;
+#endif
 
     // Ring buffer between capture and render (or capture and resampler)
     std::unique_ptr<RingBuffer> m_captureToRender;
     // Ring buffer between resampler and render (only when resampling)
     std::unique_ptr<RingBuffer> m_resamplerToRender;
+    // Recording tap on the capture or render endpoint (optional)
+    std::unique_ptr<AudioRecorder> m_recorder;
+    // Spectrum analyzer tap (optional)
+    std::unique_ptr<SpectrumAnalyzer> m_analyzer;
+    // Passthrough check between capture and render (optional)
+    std::unique_ptr<PassthroughVerifier> m_verifier;
+    // Live parameter changes for the render endpoint
+    ParamQueue                        m_params;
 
-    HANDLE m_resamplerThread = nullptr;
-    HANDLE m_resamplerStopEvent = nullptr;
+    std::thread       m_resamplerThread;
     std::atomic<bool> m_resamplerRunning{false};
+    WorkerPool*       m_pool = nullptr;
+    WorkerPool::JobId m_resamplerJob = 0;
+    RealtimePolicy     m_rtPolicy;
+    RealtimeReportSlot m_resamplerReport;
+
+    // Resampler stage state, only touched by whichever thread runs the step
+    ArenaVector<BYTE> m_resampleIn;
+    ArenaVector<BYTE> m_resampleOut;
+    bool              m_filterFlushed = false;
+    bool              m_endForwarded = false;
+    double            m_pendingOutFrames = 0.0;
+
+    // Stall watchdog: reopens an endpoint whose periods stopped
+    std::thread             m_watchdogThread;
+    std::mutex              m_watchdogMutex;
+    std::condition_variable m_watchdogWake;
+    bool                    m_watchdogStop = false;
+    StallWatchdog           m_captureWatchdog;
+    StallWatchdog           m_renderWatchdog;
+    // Held by the watchdog while it checks an endpoint, and by getStatus()
+    // while it reads them. Not held across a reopen: the endpoint is marked
+    // as recovering instead and getStatus() skips it.
+    mutable std::mutex      m_endpointMutex;
+    bool                    m_captureRecovering = false;   // guarded by m_endpointMutex
+    bool                    m_renderRecovering = false;
 
     std::atomic<RouterState> m_state{RouterState::Stopped};
     std::wstring             m_errorMessage;
+    std::string              m_formatPlan;
+    StartupTrace             m_startup;
+    std::atomic<UINT64>      m_arenaBytes{0};
+    std::atomic<UINT64>      m_lockedBytes{0};
 };
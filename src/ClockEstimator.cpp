@@ -0,0 +1,113 @@
+#include "ClockEstimator.h"
+#include <cmath>
+
+// Two-sided 95% quantile of the normal distribution
+static constexpr double kZ95 = 1.96;
+
+void ClockEstimator::reset(UINT32 nominalRate) {
+    m_nominalRate.store(nominalRate, std::memory_order_relaxed);
+    m_written.store(0, std::memory_order_release);
+    m_bucketCount = 0;
+}
+
+void ClockEstimator::observe(UINT64 position, INT64 timeNs) {
+    // Keep the window long rather than dense: consecutive periods are
+    // averaged into one slot per kSpacingMs, which takes the timestamp jitter
+    // down before the fit sees it
+    if (m_bucketCount == 0) {
+        m_bucketPosition = position;
+        m_bucketNs = timeNs;
+        m_sumPosition = 0.0;
+        m_sumNs = 0.0;
+    }
+    m_sumPosition += static_cast<double>(position - m_bucketPosition);
+    m_sumNs += static_cast<double>(timeNs - m_bucketNs);
+    ++m_bucketCount;
+    if (static_cast<double>(timeNs - m_bucketNs) < kSpacingMs * 1e6) return;
+
+    const UINT64 index = m_written.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[index % kCapacity];
+    // Pairs with the fence in estimate(): a reader that sees this slot's new
+    // contents also sees m_written == index and skips the slot
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.position.store(m_bucketPosition + std::llround(m_sumPosition / m_bucketCount), std::memory_order_relaxed);
+    slot.timeNs.store(m_bucketNs + std::llround(m_sumNs / m_bucketCount), std::memory_order_relaxed);
+    m_written.store(index + 1, std::memory_order_release);
+    m_bucketCount = 0;
+}
+
+ClockEstimate ClockEstimator::estimate() const {
+    ClockEstimate e;
+    const UINT32 nominal = m_nominalRate.load(std::memory_order_relaxed);
+    const UINT64 before = m_written.load(std::memory_order_acquire);
+    const UINT64 first = (before > kCapacity) ? before - kCapacity : 0;
+
+    UINT64 positions[kCapacity];
+    INT64  times[kCapacity];
+    for (UINT64 i = first; i < before; ++i) {
+        const Slot& slot = m_slots[i % kCapacity];
+        positions[i - first] = slot.position.load(std::memory_order_relaxed);
+        times[i - first] = slot.timeNs.load(std::memory_order_relaxed);
+    }
+
+    // Slots the producer reused while they were copied are discarded. The
+    // fence keeps the copies above from moving past the second load.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const UINT64 after = m_written.load(std::memory_order_relaxed);
+    if (after < before) return e;   // reset meanwhile
+    const UINT64 safeFirst = (after >= kCapacity) ? after - kCapacity + 1 : 0;
+    const size_t skip = (safeFirst > first) ? static_cast<size_t>(safeFirst - first) : 0;
+    const size_t count = static_cast<size_t>(before - first);
+    if (nominal == 0 || count < skip + kMinObservations) return e;
+
+    // Least squares over positions relative to the oldest sample, in seconds
+    // and frames, so the sums stay well inside double precision
+    const size_t n = count - skip;
+    const UINT64 p0 = positions[skip];
+    const INT64  t0 = times[skip];
+    double meanT = 0.0, meanP = 0.0;
+    for (size_t i = skip; i < count; ++i) {
+        meanT += static_cast<double>(times[i] - t0) / 1e9;
+        meanP += static_cast<double>(positions[i] - p0);
+    }
+    meanT /= n;
+    meanP /= n;
+
+    double sxx = 0.0, sxy = 0.0;
+    for (size_t i = skip; i < count; ++i) {
+        const double dt = static_cast<double>(times[i] - t0) / 1e9 - meanT;
+        const double dp = static_cast<double>(positions[i] - p0) - meanP;
+        sxx += dt * dt;
+        sxy += dt * dp;
+    }
+    if (sxx <= 0.0) return e;
+    const double slope = sxy / sxx;
+
+    double sse = 0.0;
+    for (size_t i = skip; i < count; ++i) {
+        const double dt = static_cast<double>(times[i] - t0) / 1e9 - meanT;
+        const double dp = static_cast<double>(positions[i] - p0) - meanP;
+        const double r = dp - slope * dt;
+        sse += r * r;
+    }
+    const double slopeError = std::sqrt(sse / static_cast<double>(n - 2) / sxx);
+
+    e.valid = true;
+    e.rateHz = slope;
+    e.ppm = (slope / nominal - 1.0) * 1e6;
+    e.ppmBound = kZ95 * slopeError / nominal * 1e6;
+    e.observations = static_cast<UINT32>(n);
+    e.windowSec = static_cast<double>(times[count - 1] - t0) / 1e9;
+    return e;
+}
+
+ClockRatio clockRatio(const ClockEstimate& capture, const ClockEstimate& render) {
+    ClockRatio r;
+    if (!capture.valid || !render.valid) return r;
+    r.valid = true;
+    r.ratio = (1.0 + capture.ppm * 1e-6) / (1.0 + render.ppm * 1e-6);
+    r.ppm = (r.ratio - 1.0) * 1e6;
+    // Independent errors of the two slopes
+    r.ppmBound = std::sqrt(capture.ppmBound * capture.ppmBound + render.ppmBound * render.ppmBound);
+    return r;
+}
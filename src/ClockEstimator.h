@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include "Platform.h"
+
+// The rate a device clock actually runs at, from (frame position, time)
+// pairs: the slope of a least-squares line through the last seconds of
+// observations. The bound is the 95% confidence half-width of the slope, so
+// it shrinks as the window fills and grows with timestamp jitter.
+struct ClockEstimate {
+    bool   valid = false;       // enough observations for a slope
+    double rateHz = 0.0;        // frames per second of the reference clock
+    double ppm = 0.0;           // deviation from the nominal rate
+    double ppmBound = 0.0;      // +- at 95% confidence
+    UINT32 observations = 0;    // in the window
+    double windowSec = 0.0;     // time the window spans
+};
+
+// Capture clock relative to render clock, each against its nominal rate:
+// positive when capture delivers faster than render consumes
+struct ClockRatio {
+    bool   valid = false;
+    double ratio = 1.0;
+    double ppm = 0.0;
+    double ppmBound = 0.0;
+};
+
+ClockRatio clockRatio(const ClockEstimate& capture, const ClockEstimate& render);
+
+// Observations come from one thread (the device's period thread) without
+// locks or allocation; estimate() runs on any other thread and works on a
+// copy, discarding slots the producer overwrote meanwhile.
+class ClockEstimator {
+public:
+    // Slots; with kSpacingMs between kept observations about 12 s of history
+    static constexpr size_t kCapacity = 256;
+    // Observations within this span are averaged into one slot
+    static constexpr double kSpacingMs = 50.0;
+    // Observations before a slope is reported
+    static constexpr UINT32 kMinObservations = 8;
+
+    // Producer side, before the period thread starts
+    void reset(UINT32 nominalRate);
+    // Producer side: 'position' frames had passed the device at 'timeNs'
+    // (startupClockNs() scale, or any monotonic ns clock used consistently)
+    void observe(UINT64 position, INT64 timeNs);
+
+    ClockEstimate estimate() const;
+
+private:
+    struct Slot {
+        std::atomic<UINT64> position{0};
+        std::atomic<INT64>  timeNs{0};
+    };
+
+    std::array<Slot, kCapacity> m_slots;
+    std::atomic<UINT64> m_written{0};   // samples ever written
+    std::atomic<UINT32> m_nominalRate{0};
+    // Slot being averaged; producer only
+    UINT64 m_bucketPosition = 0;
+    INT64  m_bucketNs = 0;
+    double m_sumPosition = 0.0;
+    double m_sumNs = 0.0;
+    UINT32 m_bucketCount = 0;
+};
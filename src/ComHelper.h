@@ -1,19 +1,12 @@
 #pragma once
 
+#include "Platform.h"
 #include <wrl/client.h>
 #include <objbase.h>
 #include <cstdio>
 
 using Microsoft::WRL::ComPtr;
 
-#define RETURN_IF_FAILED(hr)                                    \
-    do {                                                        \
-        HRESULT _hr = (hr);                                     \
-        if (FAILED(_hr)) {                                      \
-            return _hr;                                         \
-        }                                                       \
-    } while (false)
-
 struct CoInitializeGuard {
     HRESULT hr;
     CoInitializeGuard(DWORD model = COINIT_MULTITHREADED) {
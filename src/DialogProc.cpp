@@ -1,13 +1,16 @@
 #include "DialogProc.h"
 #include "resource.h"
 #include "DeviceEnumerator.h"
-#include "AudioRouter.h"
+#include "RouteManager.h"
+#include "FormatPlanner.h"
 #include <commctrl.h>
 #include <windowsx.h>
 #include <dwmapi.h>
 #include <uxtheme.h>
 #include <vssym32.h>
+#include <algorithm>
 #include <cstdio>
+#include <cwchar>
 #include <vector>
 #include <string>
 #include <ks.h>
@@ -48,7 +51,9 @@ static constexpr int PANEL_RADIUS = 12;
 // ── State ──────────────────────────────────────────────────────────
 static std::vector<AudioDeviceInfo> g_captureDevices;
 static std::vector<AudioDeviceInfo> g_renderDevices;
-static std::unique_ptr<AudioRouter> g_router;
+// The route chosen in the dialog, plus any extra routes from routes.ini
+static std::unique_ptr<RouteManager> g_routes;
+static const char* const kMainRoute = "main";
 static HFONT g_fontNormal = nullptr;
 static HFONT g_fontBold   = nullptr;
 static HFONT g_fontSmall  = nullptr;
@@ -94,7 +99,8 @@ static LRESULT CALLBACK BtnSubclassProc(HWND, UINT, WPARAM, LPARAM, UINT_PTR, DW
 static void populateDevices(HWND hWnd);
 static void onApply(HWND hWnd);
 static void onStop(HWND hWnd);
-static std::wstring formatInfo(const wchar_t* prefix, const WAVEFORMATEXTENSIBLE& fmt, UINT32 bufFrames);
+static std::wstring formatInfo(const wchar_t* prefix, const AudioFormat& fmt, UINT32 bufFrames);
+static void appendLevels(wchar_t* buf, size_t size, const LevelSnapshot& levels);
 
 // ── Helper: dark mode title bar (Windows 10 1809+) ────────────────
 static void enableDarkTitleBar(HWND hWnd) {
@@ -166,6 +172,7 @@ struct AppSettings {
     bool autoStart = false;
     bool minimizeToTray = false;
     bool startWithWindows = false;
+    RouteOptions routeOptions;
 };
 
 static std::wstring getSettingsPath() {
@@ -192,6 +199,53 @@ static AppSettings loadSettings() {
     s.minimizeToTray = GetPrivateProfileIntW(L"Audio", L"MinimizeToTray", 0, path.c_str()) != 0;
     s.startWithWindows = GetPrivateProfileIntW(L"Audio", L"StartWithWindows", 0, path.c_str()) != 0;
 
+    // Activity gate (not exposed in the UI; edit settings.ini)
+    s.routeOptions.gateEnabled = GetPrivateProfileIntW(L"Audio", L"ActivityGate", 0, path.c_str()) != 0;
+    s.routeOptions.gateThresholdDb = static_cast<float>(
+        GetPrivateProfileIntW(L"Audio", L"GateThresholdDb", -90, path.c_str()));
+    s.routeOptions.gateHoldMs = GetPrivateProfileIntW(L"Audio", L"GateHoldMs", 500, path.c_str());
+
+    // Audio thread scheduling (settings.ini only)
+    GetPrivateProfileStringW(L"Audio", L"CpuAffinity", L"", buf, 512, path.c_str());
+    parseCpuList(wideToUtf8(buf), s.routeOptions.realtime.cpuMask);
+    s.routeOptions.realtime.flushDenormals =
+        GetPrivateProfileIntW(L"Audio", L"FlushDenormals", 1, path.c_str()) != 0;
+
+    // Recording tap (settings.ini only)
+    GetPrivateProfileStringW(L"Audio", L"RecordPath", L"", buf, 512, path.c_str());
+    s.routeOptions.recordPath = wideToUtf8(buf);
+    GetPrivateProfileStringW(L"Audio", L"RecordTap", L"render", buf, 512, path.c_str());
+    parseRecordTap(wideToUtf8(buf), s.routeOptions.recordTap);
+    s.routeOptions.recordBufferMs = GetPrivateProfileIntW(L"Audio", L"RecordBufferMs", 2000, path.c_str());
+
+    // Insert chain, Insert1, Insert2, ... in order (settings.ini only)
+    for (int i = 1;; ++i) {
+        wchar_t key[32];
+        swprintf_s(key, L"Insert%d", i);
+        GetPrivateProfileStringW(L"Audio", key, L"", buf, 512, path.c_str());
+        DspStageConfig stage;
+        if (!buf[0] || !parseInsertStage(wideToUtf8(buf), stage)) break;
+        s.routeOptions.inserts.push_back(stage);
+    }
+    // Exclusive-mode format cache, next to settings.ini
+    s.routeOptions.formatCachePath = wideToUtf8(path.substr(0, path.find_last_of(L'\\') + 1) + L"formatcache.ini");
+
+    GetPrivateProfileStringW(L"Audio", L"OutputGainDb", L"0", buf, 512, path.c_str());
+    s.routeOptions.outputGainDb = static_cast<float>(std::wcstod(buf, nullptr));
+    s.routeOptions.mute = GetPrivateProfileIntW(L"Audio", L"Mute", 0, path.c_str()) != 0;
+
+    // Spectrum analyzer tap (settings.ini only)
+    GetPrivateProfileStringW(L"Audio", L"Spectrum", L"off", buf, 512, path.c_str());
+    s.routeOptions.spectrum = parseRecordTap(wideToUtf8(buf), s.routeOptions.spectrumTap);
+    SpectrumOptions& spectrum = s.routeOptions.spectrumOptions;
+    spectrum.fftSize = GetPrivateProfileIntW(L"Audio", L"SpectrumFftSize", 4096, path.c_str());
+    spectrum.overlapPercent = GetPrivateProfileIntW(L"Audio", L"SpectrumOverlap", 50, path.c_str());
+    spectrum.updateHz = GetPrivateProfileIntW(L"Audio", L"SpectrumRate", 10, path.c_str());
+    spectrum.averages = GetPrivateProfileIntW(L"Audio", L"SpectrumAverages", 4, path.c_str());
+    spectrum.decimation = GetPrivateProfileIntW(L"Audio", L"SpectrumDecimation", 1, path.c_str());
+    GetPrivateProfileStringW(L"Audio", L"SpectrumWindow", L"hann", buf, 512, path.c_str());
+    parseSpectrumWindow(wideToUtf8(buf), spectrum.window);
+
     return s;
 }
 
@@ -803,33 +857,122 @@ static void onPaint(HWND hWnd) {
     wchar_t latBuf[256]    = L"Latency: -  |  Underruns: 0";
     COLORREF statusClr = CLR_TEXT_DIM;
 
-    if (g_router) {
-        RouterStatus rs = g_router->getStatus();
+    RouterStatus rs;
+    if (g_routes && SUCCEEDED(g_routes->getStatus(kMainRoute, rs))) {
         const wchar_t* stateStr = L"Stopped";
         switch (rs.state) {
+            case RouterState::Starting: stateStr = L"Starting"; break;
+            case RouterState::Stopping: stateStr = L"Stopping"; break;
             case RouterState::Running: stateStr = L"Running"; statusClr = CLR_GREEN; break;
             case RouterState::Error:   stateStr = L"Error";   statusClr = CLR_RED;   break;
             default: break;
         }
         if (rs.state == RouterState::Error && !rs.errorMessage.empty())
             swprintf_s(statusBuf, L"Status: %s - %s", stateStr, rs.errorMessage.c_str());
+        else if (rs.state == RouterState::Running && rs.gateEnabled && rs.gateState == GateState::Idle)
+            swprintf_s(statusBuf, L"Status: %s (idle, no signal)", stateStr);
         else
             swprintf_s(statusBuf, L"Status: %s", stateStr);
 
+        size_t extraRunning = 0;
+        for (auto& route : g_routes->getStatus())
+            if (route.name != kMainRoute && route.status.state == RouterState::Running)
+                ++extraRunning;
+        if (extraRunning > 0) {
+            size_t len = wcslen(statusBuf);
+            swprintf_s(statusBuf + len, 256 - len, L"  |  +%zu routes", extraRunning);
+        }
+
+        // Time to audio, and the top-level phase that took longest
+        if (rs.state == RouterState::Running && rs.startup.firstRenderMs >= 0.0) {
+            const StartupPhase* slowest = nullptr;
+            for (const StartupPhase& phase : rs.startup.phases)
+                if (phase.depth == 0 && (!slowest || phase.durationMs > slowest->durationMs))
+                    slowest = &phase;
+            size_t len = wcslen(statusBuf);
+            swprintf_s(statusBuf + len, 256 - len, L"  |  Started in %.0f ms", rs.startup.firstRenderMs);
+            if (slowest) {
+                len = wcslen(statusBuf);
+                swprintf_s(statusBuf + len, 256 - len, L" (%s %.0f ms)",
+                           utf8ToWide(slowest->name).c_str(), slowest->durationMs);
+            }
+        }
+
+        // Device stalls: recovering now, or how the last one went
+        const WatchdogStats& capDog = rs.captureWatchdog;
+        const WatchdogStats& renDog = rs.renderWatchdog;
+        if (rs.state == RouterState::Running && (capDog.stalled || renDog.stalled)) {
+            size_t len = wcslen(statusBuf);
+            swprintf_s(statusBuf + len, 256 - len, L"  |  %s stalled, reopening",
+                       capDog.stalled ? L"Capture" : L"Render");
+            statusClr = CLR_RED;
+        } else if (capDog.recoveries + renDog.recoveries > 0) {
+            size_t len = wcslen(statusBuf);
+            swprintf_s(statusBuf + len, 256 - len, L"  |  Recovered %llux (max %.0f ms)",
+                       capDog.recoveries + renDog.recoveries,
+                       (std::max)(capDog.maxRecoveryMs, renDog.maxRecoveryMs));
+        }
+
+        // Passthrough check: clean so far, or what went wrong and when last
+        const VerifyStats& verify = rs.verify;
+        if (verify.active) {
+            const UINT64 faults = verify.dropped + verify.duplicated + verify.corrupted;
+            size_t len = wcslen(statusBuf);
+            if (faults == 0) {
+                swprintf_s(statusBuf + len, 256 - len, L"  |  Bit-exact");
+            } else {
+                const double lastSec = (std::max)(verify.lastDropSec,
+                                       (std::max)(verify.lastDuplicateSec, verify.lastCorruptSec));
+                swprintf_s(statusBuf + len, 256 - len, L"  |  NOT bit-exact: %llu dropped, %llu dup, %llu corrupt (last at %.1f s)",
+                           verify.dropped, verify.duplicated, verify.corrupted, lastSec);
+                statusClr = CLR_RED;
+            }
+        }
+
+        if (rs.recording && rs.recordFormat.sampleRate > 0) {
+            UINT64 secs = rs.recordedFrames / rs.recordFormat.sampleRate;
+            size_t len = wcslen(statusBuf);
+            swprintf_s(statusBuf + len, 256 - len, L"  |  REC %llu:%02llu:%02llu%s",
+                       secs / 3600, secs / 60 % 60, secs % 60,
+                       rs.recordFailed ? L" (write failed)" : L"");
+            if (rs.recordDroppedFrames > 0) {
+                len = wcslen(statusBuf);
+                swprintf_s(statusBuf + len, 256 - len, L", %llu frames dropped", rs.recordDroppedFrames);
+            }
+        }
+
         if (rs.state == RouterState::Running) {
             std::wstring capStr = formatInfo(L"Capture:", rs.captureFormat, rs.captureBufferFrames);
             wcscpy_s(capBuf, capStr.c_str());
+            appendLevels(capBuf, 256, rs.captureLevels);
             std::wstring renStr = formatInfo(L"Render: ", rs.renderFormat, rs.renderBufferFrames);
             wcscpy_s(renBuf, renStr.c_str());
+            appendLevels(renBuf, 256, rs.renderLevels);
 
             double capLatMs = 0, renLatMs = 0;
-            if (rs.captureFormat.Format.nSamplesPerSec > 0)
-                capLatMs = 1000.0 * rs.captureBufferFrames / rs.captureFormat.Format.nSamplesPerSec;
-            if (rs.renderFormat.Format.nSamplesPerSec > 0)
-                renLatMs = 1000.0 * rs.renderBufferFrames / rs.renderFormat.Format.nSamplesPerSec;
-            swprintf_s(latBuf, L"Latency: ~%.1f ms  |  Underruns: %llu%s",
-                       capLatMs + renLatMs, rs.underruns,
-                       rs.resamplerActive ? L"  |  Resampler: active" : L"");
+            if (rs.captureFormat.sampleRate > 0)
+                capLatMs = 1000.0 * rs.captureBufferFrames / rs.captureFormat.sampleRate;
+            if (rs.renderFormat.sampleRate > 0)
+                renLatMs = 1000.0 * rs.renderBufferFrames / rs.renderFormat.sampleRate;
+            double concealedMs = 0;
+            if (rs.renderFormat.sampleRate > 0)
+                concealedMs = 1000.0 * rs.concealedFrames / rs.renderFormat.sampleRate;
+            // With the resampler running, say what it converts
+            std::wstring resampler;
+            if (rs.resamplerActive)
+                resampler = L"  |  Resampler: " + utf8ToWide(describeConversion(rs.captureFormat, rs.renderFormat));
+            swprintf_s(latBuf, L"Latency: ~%.1f ms  |  Underruns: %llu (%.0f ms PLC)%s",
+                       capLatMs + renLatMs, rs.underruns, concealedMs, resampler.c_str());
+            if (rs.spectrum && rs.spectrumFrames > 0) {
+                size_t len = wcslen(latBuf);
+                swprintf_s(latBuf + len, 256 - len, L"  |  Peak: %.0f Hz %.0f dB",
+                           rs.spectrumPeakHz, rs.spectrumPeakDb);
+            }
+            if (rs.clockRatio.valid) {
+                size_t len = wcslen(latBuf);
+                swprintf_s(latBuf + len, 256 - len, L"  |  Drift: %+.1f \u00B1 %.1f ppm",
+                           rs.clockRatio.ppm, rs.clockRatio.ppmBound);
+            }
         }
     }
 
@@ -974,8 +1117,8 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPara
         case WM_TIMER:
             if (wParam == IDT_STATUS_TIMER) {
                 InvalidateRect(hWnd, &g_statusPanelRc, FALSE);
-                if (g_router) {
-                    RouterStatus rs = g_router->getStatus();
+                RouterStatus rs;
+                if (g_routes && SUCCEEDED(g_routes->getStatus(kMainRoute, rs))) {
                     if (rs.state == RouterState::Error)
                         KillTimer(hWnd, IDT_STATUS_TIMER);
                 }
@@ -1019,7 +1162,9 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPara
             break;
 
         case WM_CLOSE: {
-            bool wasRunning = g_router && g_router->getStatus().state == RouterState::Running;
+            RouterStatus rs;
+            bool wasRunning = g_routes && SUCCEEDED(g_routes->getStatus(kMainRoute, rs))
+                              && rs.state == RouterState::Running;
             onStop(hWnd);              // This sets AutoStart=0
             saveAutoStart(wasRunning); // Override: restore true if was running
             DestroyWindow(hWnd);
@@ -1096,28 +1241,66 @@ static void populateDevices(HWND hWnd) {
 }
 
 // ── Format info string ────────────────────────────────────────────
-static std::wstring formatInfo(const wchar_t* prefix, const WAVEFORMATEXTENSIBLE& fmt, UINT32 bufFrames) {
-    const wchar_t* sampleType = L"PCM";
-    if (fmt.Format.wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
-        if (IsEqualGUID(fmt.SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT))
-            sampleType = L"float";
-    } else if (fmt.Format.wFormatTag == WAVE_FORMAT_IEEE_FLOAT) {
-        sampleType = L"float";
-    }
+static std::wstring formatInfo(const wchar_t* prefix, const AudioFormat& fmt, UINT32 bufFrames) {
+    const wchar_t* sampleType = (fmt.type == SampleType::Float32) ? L"float" : L"PCM";
 
     wchar_t buf[256];
     swprintf_s(buf, L"%s %u Hz, %u-bit %s, %uch, buf=%u",
                prefix,
-               fmt.Format.nSamplesPerSec,
-               (fmt.Format.wFormatTag == WAVE_FORMAT_EXTENSIBLE)
-                   ? fmt.Samples.wValidBitsPerSample : fmt.Format.wBitsPerSample,
+               fmt.sampleRate,
+               fmt.validBits,
                sampleType,
-               fmt.Format.nChannels,
+               fmt.channels,
                bufFrames);
     return buf;
 }
 
+// Stereo shows both channels, wider streams their loudest channel
+static void appendLevels(wchar_t* buf, size_t size, const LevelSnapshot& levels) {
+    if (levels.channels == 0) return;
+
+    float peak = 0.0f, rms = 0.0f;
+    UINT64 clips = 0;
+    for (UINT32 c = 0; c < levels.channels; ++c) {
+        peak = (std::max)(peak, levels.peak[c]);
+        rms = (std::max)(rms, levels.rms[c]);
+        clips += levels.clips[c];
+    }
+
+    size_t len = wcslen(buf);
+    if (levels.channels == 2)
+        swprintf_s(buf + len, size - len, L"  |  %.0f / %.0f dB",
+                   levelToDb(levels.peak[0]), levelToDb(levels.peak[1]));
+    else
+        swprintf_s(buf + len, size - len, L"  |  %.0f dB", levelToDb(peak));
+    len = wcslen(buf);
+    swprintf_s(buf + len, size - len, L" (RMS %.0f)", levelToDb(rms));
+    if (clips > 0) {
+        len = wcslen(buf);
+        swprintf_s(buf + len, size - len, L", %llu clipped", clips);
+    }
+}
+
 // ── Apply / Stop handlers ─────────────────────────────────────────
+
+// Additional routes ([Route.<name>] sections, same format as the headless
+// config) run alongside the dialog's route when routes.ini exists next to
+// settings.ini.
+static void loadExtraRoutes(RouteManager& routes) {
+    std::wstring path = getSettingsPath();
+    path = path.substr(0, path.find_last_of(L'\\')) + L"\\routes.ini";
+    if (GetFileAttributesW(path.c_str()) == INVALID_FILE_ATTRIBUTES) return;
+
+    DaemonConfig config;
+    std::string error;
+    if (FAILED(loadDaemonConfig(wideToUtf8(path), config, error))) return;
+    for (auto& route : config.routes) {
+        if (route.name == kMainRoute) continue;
+        routes.addRoute(route);
+    }
+    routes.startAll();
+}
+
 static void onApply(HWND hWnd) {
     int capIdx = (int)SendDlgItemMessageW(hWnd, IDC_COMBO_CAPTURE, CB_GETCURSEL, 0, 0);
     int renIdx = (int)SendDlgItemMessageW(hWnd, IDC_COMBO_RENDER, CB_GETCURSEL, 0, 0);
@@ -1133,11 +1316,23 @@ static void onApply(HWND hWnd) {
     // Save settings
     saveSettings(g_captureDevices[capIdx].id, g_renderDevices[renIdx].id, exclusive);
 
-    if (g_router) g_router->stop();
-    g_router = std::make_unique<AudioRouter>();
-
-    g_router->start(g_captureDevices[capIdx].id,
-                    g_renderDevices[renIdx].id, exclusive);
+    if (!g_routes) {
+        g_routes = std::make_unique<RouteManager>();
+        loadExtraRoutes(*g_routes);
+    }
+    g_routes->removeRoute(kMainRoute);
+
+    RouteConfig config;
+    config.name = kMainRoute;
+    config.capture.backend = EndpointBackend::Wasapi;
+    config.capture.device = wideToUtf8(g_captureDevices[capIdx].id);
+    config.capture.exclusive = exclusive;
+    config.render.backend = EndpointBackend::Wasapi;
+    config.render.device = wideToUtf8(g_renderDevices[renIdx].id);
+    config.render.exclusive = exclusive;
+    config.options = loadSettings().routeOptions;
+    g_routes->addRoute(config);
+    g_routes->startRoute(kMainRoute);
 
     SetTimer(hWnd, IDT_STATUS_TIMER, 500, nullptr);
     InvalidateRect(hWnd, nullptr, FALSE);
@@ -1145,10 +1340,7 @@ static void onApply(HWND hWnd) {
 
 static void onStop(HWND hWnd) {
     KillTimer(hWnd, IDT_STATUS_TIMER);
-    if (g_router) {
-        g_router->stop();
-        g_router.reset();
-    }
+    g_routes.reset();
     saveAutoStart(false);
     InvalidateRect(hWnd, nullptr, FALSE);
 }
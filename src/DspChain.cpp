@@ -0,0 +1,492 @@
+#include "DspChain.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIOBRIDGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Four channels of one frame. The stages are written once against this and
+// compile to SSE, or to plain loops without it.
+#ifdef AUDIOBRIDGE_SSE2
+struct Vec4 {
+    __m128 v;
+    static Vec4 load(const float* p)  { return { _mm_load_ps(p) }; }
+    static Vec4 splat(float x)        { return { _mm_set1_ps(x) }; }
+    void store(float* p) const        { _mm_store_ps(p, v); }
+};
+static inline Vec4 operator+(Vec4 a, Vec4 b) { return { _mm_add_ps(a.v, b.v) }; }
+static inline Vec4 operator-(Vec4 a, Vec4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+static inline Vec4 operator*(Vec4 a, Vec4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+static inline Vec4 absMax(Vec4 m, Vec4 a) {
+    return { _mm_max_ps(m.v, _mm_and_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)))) };
+}
+static inline float maxLane(Vec4 a) {
+    __m128 m = _mm_max_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(m);
+}
+#else
+struct Vec4 {
+    float v[4];
+    static Vec4 load(const float* p)  { return { { p[0], p[1], p[2], p[3] } }; }
+    static Vec4 splat(float x)        { return { { x, x, x, x } }; }
+    void store(float* p) const        { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+};
+static inline Vec4 operator+(Vec4 a, Vec4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+static inline Vec4 operator-(Vec4 a, Vec4 b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+static inline Vec4 operator*(Vec4 a, Vec4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+static inline Vec4 absMax(Vec4 m, Vec4 a) {
+    for (int i = 0; i < 4; ++i) m.v[i] = (std::max)(m.v[i], std::fabs(a.v[i]));
+    return m;
+}
+static inline float maxLane(Vec4 a) {
+    return (std::max)((std::max)(a.v[0], a.v[1]), (std::max)(a.v[2], a.v[3]));
+}
+#endif
+
+static const double kPi = 3.14159265358979323846;
+
+// One-pole smoothing coefficient for a time constant
+static float timeCoef(double ms, double sampleRate) {
+    if (ms <= 0.0) return 1.0f;
+    return static_cast<float>(1.0 - std::exp(-1000.0 / (ms * sampleRate)));
+}
+
+void designBiquad(BiquadType type, double sampleRate, double frequencyHz, double q, double gainDb,
+                  float coeffs[5]) {
+    // Keep the design stable whatever the config says
+    frequencyHz = (std::min)((std::max)(frequencyHz, 1.0), 0.49 * sampleRate);
+    q = (std::max)(q, 0.05);
+
+    const double w0 = 2.0 * kPi * frequencyHz / sampleRate;
+    const double cw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a = std::pow(10.0, gainDb / 40.0);
+    const double shelf = 2.0 * std::sqrt(a) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+    switch (type) {
+        case BiquadType::LowPass:
+            b0 = (1 - cw) / 2; b1 = 1 - cw; b2 = (1 - cw) / 2;
+            a0 = 1 + alpha;    a1 = -2 * cw; a2 = 1 - alpha;
+            break;
+        case BiquadType::HighPass:
+            b0 = (1 + cw) / 2; b1 = -(1 + cw); b2 = (1 + cw) / 2;
+            a0 = 1 + alpha;    a1 = -2 * cw;   a2 = 1 - alpha;
+            break;
+        case BiquadType::BandPass:
+            b0 = alpha;     b1 = 0;       b2 = -alpha;
+            a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+            break;
+        case BiquadType::Notch:
+            b0 = 1;         b1 = -2 * cw; b2 = 1;
+            a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+            break;
+        case BiquadType::LowShelf:
+            b0 = a * ((a + 1) - (a - 1) * cw + shelf);
+            b1 = 2 * a * ((a - 1) - (a + 1) * cw);
+            b2 = a * ((a + 1) - (a - 1) * cw - shelf);
+            a0 = (a + 1) + (a - 1) * cw + shelf;
+            a1 = -2 * ((a - 1) + (a + 1) * cw);
+            a2 = (a + 1) + (a - 1) * cw - shelf;
+            break;
+        case BiquadType::HighShelf:
+            b0 = a * ((a + 1) + (a - 1) * cw + shelf);
+            b1 = -2 * a * ((a - 1) + (a + 1) * cw);
+            b2 = a * ((a + 1) + (a - 1) * cw - shelf);
+            a0 = (a + 1) - (a - 1) * cw + shelf;
+            a1 = 2 * ((a - 1) - (a + 1) * cw);
+            a2 = (a + 1) - (a - 1) * cw - shelf;
+            break;
+        default:    // Peak
+            b0 = 1 + alpha * a; b1 = -2 * cw; b2 = 1 - alpha * a;
+            a0 = 1 + alpha / a; a1 = -2 * cw; a2 = 1 - alpha / a;
+            break;
+    }
+    coeffs[0] = static_cast<float>(b0 / a0);
+    coeffs[1] = static_cast<float>(b1 / a0);
+    coeffs[2] = static_cast<float>(b2 / a0);
+    coeffs[3] = static_cast<float>(a1 / a0);
+    coeffs[4] = static_cast<float>(a2 / a0);
+}
+
+static float dbToGain(double db) {
+    return static_cast<float>(std::pow(10.0, db / 20.0));
+}
+
+// The run-time parameters of one insert, as carried by DspParamSet
+static void stageValues(const DspStageConfig& cfg, double rate, float values[5]) {
+    switch (cfg.type) {
+        case DspStageType::Gain:
+            values[0] = dbToGain(cfg.gainDb);
+            break;
+        case DspStageType::Eq:
+            designBiquad(cfg.filter, rate, cfg.frequencyHz, cfg.q, cfg.gainDb, values);
+            break;
+        case DspStageType::DcBlock:
+            values[0] = static_cast<float>(std::exp(-2.0 * kPi * (std::max)(cfg.frequencyHz, 0.1f) / rate));
+            break;
+        case DspStageType::Gate:
+            values[0] = dbToGain(cfg.thresholdDb);
+            values[1] = timeCoef(cfg.attackMs, rate);
+            values[2] = timeCoef(cfg.releaseMs, rate);
+            values[3] = static_cast<float>(std::floor((std::max)(cfg.holdMs, 0.0f) * rate / 1000.0));
+            break;
+    }
+}
+
+static void setGate(float& threshold, float& attackCoef, float& releaseCoef, uint32_t& holdFrames,
+                    const float values[5]) {
+    threshold = values[0];
+    attackCoef = values[1];
+    releaseCoef = values[2];
+    holdFrames = static_cast<uint32_t>(values[3]);
+}
+
+void DspChain::init(const AudioFormat& format, const std::vector<DspStageConfig>& stages,
+                    AudioArena* arena, float outputGainDb, bool mute) {
+    m_format = format;
+    m_channels = format.channels;
+    m_lanes = (m_channels + 3) & ~3u;
+    m_stages.clear();
+    m_inserts.clear();
+
+    const double rate = format.sampleRate > 0 ? format.sampleRate : 48000.0;
+    m_rampFrames = (std::max)(1u, static_cast<uint32_t>(rate * kDspGainRampMs / 1000.0));
+    std::vector<float> coeffs;
+    uint32_t stateFloats = 0;
+
+    for (const DspStageConfig& cfg : stages) {
+        float values[5] = {};
+        stageValues(cfg, rate, values);
+
+        if (cfg.type == DspStageType::Eq) {
+            // Consecutive sections share one stage and one pass over the chunk
+            if (m_stages.empty() || m_stages.back().type != DspStageType::Eq) {
+                Stage stage;
+                stage.type = DspStageType::Eq;
+                stage.coeffOffset = static_cast<uint32_t>(coeffs.size());
+                stage.stateOffset = stateFloats;
+                m_stages.push_back(stage);
+            }
+            Stage& stage = m_stages.back();
+            m_inserts.push_back({ cfg.type, static_cast<uint32_t>(m_stages.size() - 1), stage.sections });
+            coeffs.insert(coeffs.end(), values, values + 5);
+            ++stage.sections;
+            stage.coeffCount += 5;
+            stateFloats += 2 * m_lanes;
+            continue;
+        }
+
+        Stage stage;
+        stage.type = cfg.type;
+        switch (cfg.type) {
+            case DspStageType::Gain:
+                stage.gain.current = stage.gain.target = values[0];
+                break;
+            case DspStageType::DcBlock:
+                stage.coeffOffset = static_cast<uint32_t>(coeffs.size());
+                stage.coeffCount = 1;
+                coeffs.push_back(values[0]);
+                stage.stateOffset = stateFloats;
+                stateFloats += 2 * m_lanes;
+                break;
+            case DspStageType::Gate:
+                setGate(stage.threshold, stage.attackCoef, stage.releaseCoef, stage.holdFrames, values);
+                break;
+            default:
+                break;
+        }
+        m_inserts.push_back({ cfg.type, static_cast<uint32_t>(m_stages.size()), 0 });
+        m_stages.push_back(stage);
+    }
+
+    m_coeffs = ArenaVector<float>(coeffs.begin(), coeffs.end(), ArenaAllocator<float>(arena));
+    m_coeffTarget = ArenaVector<float>(coeffs.begin(), coeffs.end(), ArenaAllocator<float>(arena));
+    m_state = ArenaVector<float>(stateFloats, 0.0f, ArenaAllocator<float>(arena));
+    // The matrix and output gain can be switched on live, so the scratch
+    // buffers exist even without inserts
+    m_work = ArenaVector<float>(static_cast<size_t>(kDspChunkFrames) * m_lanes, 0.0f, ArenaAllocator<float>(arena));
+    m_interleaved = ArenaVector<float>(m_lanes != m_channels ? static_cast<size_t>(kDspChunkFrames) * m_channels : 0,
+                                       0.0f, ArenaAllocator<float>(arena));
+    m_matrix = ArenaVector<float>(static_cast<size_t>(m_lanes) * m_lanes, 0.0f, ArenaAllocator<float>(arena));
+    for (uint32_t c = 0; c < m_channels; ++c) m_matrix[static_cast<size_t>(c) * m_lanes + c] = 1.0f;
+    m_matrixTarget = ArenaVector<float>(m_matrix.begin(), m_matrix.end(), ArenaAllocator<float>(arena));
+    m_frame = ArenaVector<float>(m_lanes, 0.0f, ArenaAllocator<float>(arena));
+    m_matrixGlide = 0;
+    m_matrixActive = false;
+
+    m_outputGain = dbToGain(outputGainDb);
+    m_muted = mute;
+    m_output = Ramp();
+    m_output.current = m_output.target = m_muted ? 0.0f : m_outputGain;
+    reset();
+}
+
+void DspChain::reset() {
+    std::fill(m_state.begin(), m_state.end(), 0.0f);
+    std::copy(m_coeffTarget.begin(), m_coeffTarget.end(), m_coeffs.begin());
+    for (Stage& stage : m_stages) {
+        stage.glideChunks = 0;
+        stage.gain.current = stage.gain.target;
+        stage.gain.framesLeft = 0;
+        stage.gateGain = 1.0f;
+        stage.holdLeft = stage.holdFrames;
+    }
+    std::copy(m_matrixTarget.begin(), m_matrixTarget.end(), m_matrix.begin());
+    m_matrixGlide = 0;
+    m_output.current = m_output.target;
+    m_output.framesLeft = 0;
+}
+
+bool DspChain::bypassed() const {
+    return m_stages.empty() && !m_matrixActive && m_output.framesLeft == 0 && m_output.current == 1.0f;
+}
+
+void DspChain::process(uint8_t* data, uint32_t frames) {
+    if (bypassed()) return;
+    const size_t blockAlign = m_format.blockAlign();
+    while (frames > 0) {
+        const uint32_t n = (std::min)(frames, kDspChunkFrames);
+        processChunk(data, n);
+        data += n * blockAlign;
+        frames -= n;
+    }
+}
+
+void DspChain::apply(const ParamCommand& command) {
+    switch (command.id) {
+        case ParamId::OutputGain:
+            m_outputGain = command.value;
+            setRamp(m_output, m_muted ? 0.0f : m_outputGain);
+            break;
+        case ParamId::Mute:
+            m_muted = command.value != 0.0f;
+            setRamp(m_output, m_muted ? 0.0f : m_outputGain);
+            break;
+        case ParamId::MatrixGain:
+            if (command.index >= m_channels || command.index2 >= m_channels) break;
+            m_matrixTarget[static_cast<size_t>(command.index2) * m_lanes + command.index] = command.value;
+            m_matrixGlide = kDspGlideChunks;
+            m_matrixActive = true;
+            break;
+        case ParamId::Insert: {
+            const DspParamSet* params = command.params;
+            if (!params || command.index >= m_inserts.size()) break;
+            const InsertSlot& slot = m_inserts[command.index];
+            if (params->type != static_cast<uint32_t>(slot.type)) break;
+            Stage& stage = m_stages[slot.stage];
+            switch (slot.type) {
+                case DspStageType::Gain:
+                    setRamp(stage.gain, params->values[0]);
+                    break;
+                case DspStageType::Eq:
+                    std::copy(params->values, params->values + 5,
+                              m_coeffTarget.begin() + stage.coeffOffset + 5 * slot.section);
+                    stage.glideChunks = kDspGlideChunks;
+                    break;
+                case DspStageType::DcBlock:
+                    m_coeffTarget[stage.coeffOffset] = params->values[0];
+                    stage.glideChunks = kDspGlideChunks;
+                    break;
+                case DspStageType::Gate:
+                    // The gate ramps its own gain; new settings apply as they are
+                    setGate(stage.threshold, stage.attackCoef, stage.releaseCoef, stage.holdFrames, params->values);
+                    stage.holdLeft = (std::min)(stage.holdLeft, stage.holdFrames);
+                    break;
+            }
+            break;
+        }
+    }
+}
+
+DspParamSet* DspChain::prepareInsert(uint32_t index, const DspStageConfig& config) const {
+    if (index >= m_inserts.size() || m_inserts[index].type != config.type) return nullptr;
+    DspParamSet* params = new DspParamSet;
+    params->type = static_cast<uint32_t>(config.type);
+    stageValues(config, m_format.sampleRate > 0 ? m_format.sampleRate : 48000.0, params->values);
+    return params;
+}
+
+void DspChain::setRamp(Ramp& ramp, float target) {
+    ramp.target = target;
+    ramp.framesLeft = m_rampFrames;
+    ramp.step = (target - ramp.current) / static_cast<float>(m_rampFrames);
+}
+
+// Moves coefficients and the matrix one chunk further towards their
+// targets. Linear steps between two stable biquads stay stable: the
+// stability region of (a1, a2) is convex.
+void DspChain::glide() {
+    for (Stage& stage : m_stages) {
+        if (stage.glideChunks == 0) continue;
+        const float frac = 1.0f / static_cast<float>(stage.glideChunks--);
+        float* c = m_coeffs.data() + stage.coeffOffset;
+        const float* t = m_coeffTarget.data() + stage.coeffOffset;
+        for (uint32_t i = 0; i < stage.coeffCount; ++i) c[i] += (t[i] - c[i]) * frac;
+    }
+
+    if (m_matrixGlide > 0) {
+        const float frac = 1.0f / static_cast<float>(m_matrixGlide--);
+        for (size_t i = 0; i < m_matrix.size(); ++i) m_matrix[i] += (m_matrixTarget[i] - m_matrix[i]) * frac;
+        if (m_matrixGlide == 0) {
+            bool identity = true;
+            for (uint32_t in = 0; in < m_channels && identity; ++in)
+                for (uint32_t out = 0; out < m_channels; ++out)
+                    if (m_matrix[static_cast<size_t>(in) * m_lanes + out] != (in == out ? 1.0f : 0.0f)) {
+                        identity = false;
+                        break;
+                    }
+            m_matrixActive = !identity;
+        }
+    }
+}
+
+void DspChain::processChunk(uint8_t* data, uint32_t frames) {
+    const size_t samples = static_cast<size_t>(frames) * m_channels;
+    float* work = m_work.data();
+
+    // Native samples to padded float frames
+    if (m_lanes == m_channels) {
+        samplesToFloat(m_format.type, data, work, samples);
+    } else {
+        samplesToFloat(m_format.type, data, m_interleaved.data(), samples);
+        const float* src = m_interleaved.data();
+        for (uint32_t f = 0; f < frames; ++f) {
+            float* dst = work + static_cast<size_t>(f) * m_lanes;
+            uint32_t c = 0;
+            for (; c < m_channels; ++c) dst[c] = src[c];
+            for (; c < m_lanes; ++c) dst[c] = 0.0f;
+            src += m_channels;
+        }
+    }
+
+    glide();
+    for (Stage& stage : m_stages) {
+        switch (stage.type) {
+            case DspStageType::Gain:    runRamp(stage.gain, frames); break;
+            case DspStageType::Eq:      runEq(stage, frames);        break;
+            case DspStageType::DcBlock: runDcBlock(stage, frames);   break;
+            case DspStageType::Gate:    runGate(stage, frames);      break;
+        }
+    }
+    if (m_matrixActive) runMatrix(frames);
+    runRamp(m_output, frames);
+
+    if (m_lanes == m_channels) {
+        samplesFromFloat(m_format.type, work, data, samples);
+    } else {
+        float* dst = m_interleaved.data();
+        for (uint32_t f = 0; f < frames; ++f) {
+            const float* src = work + static_cast<size_t>(f) * m_lanes;
+            for (uint32_t c = 0; c < m_channels; ++c) dst[c] = src[c];
+            dst += m_channels;
+        }
+        samplesFromFloat(m_format.type, m_interleaved.data(), data, samples);
+    }
+}
+
+// A gain that is still ramping steps once per frame; a settled one is a
+// plain multiply, or nothing at unity
+void DspChain::runRamp(Ramp& ramp, uint32_t frames) {
+    float* p = m_work.data();
+    uint32_t f = 0;
+    for (; f < frames && ramp.framesLeft > 0; ++f, p += m_lanes) {
+        ramp.current = --ramp.framesLeft == 0 ? ramp.target : ramp.current + ramp.step;
+        const Vec4 g = Vec4::splat(ramp.current);
+        for (uint32_t c = 0; c < m_lanes; c += 4) (Vec4::load(p + c) * g).store(p + c);
+    }
+    if (f == frames || ramp.current == 1.0f) return;
+
+    const Vec4 g = Vec4::splat(ramp.current);
+    const size_t count = static_cast<size_t>(frames - f) * m_lanes;
+    for (size_t i = 0; i < count; i += 4)
+        (Vec4::load(p + i) * g).store(p + i);
+}
+
+// Transposed direct form II, one section at a time over the whole chunk so
+// its coefficients and the state of four channels stay in registers
+void DspChain::runEq(const Stage& stage, uint32_t frames) {
+    float* work = m_work.data();
+    for (uint32_t s = 0; s < stage.sections; ++s) {
+        const float* c = m_coeffs.data() + stage.coeffOffset + 5 * s;
+        const Vec4 b0 = Vec4::splat(c[0]), b1 = Vec4::splat(c[1]), b2 = Vec4::splat(c[2]);
+        const Vec4 a1 = Vec4::splat(c[3]), a2 = Vec4::splat(c[4]);
+        float* state = m_state.data() + stage.stateOffset + 2 * m_lanes * s;
+
+        for (uint32_t g = 0; g < m_lanes; g += 4) {
+            Vec4 z1 = Vec4::load(state + g);
+            Vec4 z2 = Vec4::load(state + m_lanes + g);
+            float* p = work + g;
+            for (uint32_t f = 0; f < frames; ++f, p += m_lanes) {
+                const Vec4 x = Vec4::load(p);
+                const Vec4 y = b0 * x + z1;
+                z1 = b1 * x - a1 * y + z2;
+                z2 = b2 * x - a2 * y;
+                y.store(p);
+            }
+            z1.store(state + g);
+            z2.store(state + m_lanes + g);
+        }
+    }
+}
+
+// y[n] = x[n] - x[n-1] + pole · y[n-1]
+void DspChain::runDcBlock(const Stage& stage, uint32_t frames) {
+    float* work = m_work.data();
+    float* state = m_state.data() + stage.stateOffset;
+    const Vec4 pole = Vec4::splat(m_coeffs[stage.coeffOffset]);
+    for (uint32_t g = 0; g < m_lanes; g += 4) {
+        Vec4 x1 = Vec4::load(state + g);
+        Vec4 y1 = Vec4::load(state + m_lanes + g);
+        float* p = work + g;
+        for (uint32_t f = 0; f < frames; ++f, p += m_lanes) {
+            const Vec4 x = Vec4::load(p);
+            y1 = x - x1 + pole * y1;
+            x1 = x;
+            y1.store(p);
+        }
+        x1.store(state + g);
+        y1.store(state + m_lanes + g);
+    }
+}
+
+// Linked gate: the loudest channel of each frame opens it for all channels
+void DspChain::runGate(Stage& stage, uint32_t frames) {
+    float* p = m_work.data();
+    float gain = stage.gateGain;
+    uint32_t holdLeft = stage.holdLeft;
+    for (uint32_t f = 0; f < frames; ++f, p += m_lanes) {
+        Vec4 peak = Vec4::splat(0.0f);
+        for (uint32_t g = 0; g < m_lanes; g += 4) peak = absMax(peak, Vec4::load(p + g));
+
+        float target = 1.0f;
+        if (maxLane(peak) >= stage.threshold) holdLeft = stage.holdFrames;
+        else if (holdLeft > 0)                --holdLeft;
+        else                                  target = 0.0f;
+        gain += (target - gain) * (target > gain ? stage.attackCoef : stage.releaseCoef);
+
+        const Vec4 g4 = Vec4::splat(gain);
+        for (uint32_t g = 0; g < m_lanes; g += 4) (Vec4::load(p + g) * g4).store(p + g);
+    }
+    stage.gateGain = gain;
+    stage.holdLeft = holdLeft;
+}
+
+// Each output is a weighted sum of all inputs, four outputs at a time
+void DspChain::runMatrix(uint32_t frames) {
+    float* p = m_work.data();
+    float* out = m_frame.data();
+    const float* m = m_matrix.data();
+    for (uint32_t f = 0; f < frames; ++f, p += m_lanes) {
+        for (uint32_t g = 0; g < m_lanes; g += 4) {
+            Vec4 acc = Vec4::splat(0.0f);
+            for (uint32_t in = 0; in < m_channels; ++in)
+                acc = acc + Vec4::splat(p[in]) * Vec4::load(m + static_cast<size_t>(in) * m_lanes + g);
+            acc.store(out + g);
+        }
+        std::copy(out, out + m_lanes, p);
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "SampleFormat.h"
+#include "AudioArena.h"
+#include "ParamQueue.h"
+
+enum class DspStageType {
+    Gain,
+    Eq,         // one biquad section; consecutive Eq stages run as one cascade
+    DcBlock,    // first-order high-pass
+    Gate        // noise gate, linked across channels
+};
+
+enum class BiquadType { LowPass, HighPass, BandPass, Notch, Peak, LowShelf, HighShelf };
+
+// One insert as given in the route config.
+struct DspStageConfig {
+    DspStageType type        = DspStageType::Gain;
+    BiquadType   filter      = BiquadType::Peak;   // Eq
+    float        frequencyHz = 1000.0f;            // Eq, DcBlock
+    float        q           = 0.707f;             // Eq
+    float        gainDb      = 0.0f;               // Gain; Eq peak and shelves
+    float        thresholdDb = -60.0f;             // Gate: opens above this
+    float        holdMs      = 50.0f;              // Gate: stays open this long after the signal drops
+    float        releaseMs   = 100.0f;             // Gate: closing time constant
+    float        attackMs    = 1.0f;               // Gate: opening time constant
+};
+
+// Frames processed per step; bounds the scratch buffers
+constexpr uint32_t kDspChunkFrames = 256;
+// Live changes: gains ramp per frame over this long, coefficients and the
+// channel matrix glide over this many chunks
+constexpr float    kDspGainRampMs = 20.0f;
+constexpr uint32_t kDspGlideChunks = 8;
+
+// Per-route insert chain on the render side, run in place on each period.
+//
+// Each period is processed in chunks of kDspChunkFrames: converted to float
+// with every frame padded to a multiple of four channels, so each stage
+// handles four channels per SIMD vector (biquad cascades run all channels of
+// a group in parallel), then converted back. All state and scratch buffers
+// are sized in init() (from the arena when given); process() does not
+// allocate.
+//
+// After the inserts come a channel matrix (skipped while it is the
+// identity) and the output gain and mute. All of them, and the insert
+// parameters, can be changed while running through apply(); changes take
+// effect at the next chunk and are ramped so they do not click or zipper.
+class DspChain {
+public:
+    void init(const AudioFormat& format, const std::vector<DspStageConfig>& stages,
+              AudioArena* arena = nullptr, float outputGainDb = 0.0f, bool mute = false);
+    // Clears filter and gate state and completes any ramp in progress
+    void reset();
+
+    bool     empty()      const { return m_stages.empty(); }
+    uint32_t stageCount() const { return static_cast<uint32_t>(m_stages.size()); }
+    uint32_t insertCount() const { return static_cast<uint32_t>(m_inserts.size()); }
+    uint32_t channels()    const { return m_channels; }
+
+    void process(uint8_t* data, uint32_t frames);
+
+    // Audio thread, between process() calls. Does not take ownership of the
+    // command's parameter set.
+    void apply(const ParamCommand& command);
+    // Control thread: a parameter set for insert `index` (config order) with
+    // new settings, or null if there is no such insert or it is of another
+    // type. Only reads what init() fixed, so it may run while processing.
+    DspParamSet* prepareInsert(uint32_t index, const DspStageConfig& config) const;
+
+private:
+    // Linear gain, ramped per frame towards its target
+    struct Ramp {
+        float    current = 1.0f;
+        float    target = 1.0f;
+        float    step = 0.0f;
+        uint32_t framesLeft = 0;
+    };
+
+    struct Stage {
+        DspStageType type = DspStageType::Gain;
+        uint32_t     sections = 0;      // Eq: biquads in the cascade
+        uint32_t     coeffOffset = 0;   // Eq: 5 per section (b0 b1 b2 a1 a2); DcBlock: pole
+        uint32_t     coeffCount = 0;
+        uint32_t     glideChunks = 0;   // Eq, DcBlock: chunks left until m_coeffs reaches m_coeffTarget
+        uint32_t     stateOffset = 0;   // Eq, DcBlock: 2 × m_lanes per section
+        Ramp         gain;              // Gain
+        // Gate
+        float        threshold = 0.0f;
+        float        attackCoef = 0.0f;
+        float        releaseCoef = 0.0f;
+        uint32_t     holdFrames = 0;
+        float        gateGain = 1.0f;
+        uint32_t     holdLeft = 0;
+    };
+
+    // Where an insert of the config ended up
+    struct InsertSlot {
+        DspStageType type;
+        uint32_t     stage;
+        uint32_t     section;   // Eq: section within the cascade
+    };
+
+    bool bypassed() const;
+    void setRamp(Ramp& ramp, float target);
+    void glide();
+    void processChunk(uint8_t* data, uint32_t frames);
+    void runRamp(Ramp& ramp, uint32_t frames);
+    void runEq(const Stage& stage, uint32_t frames);
+    void runDcBlock(const Stage& stage, uint32_t frames);
+    void runGate(Stage& stage, uint32_t frames);
+    void runMatrix(uint32_t frames);
+
+    AudioFormat        m_format;
+    uint32_t           m_channels = 0;
+    uint32_t           m_lanes = 0;         // channels rounded up to a multiple of 4
+    uint32_t           m_rampFrames = 1;
+    std::vector<Stage> m_stages;            // layout fixed after init()
+    std::vector<InsertSlot> m_inserts;      // fixed after init()
+    ArenaVector<float> m_coeffs;
+    ArenaVector<float> m_coeffTarget;
+    ArenaVector<float> m_state;
+    ArenaVector<float> m_work;              // kDspChunkFrames × m_lanes
+    ArenaVector<float> m_interleaved;       // kDspChunkFrames × m_channels
+    // Channel matrix, m_lanes × m_lanes: [input × m_lanes + output]
+    ArenaVector<float> m_matrix;
+    ArenaVector<float> m_matrixTarget;
+    ArenaVector<float> m_frame;             // one output frame
+    uint32_t           m_matrixGlide = 0;
+    bool               m_matrixActive = false;
+    // Output
+    Ramp               m_output;
+    float              m_outputGain = 1.0f;
+    bool               m_muted = false;
+};
+
+// Biquad coefficients (RBJ cookbook), normalized: b0 b1 b2 a1 a2
+void designBiquad(BiquadType type, double sampleRate, double frequencyHz, double q, double gainDb,
+                  float coeffs[5]);
@@ -0,0 +1,199 @@
+#include "EndpointFactory.h"
+#include "FormatCache.h"
+#include "NullEndpoint.h"
+#include "WavFileEndpoint.h"
+#include "RtpEndpoint.h"
+#include "SharedMemoryEndpoint.h"
+#ifdef _WIN32
+#include "DeviceEnumerator.h"
+#include "WasapiCapture.h"
+#include "WasapiDeviceCaps.h"
+#include "WasapiRender.h"
+#endif
+
+HRESULT planRouteFormats(const RouteConfig& config, FormatPlan& plan) {
+    if (config.capture.backend != EndpointBackend::Wasapi || !config.capture.exclusive ||
+        config.render.backend != EndpointBackend::Wasapi || !config.render.exclusive)
+        return S_FALSE;
+#ifdef _WIN32
+    // Probing clients only; the endpoints activate their own
+    ComPtr<IMMDevice> captureDevice, renderDevice;
+    ComPtr<IAudioClient> captureClient, renderClient;
+    RETURN_IF_FAILED(DeviceEnumerator::getDeviceById(utf8ToWide(config.capture.device), eCapture, captureDevice));
+    RETURN_IF_FAILED(DeviceEnumerator::getDeviceById(utf8ToWide(config.render.device), eRender, renderDevice));
+    WasapiDeviceCaps captureCaps(captureDevice.Get(), captureClient);
+    WasapiDeviceCaps renderCaps(renderDevice.Get(), renderClient);
+    RETURN_IF_FAILED(captureCaps.reactivate());
+    RETURN_IF_FAILED(renderCaps.reactivate());
+    return planExclusiveRoute(captureCaps, renderCaps, config.capture.device, config.render.device,
+                              config.options.formatCachePath, plan);
+#else
+    (void)plan;
+    return S_FALSE;
+#endif
+}
+
+bool predictCaptureFormat(const RouteConfig& config, AudioFormat& format) {
+    const EndpointConfig& capture = config.capture;
+    switch (capture.backend) {
+        case EndpointBackend::Wasapi: {
+            // Shared mode runs at the engine's mix format, which takes the device to read
+            NegotiatedFormat cached;
+            if (!capture.exclusive || config.options.formatCachePath.empty() ||
+                !loadCachedFormat(config.options.formatCachePath,
+                                  formatCacheKey("capture", capture.device, nullptr), cached))
+                return false;
+            format = cached.format;
+            return true;
+        }
+        case EndpointBackend::File: {
+            // Only the header, so the guess costs a small read, not a mapping
+            WavInfo info;
+            if (!readWavHeader(capture.device.c_str(), info)) return false;
+            format = info.format;
+            return true;
+        }
+        case EndpointBackend::Null:
+        case EndpointBackend::Rtp:
+        case EndpointBackend::SharedMemory:
+            if (!capture.format.isValid()) return false;
+            format = capture.format;
+            return true;
+    }
+    return false;
+}
+
+bool renderTakesPreferredFormat(const EndpointConfig& config) {
+    return config.backend != EndpointBackend::Wasapi || config.exclusive;
+}
+
+HRESULT createCaptureEndpoint(const EndpointConfig& config, const RouteOptions& options,
+                              AudioArena* arena, RingBuffer* ringBuffer,
+                              const AudioFormat* preferredFormat,
+                              std::unique_ptr<CaptureEndpoint>& out) {
+    out.reset();
+    HRESULT hr = E_NOTIMPL;
+
+    switch (config.backend) {
+        case EndpointBackend::Wasapi: {
+#ifdef _WIN32
+            auto ep = std::make_unique<WasapiCapture>();
+            ep->setFormatCache(options.formatCachePath);
+            ep->setGateOptions(options.gateEnabled, options.gateThresholdDb, options.gateHoldMs);
+            ep->setRealtimePolicy(options.realtime);
+            ep->setArena(arena);
+            hr = ep->init(utf8ToWide(config.device), config.exclusive, ringBuffer, preferredFormat);
+            out = std::move(ep);
+#else
+            (void)preferredFormat;
+#endif
+            break;
+        }
+        case EndpointBackend::File: {
+            auto ep = std::make_unique<WavFileCapture>();
+            ep->setGateOptions(options.gateEnabled, options.gateThresholdDb, options.gateHoldMs);
+            ep->setRealtimePolicy(options.realtime);
+            ep->setArena(arena);
+            ep->setPaced(config.paced);
+            hr = ep->init(config.device, config.loop, ringBuffer);
+            out = std::move(ep);
+            break;
+        }
+        case EndpointBackend::Null: {
+            auto ep = std::make_unique<NullCapture>();
+            ep->setGateOptions(options.gateEnabled, options.gateThresholdDb, options.gateHoldMs);
+            ep->setRealtimePolicy(options.realtime);
+            ep->setArena(arena);
+            ep->setPaced(config.paced);
+            hr = ep->init(config.format, config.toneHz, ringBuffer);
+            out = std::move(ep);
+            break;
+        }
+        case EndpointBackend::Rtp: {
+            auto ep = std::make_unique<RtpCapture>();
+            ep->setGateOptions(options.gateEnabled, options.gateThresholdDb, options.gateHoldMs);
+            ep->setRealtimePolicy(options.realtime);
+            ep->setArena(arena);
+            hr = ep->init(config.device, config.format, ringBuffer, config.rtp);
+            out = std::move(ep);
+            break;
+        }
+        case EndpointBackend::SharedMemory: {
+            auto ep = std::make_unique<SharedMemoryCapture>();
+            ep->setGateOptions(options.gateEnabled, options.gateThresholdDb, options.gateHoldMs);
+            ep->setRealtimePolicy(options.realtime);
+            ep->setArena(arena);
+            hr = ep->init(config.device, config.format, config.bufferMs, ringBuffer);
+            out = std::move(ep);
+            break;
+        }
+    }
+    return hr;
+}
+
+HRESULT createRenderEndpoint(const EndpointConfig& config, const RouteOptions& options,
+                             AudioArena* arena, RingBuffer* ringBuffer,
+                             const AudioFormat* preferredFormat,
+                             std::unique_ptr<RenderEndpoint>& out) {
+    out.reset();
+    HRESULT hr = E_NOTIMPL;
+
+    switch (config.backend) {
+        case EndpointBackend::Wasapi: {
+#ifdef _WIN32
+            auto ep = std::make_unique<WasapiRender>();
+            ep->setFormatCache(options.formatCachePath);
+            ep->setRealtimePolicy(options.realtime);
+            ep->setInserts(options.inserts);
+            ep->setOutput(options.outputGainDb, options.mute);
+            ep->setArena(arena);
+            hr = ep->init(utf8ToWide(config.device), config.exclusive, ringBuffer, preferredFormat);
+            out = std::move(ep);
+#endif
+            break;
+        }
+        case EndpointBackend::File: {
+            auto ep = std::make_unique<WavFileRender>();
+            ep->setRealtimePolicy(options.realtime);
+            ep->setInserts(options.inserts);
+            ep->setOutput(options.outputGainDb, options.mute);
+            ep->setArena(arena);
+            ep->setPaced(config.paced);
+            hr = ep->init(config.device, config.format, ringBuffer, preferredFormat);
+            out = std::move(ep);
+            break;
+        }
+        case EndpointBackend::Null: {
+            auto ep = std::make_unique<NullRender>();
+            ep->setRealtimePolicy(options.realtime);
+            ep->setInserts(options.inserts);
+            ep->setOutput(options.outputGainDb, options.mute);
+            ep->setArena(arena);
+            ep->setPaced(config.paced);
+            hr = ep->init(config.format, ringBuffer, preferredFormat);
+            out = std::move(ep);
+            break;
+        }
+        case EndpointBackend::Rtp: {
+            auto ep = std::make_unique<RtpRender>();
+            ep->setRealtimePolicy(options.realtime);
+            ep->setInserts(options.inserts);
+            ep->setOutput(options.outputGainDb, options.mute);
+            ep->setArena(arena);
+            hr = ep->init(config.device, config.format, ringBuffer, preferredFormat, config.rtp);
+            out = std::move(ep);
+            break;
+        }
+        case EndpointBackend::SharedMemory: {
+            auto ep = std::make_unique<SharedMemoryRender>();
+            ep->setRealtimePolicy(options.realtime);
+            ep->setInserts(options.inserts);
+            ep->setOutput(options.outputGainDb, options.mute);
+            ep->setArena(arena);
+            hr = ep->init(config.device, config.format, config.bufferMs, ringBuffer, preferredFormat);
+            out = std::move(ep);
+            break;
+        }
+    }
+    return hr;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include "AudioEndpoint.h"
+#include "RouteConfig.h"
+#include "FormatPlanner.h"
+
+// Formats for both ends of a route where both are WASAPI exclusive, chosen
+// together so the route avoids resampling where the hardware allows.
+// S_FALSE if the route's endpoints leave nothing to plan.
+HRESULT planRouteFormats(const RouteConfig& config, FormatPlan& plan);
+
+// The format the capture endpoint will most likely open with, known before
+// it is initialized: the configured format, a WAV file's header, or the one
+// a WASAPI exclusive device negotiated last time. False if there is no good
+// guess.
+bool predictCaptureFormat(const RouteConfig& config, AudioFormat& format);
+
+// False where the render side ignores 'preferredFormat' (WASAPI shared mode
+// always runs at the engine's mix format)
+bool renderTakesPreferredFormat(const EndpointConfig& config);
+
+// Create and initialize the capture side of a route for the configured backend.
+// Buffers the endpoint uses on its period thread are taken from 'arena'.
+// 'preferredFormat' (from a plan) is tried first in WASAPI exclusive mode.
+HRESULT createCaptureEndpoint(const EndpointConfig& config, const RouteOptions& options,
+                              AudioArena* arena, RingBuffer* ringBuffer,
+                              const AudioFormat* preferredFormat,
+                              std::unique_ptr<CaptureEndpoint>& out);
+
+// Create and initialize the render side. 'preferredFormat' (the planned
+// render format, else the capture format or a guess at it) is tried first so
+// that the route can run without a resampler.
+HRESULT createRenderEndpoint(const EndpointConfig& config, const RouteOptions& options,
+                             AudioArena* arena, RingBuffer* ringBuffer,
+                             const AudioFormat* preferredFormat,
+                             std::unique_ptr<RenderEndpoint>& out);
@@ -0,0 +1,99 @@
+#include "FormatCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#include "RouteConfig.h"
+#include "WavFile.h"
+
+static std::mutex s_cacheMutex;
+
+struct CacheLine {
+    std::string key;
+    std::string value;
+};
+
+static std::vector<CacheLine> readCache(const std::string& path) {
+    std::vector<CacheLine> lines;
+    FILE* f = openFileUtf8(path.c_str(), "rb");
+    if (!f) return lines;
+
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos) eol = text.size();
+        std::string line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        if (line.empty() || line[0] == ';') continue;
+        size_t eq = line.rfind(" = ");
+        if (eq == std::string::npos) continue;
+        lines.push_back({ line.substr(0, eq), line.substr(eq + 3) });
+    }
+    return lines;
+}
+
+std::string formatCacheKey(const char* direction, const std::string& deviceId, const AudioFormat* preferred) {
+    return std::string(direction) + "|" + deviceId + "|"
+         + (preferred && preferred->isValid() ? audioFormatToString(*preferred) : std::string("-"));
+}
+
+bool loadCachedFormat(const std::string& path, const std::string& key, NegotiatedFormat& entry) {
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    for (const CacheLine& line : readCache(path)) {
+        if (line.key != key) continue;
+        size_t space = line.value.find(' ');
+        if (space == std::string::npos) return false;
+        NegotiatedFormat e;
+        if (!parseAudioFormat(line.value.substr(0, space), e.format)) return false;
+        e.period = std::strtoll(line.value.c_str() + space + 1, nullptr, 10);
+        if (e.period <= 0) return false;
+        entry = e;
+        return true;
+    }
+    return false;
+}
+
+HRESULT storeCachedFormat(const std::string& path, const std::string& key, const NegotiatedFormat* entry) {
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    std::vector<CacheLine> lines = readCache(path);
+    std::vector<CacheLine> kept;
+    for (CacheLine& line : lines)
+        if (line.key != key) kept.push_back(std::move(line));
+    if (entry)
+        kept.push_back({ key, audioFormatToString(entry->format) + " " + std::to_string(entry->period) });
+    else if (kept.size() == lines.size())
+        return S_FALSE;
+
+    FILE* f = openFileUtf8(path.c_str(), "wb");
+    if (!f) return E_ACCESSDENIED;
+    std::fputs("; Exclusive-mode formats negotiated per device, safe to delete\n", f);
+    for (const CacheLine& line : kept)
+        std::fprintf(f, "%s = %s\n", line.key.c_str(), line.value.c_str());
+    const bool ok = std::fclose(f) == 0;
+    return ok ? S_OK : E_FAIL;
+}
+
+HRESULT negotiateCached(DeviceCaps& caps, const std::vector<AudioFormat>& candidates,
+                        const std::string& path, const std::string& key,
+                        NegotiatedFormat& result, NegotiationReport* report) {
+    NegotiationReport local;
+    NegotiationReport& r = report ? *report : local;
+
+    NegotiatedFormat cached;
+    const bool haveCached = !path.empty() && loadCachedFormat(path, key, cached);
+    HRESULT hr = negotiateExclusiveFormat(caps, candidates, haveCached ? &cached : nullptr, result, &r);
+    if (path.empty() || r.cacheHit) return hr;
+
+    // A cache that cannot be written only costs the next start some time
+    if (SUCCEEDED(hr))    storeCachedFormat(path, key, &result);
+    else if (haveCached)  storeCachedFormat(path, key, nullptr);
+    return hr;
+}
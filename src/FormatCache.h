@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include "FormatNegotiator.h"
+
+// Exclusive-mode negotiation results remembered across starts, so a device
+// opens in one Initialize instead of walking the candidate list.
+//
+// Entries live in a small text file next to settings.ini (or the daemon
+// config), one per line:
+//
+//   render|{0.0.0.00000000}.{...}|48000/2/f32 = 48000/2/s24in32 30000
+//
+// keyed by direction, device ID and the preferred format the negotiation
+// started from, with the winning format and period (100 ns) as value.
+// Routes share the file; access is serialized within the process.
+
+// "capture" or "render"; 'preferred' may be null
+std::string formatCacheKey(const char* direction, const std::string& deviceId, const AudioFormat* preferred);
+
+// False if the file or the entry does not exist
+bool    loadCachedFormat(const std::string& path, const std::string& key, NegotiatedFormat& entry);
+// Adds or replaces the entry; null 'entry' removes it
+HRESULT storeCachedFormat(const std::string& path, const std::string& key, const NegotiatedFormat* entry);
+
+// negotiateExclusiveFormat() through the cache at 'path' (empty = no
+// cache): the entry under 'key' is opened first, and the result is stored
+// whenever the full walk had to run. An entry that no longer opens and
+// no longer negotiates is removed.
+HRESULT negotiateCached(DeviceCaps& caps, const std::vector<AudioFormat>& candidates,
+                        const std::string& path, const std::string& key,
+                        NegotiatedFormat& result, NegotiationReport* report = nullptr);
@@ -0,0 +1,108 @@
+#include "FormatNegotiator.h"
+#include <algorithm>
+#include "RouteConfig.h"
+#include "StartupTrace.h"
+
+// 24 valid bits travel in a 32-bit container in exclusive mode
+static AudioFormat exclusiveFormat(uint16_t channels, uint32_t sampleRate, uint16_t bits, bool isFloat) {
+    AudioFormat f;
+    f.sampleRate = sampleRate;
+    f.channels = channels;
+    f.bitsPerSample = (bits == 24) ? 32 : bits;
+    f.validBits = bits;
+    if (isFloat)                    f.type = SampleType::Float32;
+    else if (f.bitsPerSample == 16) f.type = SampleType::Int16;
+    else                            f.type = SampleType::Int32;
+    return f;
+}
+
+std::vector<AudioFormat> exclusiveCandidates(const AudioFormat* preferred) {
+    std::vector<AudioFormat> candidates;
+    if (preferred && preferred->isValid())
+        candidates.push_back(exclusiveFormat(preferred->channels, preferred->sampleRate, preferred->validBits,
+                                             preferred->type == SampleType::Float32));
+
+    struct FormatAttempt { uint16_t ch; uint32_t rate; uint16_t bits; bool isFloat; };
+    static const FormatAttempt attempts[] = {
+        {2, 48000, 32, true},   // 32-bit float 48kHz stereo
+        {2, 48000, 24, false},  // 24-bit PCM 48kHz
+        {2, 48000, 16, false},  // 16-bit PCM 48kHz
+        {2, 44100, 32, true},   // 32-bit float 44.1kHz
+        {2, 44100, 24, false},  // 24-bit PCM 44.1kHz
+        {2, 44100, 16, false},  // 16-bit PCM 44.1kHz
+        {1, 48000, 16, false},  // mono fallbacks
+        {1, 44100, 16, false},
+    };
+    for (const FormatAttempt& a : attempts) {
+        AudioFormat f = exclusiveFormat(a.ch, a.rate, a.bits, a.isFloat);
+        if (std::find(candidates.begin(), candidates.end(), f) == candidates.end())
+            candidates.push_back(f);
+    }
+    return candidates;
+}
+
+// Open at 'period', and once more at the driver's aligned size if it asks
+static HRESULT openAligned(DeviceCaps& caps, const AudioFormat& format, HnsTime& period, UINT32& calls) {
+    UINT32 alignedFrames = 0;
+    ++calls;
+    HRESULT hr = caps.open(format, period, alignedFrames);
+    if (hr != AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) return hr;
+
+    // The client cannot be initialized twice
+    ++calls;
+    RETURN_IF_FAILED(caps.reactivate());
+    period = static_cast<HnsTime>(10000000.0 * alignedFrames / format.sampleRate + 0.5);
+    ++calls;
+    return caps.open(format, period, alignedFrames);
+}
+
+static HRESULT tryFormat(DeviceCaps& caps, const AudioFormat& format, NegotiatedFormat& result, UINT32& calls) {
+    ++calls;
+    if (!caps.isSupported(format)) return AUDCLNT_E_UNSUPPORTED_FORMAT;
+
+    HnsTime defaultPeriod = 0, minPeriod = 0;
+    ++calls;
+    RETURN_IF_FAILED(caps.devicePeriod(defaultPeriod, minPeriod));
+
+    // Use half of defaultPeriod for a good latency/reliability balance.
+    // minPeriod alone is too aggressive and causes underruns on most hardware.
+    HnsTime period = (defaultPeriod / 2 > minPeriod) ? defaultPeriod / 2 : minPeriod;
+    RETURN_IF_FAILED(openAligned(caps, format, period, calls));
+
+    result.format = format;
+    result.period = period;
+    return S_OK;
+}
+
+HRESULT negotiateExclusiveFormat(DeviceCaps& caps, const std::vector<AudioFormat>& candidates,
+                                 const NegotiatedFormat* cached, NegotiatedFormat& result,
+                                 NegotiationReport* report) {
+    NegotiationReport local;
+    NegotiationReport& r = report ? *report : local;
+    r = NegotiationReport();
+
+    if (cached && cached->format.isValid() && cached->period > 0) {
+        HnsTime period = cached->period;
+        HRESULT hr = S_OK;
+        {
+            StartupTimer timer("cached " + audioFormatToString(cached->format));
+            hr = openAligned(caps, cached->format, period, r.deviceCalls);
+        }
+        if (SUCCEEDED(hr)) {
+            result.format = cached->format;
+            result.period = period;
+            r.cacheHit = true;
+            return S_OK;
+        }
+        // Driver or device changed since: start over with a clean client
+        ++r.deviceCalls;
+        RETURN_IF_FAILED(caps.reactivate());
+    }
+
+    for (const AudioFormat& format : candidates) {
+        ++r.candidatesTried;
+        StartupTimer timer("format " + audioFormatToString(format));
+        if (SUCCEEDED(tryFormat(caps, format, result, r.deviceCalls))) return S_OK;
+    }
+    return AUDCLNT_E_UNSUPPORTED_FORMAT;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Platform.h"
+#include "SampleFormat.h"
+
+#ifdef _WIN32
+#include <audioclient.h>
+#else
+#define AUDCLNT_E_UNSUPPORTED_FORMAT       ((HRESULT)0x88890008L)
+#define AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED  ((HRESULT)0x88890019L)
+#endif
+
+// Durations in 100-ns units, as WASAPI's REFERENCE_TIME
+typedef int64_t HnsTime;
+
+// What exclusive-mode negotiation asks of a device. The WASAPI endpoints
+// implement it over IAudioClient; MockDeviceCaps answers from a table.
+class DeviceCaps {
+public:
+    virtual ~DeviceCaps() = default;
+
+    // IsFormatSupported in exclusive mode
+    virtual bool    isSupported(const AudioFormat& format) = 0;
+    virtual HRESULT devicePeriod(HnsTime& defaultPeriod, HnsTime& minPeriod) = 0;
+    // Initialize with buffer and period both 'period'. On
+    // AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED, alignedFrames is the size to retry with.
+    virtual HRESULT open(const AudioFormat& format, HnsTime period, UINT32& alignedFrames) = 0;
+    // A fresh client after a failed open (Activate again)
+    virtual HRESULT reactivate() = 0;
+};
+
+// Outcome of a negotiation; this is also what the cache remembers
+struct NegotiatedFormat {
+    AudioFormat format;
+    HnsTime     period = 0;
+};
+
+struct NegotiationReport {
+    bool   cacheHit = false;        // the cached result opened directly
+    UINT32 candidatesTried = 0;     // formats tried in the full walk
+    UINT32 deviceCalls = 0;         // calls into DeviceCaps
+};
+
+// Exclusive-mode candidates in priority order: the preferred format (e.g.
+// the other end's, for a conversion-free route) first, then the standard
+// list from 48 kHz float stereo down to 44.1 kHz 16-bit mono. 24-bit
+// formats are 24 valid bits in a 32-bit container.
+std::vector<AudioFormat> exclusiveCandidates(const AudioFormat* preferred = nullptr);
+
+// Opens 'caps' in the first candidate it accepts, at half the default
+// period (but not below the minimum), realigned once if the driver asks.
+// With 'cached', that format and period are opened first, skipping the
+// support and period queries; if it no longer opens, the full walk follows.
+// AUDCLNT_E_UNSUPPORTED_FORMAT if no candidate opens.
+HRESULT negotiateExclusiveFormat(DeviceCaps& caps, const std::vector<AudioFormat>& candidates,
+                                 const NegotiatedFormat* cached, NegotiatedFormat& result,
+                                 NegotiationReport* report = nullptr);
@@ -0,0 +1,133 @@
+#include "FormatPlanner.h"
+#include <algorithm>
+#include "FormatCache.h"
+#include "RouteConfig.h"
+
+static const UINT32 kResampleCost = 100;
+static const UINT32 kChannelCost = 10;
+static const UINT32 kTypeCost = 1;
+
+static std::string typeName(const AudioFormat& f) {
+    // "48000/2/s24in32" -> "s24in32"
+    const std::string s = audioFormatToString(f);
+    return s.substr(s.rfind('/') + 1);
+}
+
+UINT32 conversionCost(const AudioFormat& from, const AudioFormat& to) {
+    UINT32 cost = 0;
+    if (from.sampleRate != to.sampleRate) cost += kResampleCost;
+    if (from.channels != to.channels)     cost += kChannelCost;
+    if (from.type != to.type || from.validBits != to.validBits) {
+        cost += kTypeCost;
+        // Narrowing also throws resolution away
+        if (to.validBits < from.validBits) cost += kTypeCost;
+    }
+    return cost;
+}
+
+std::string describeConversion(const AudioFormat& from, const AudioFormat& to) {
+    std::vector<std::string> steps;
+    if (from.sampleRate != to.sampleRate)
+        steps.push_back("resampling " + std::to_string(from.sampleRate) + " -> " + std::to_string(to.sampleRate) + " Hz");
+    if (from.channels != to.channels)
+        steps.push_back(std::to_string(from.channels) + " -> " + std::to_string(to.channels) + " channels");
+    if (from.type != to.type || from.validBits != to.validBits)
+        steps.push_back(typeName(from) + " -> " + typeName(to));
+    if (steps.empty()) return "no conversion";
+
+    std::string text = steps[0];
+    for (size_t i = 1; i < steps.size(); ++i) text += ", " + steps[i];
+    return text;
+}
+
+HRESULT probeDevice(DeviceCaps& caps, const std::vector<AudioFormat>& candidates, DeviceProfile& profile) {
+    profile = DeviceProfile();
+    for (const AudioFormat& format : candidates)
+        if (caps.isSupported(format)) profile.formats.push_back(format);
+
+    HnsTime defaultPeriod = 0, minPeriod = 0;
+    RETURN_IF_FAILED(caps.devicePeriod(defaultPeriod, minPeriod));
+    profile.period = (defaultPeriod / 2 > minPeriod) ? defaultPeriod / 2 : minPeriod;
+    return S_OK;
+}
+
+std::string describeFormatPair(const AudioFormat& capture, const AudioFormat& render) {
+    if (capture == render) return audioFormatToString(capture) + " on both ends, no conversion";
+    return audioFormatToString(capture) + " -> " + audioFormatToString(render) + ", "
+         + describeConversion(capture, render);
+}
+
+bool planFormats(const DeviceProfile& capture, const DeviceProfile& render, FormatPlan& plan) {
+    if (capture.formats.empty() || render.formats.empty()) return false;
+
+    bool found = false;
+    size_t bestRank = 0;
+    for (size_t c = 0; c < capture.formats.size(); ++c) {
+        for (size_t r = 0; r < render.formats.size(); ++r) {
+            const UINT32 cost = conversionCost(capture.formats[c], render.formats[r]);
+            if (found && (cost > plan.cost || (cost == plan.cost && c + r >= bestRank))) continue;
+            found = true;
+            bestRank = c + r;
+            plan.capture = capture.formats[c];
+            plan.render = render.formats[r];
+            plan.cost = cost;
+        }
+    }
+    plan.cached = false;
+    plan.reason = describeFormatPair(plan.capture, plan.render);
+
+    // What separate negotiation would have done: capture takes its first
+    // choice, render tries that and otherwise takes its own first choice
+    const AudioFormat& alone = capture.formats[0];
+    const bool renderTakes = std::find(render.formats.begin(), render.formats.end(), alone) != render.formats.end();
+    const AudioFormat& aloneRender = renderTakes ? alone : render.formats[0];
+    if (conversionCost(alone, aloneRender) > plan.cost)
+        plan.reason += " (separately: " + describeFormatPair(alone, aloneRender) + ")";
+    return true;
+}
+
+static std::string planKey(const char* end, const std::string& captureId, const std::string& renderId) {
+    return formatCacheKey(end, captureId + ">" + renderId, nullptr);
+}
+
+HRESULT planExclusiveRoute(DeviceCaps& capture, DeviceCaps& render,
+                           const std::string& captureId, const std::string& renderId,
+                           const std::string& cachePath, FormatPlan& plan) {
+    const std::string captureKey = planKey("plan-capture", captureId, renderId);
+    const std::string renderKey = planKey("plan-render", captureId, renderId);
+
+    NegotiatedFormat cachedCapture, cachedRender;
+    if (!cachePath.empty() && loadCachedFormat(cachePath, captureKey, cachedCapture)
+                           && loadCachedFormat(cachePath, renderKey, cachedRender)) {
+        plan.capture = cachedCapture.format;
+        plan.render = cachedRender.format;
+        plan.cost = conversionCost(plan.capture, plan.render);
+        plan.cached = true;
+        plan.reason = describeFormatPair(plan.capture, plan.render) + " (cached plan)";
+        return S_OK;
+    }
+
+    const std::vector<AudioFormat> candidates = exclusiveCandidates();
+    DeviceProfile captureProfile, renderProfile;
+    RETURN_IF_FAILED(probeDevice(capture, candidates, captureProfile));
+    RETURN_IF_FAILED(probeDevice(render, candidates, renderProfile));
+    if (!planFormats(captureProfile, renderProfile, plan)) return E_FAIL;
+
+    if (!cachePath.empty()) {
+        NegotiatedFormat entry;
+        entry.format = plan.capture;
+        entry.period = captureProfile.period;
+        storeCachedFormat(cachePath, captureKey, &entry);
+        entry.format = plan.render;
+        entry.period = renderProfile.period;
+        storeCachedFormat(cachePath, renderKey, &entry);
+    }
+    return S_OK;
+}
+
+void forgetExclusivePlan(const std::string& captureId, const std::string& renderId,
+                         const std::string& cachePath) {
+    if (cachePath.empty()) return;
+    storeCachedFormat(cachePath, planKey("plan-capture", captureId, renderId), nullptr);
+    storeCachedFormat(cachePath, planKey("plan-render", captureId, renderId), nullptr);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "FormatNegotiator.h"
+
+// What one device accepts, probed without opening it.
+struct DeviceProfile {
+    std::vector<AudioFormat> formats;   // supported candidates, in priority order
+    HnsTime                  period = 0;
+};
+
+// Formats for both ends of a route, chosen together.
+struct FormatPlan {
+    AudioFormat capture;
+    AudioFormat render;
+    UINT32      cost = 0;       // conversionCost(capture, render)
+    bool        cached = false; // taken from the format cache, not probed
+    std::string reason;         // one line for the status
+};
+
+// Relative cost of taking a stream from one format to the other in this
+// pipeline: 0 for identical formats, small for a sample type or channel
+// change, large for anything that needs resampling.
+UINT32 conversionCost(const AudioFormat& from, const AudioFormat& to);
+// "no conversion", or what has to happen, e.g. "resampling 48000 -> 44100 Hz, f32 -> s16"
+std::string describeConversion(const AudioFormat& from, const AudioFormat& to);
+// "48000/2/f32 on both ends, no conversion" or "<capture> -> <render>, <conversion>"
+std::string describeFormatPair(const AudioFormat& capture, const AudioFormat& render);
+
+// Support query for every candidate, plus the device period
+HRESULT probeDevice(DeviceCaps& caps, const std::vector<AudioFormat>& candidates, DeviceProfile& profile);
+
+// Picks the pair with the lowest conversion cost, so a rate both devices
+// share wins over each device's own first choice; ties go to the higher
+// candidate priority. The reason compares the plan with what negotiating
+// each device on its own (capture first) would have given. False if either
+// device supports none of the candidates.
+bool planFormats(const DeviceProfile& capture, const DeviceProfile& render, FormatPlan& plan);
+
+// planFormats() over freshly probed devices, or the plan remembered in the
+// format cache at 'cachePath' for this pair of devices (empty path = no
+// cache). E_FAIL if there is no plan.
+HRESULT planExclusiveRoute(DeviceCaps& capture, DeviceCaps& render,
+                           const std::string& captureId, const std::string& renderId,
+                           const std::string& cachePath, FormatPlan& plan);
+// Drops a remembered plan that did not open as planned
+void    forgetExclusivePlan(const std::string& captureId, const std::string& renderId,
+                            const std::string& cachePath);
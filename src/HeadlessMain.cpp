@@ -0,0 +1,433 @@
+// Headless entry point: runs the routes from a config file without any UI.
+//
+//   audiobridge_cli <config.ini>
+//   audiobridge_cli --list-devices        (Windows)
+//
+// Stops cleanly on Ctrl+C / SIGTERM (or console close on Windows).
+//
+// Lines on stdin change running routes without restarting them:
+//
+//   gain <route> <dB>                   output gain
+//   mute <route> 0|1
+//   matrix <route> <out> <in> <gain>    channel matrix entry, linear, 0-based
+//   insert <route> <index> <spec>       insert (0-based, config order), same
+//                                       syntax and type as its Insert line
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RouteManager.h"
+#include "RouteConfig.h"
+#include "RealtimeCheck.h"
+#ifdef _WIN32
+#include "ComHelper.h"
+#include "DeviceEnumerator.h"
+#endif
+
+static std::atomic<bool> g_stopRequested{false};
+
+static void logLine(const char* fmt, ...) {
+    std::time_t now = std::time(nullptr);
+    std::tm tmNow = {};
+#ifdef _WIN32
+    localtime_s(&tmNow, &now);
+#else
+    localtime_r(&now, &tmNow);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tmNow);
+
+    std::fprintf(stdout, "%s ", stamp);
+    va_list args;
+    va_start(args, fmt);
+    std::vfprintf(stdout, fmt, args);
+    va_end(args);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+// Lines read from stdin, handled on the main loop
+static std::mutex               g_commandMutex;
+static std::vector<std::string> g_commands;
+
+static void readCommands() {
+    char line[512];
+    while (std::fgets(line, sizeof(line), stdin)) {
+        std::lock_guard<std::mutex> lock(g_commandMutex);
+        g_commands.emplace_back(line);
+    }
+}
+
+static void runCommand(RouteManager& manager, const std::string& line) {
+    char verb[16] = "", route[128] = "";
+    int consumed = 0;
+    if (std::sscanf(line.c_str(), "%15s %127s %n", verb, route, &consumed) < 2) {
+        if (verb[0]) logLine("unknown command: %s", verb);
+        return;
+    }
+    const char* args = line.c_str() + consumed;
+
+    HRESULT hr = E_INVALIDARG;
+    if (std::strcmp(verb, "gain") == 0) {
+        float db = 0.0f;
+        if (std::sscanf(args, "%f", &db) == 1) hr = manager.setOutputGain(route, db);
+    } else if (std::strcmp(verb, "mute") == 0) {
+        int mute = 0;
+        if (std::sscanf(args, "%d", &mute) == 1) hr = manager.setMute(route, mute != 0);
+    } else if (std::strcmp(verb, "matrix") == 0) {
+        unsigned out = 0, in = 0;
+        float gain = 0.0f;
+        if (std::sscanf(args, "%u %u %f", &out, &in, &gain) == 3) hr = manager.setMatrixGain(route, out, in, gain);
+    } else if (std::strcmp(verb, "insert") == 0) {
+        unsigned index = 0;
+        char spec[256] = "";
+        DspStageConfig stage;
+        if (std::sscanf(args, "%u %255s", &index, spec) == 2 && parseInsertStage(spec, stage))
+            hr = manager.setInsert(route, index, stage);
+    } else {
+        logLine("unknown command: %s", verb);
+        return;
+    }
+
+    std::string text = line;
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+    if (SUCCEEDED(hr)) logLine("[%s] %s", route, text.c_str());
+    else               logLine("[%s] %s failed (0x%08X)", route, text.c_str(), static_cast<unsigned>(hr));
+}
+
+static void onSignal(int) {
+    g_stopRequested.store(true);
+}
+
+#ifdef _WIN32
+static BOOL WINAPI onConsoleCtrl(DWORD) {
+    g_stopRequested.store(true);
+    return TRUE;
+}
+
+static int listDevices() {
+    std::vector<AudioDeviceInfo> devices;
+    DeviceEnumerator::enumerateCapture(devices);
+    std::printf("Capture devices:\n");
+    for (auto& d : devices)
+        std::printf("  wasapi:%s  (%s)\n", wideToUtf8(d.id).c_str(), wideToUtf8(d.name).c_str());
+    DeviceEnumerator::enumerateRender(devices);
+    std::printf("Render devices:\n");
+    for (auto& d : devices)
+        std::printf("  wasapi:%s  (%s)\n", wideToUtf8(d.id).c_str(), wideToUtf8(d.name).c_str());
+    return 0;
+}
+#endif
+
+static const char* stateName(RouterState s) {
+    switch (s) {
+        case RouterState::Starting: return "starting";
+        case RouterState::Stopping: return "stopping";
+        case RouterState::Running: return "running";
+        case RouterState::Error:   return "error";
+        default:                   return "stopped";
+    }
+}
+
+static const char* gateName(const RouterStatus& rs) {
+    if (!rs.gateEnabled) return "off";
+    switch (rs.gateState) {
+        case GateState::Hold: return "hold";
+        case GateState::Idle: return "idle";
+        default:              return "active";
+    }
+}
+
+static void logTransport(const RouteStatusEntry& route, const TransportStats& t, bool capture) {
+    if (!t.transport) return;
+    const char* dir = capture ? "in" : "out";
+
+    if (std::strcmp(t.transport, "rtp") == 0 && capture) {
+        logLine("[%s] rtp in rx=%llu lost=%llu late=%llu skipped=%llu inserted=%llu jitter=%.1fms buffer=%.0f/%.0fms",
+                route.name.c_str(),
+                static_cast<unsigned long long>(t.packets), static_cast<unsigned long long>(t.lost),
+                static_cast<unsigned long long>(t.late), static_cast<unsigned long long>(t.skipped),
+                static_cast<unsigned long long>(t.inserted), t.jitterMs, t.bufferMs, t.targetMs);
+    } else if (std::strcmp(t.transport, "rtp") == 0) {
+        logLine("[%s] rtp out tx=%llu dropped=%llu reordered=%llu", route.name.c_str(),
+                static_cast<unsigned long long>(t.packets), static_cast<unsigned long long>(t.lost),
+                static_cast<unsigned long long>(t.reordered));
+    } else {
+        logLine("[%s] %s %s pos=%llu buffer=%.1fms dropped=%llu", route.name.c_str(), t.transport, dir,
+                static_cast<unsigned long long>(t.position), t.bufferMs,
+                static_cast<unsigned long long>(t.droppedFrames));
+    }
+}
+
+// Per-channel values joined with '/', e.g. "-20.1/-19.8"
+static void logLevels(const RouteStatusEntry& route, const LevelSnapshot& l, const char* dir) {
+    if (l.channels == 0) return;
+    std::string peak, rms, clips;
+    char num[32];
+    for (uint32_t c = 0; c < l.channels; ++c) {
+        const char* sep = c ? "/" : "";
+        std::snprintf(num, sizeof(num), "%s%.1f", sep, levelToDb(l.peak[c]));
+        peak += num;
+        std::snprintf(num, sizeof(num), "%s%.1f", sep, levelToDb(l.rms[c]));
+        rms += num;
+        std::snprintf(num, sizeof(num), "%s%llu", sep, static_cast<unsigned long long>(l.clips[c]));
+        clips += num;
+    }
+    logLine("[%s] levels %s peak=%s rms=%s dBFS clips=%s", route.name.c_str(), dir,
+            peak.c_str(), rms.c_str(), clips.c_str());
+}
+
+static std::string clockText(bool valid, double ppm, double bound) {
+    if (!valid) return "-";
+    char text[48];
+    std::snprintf(text, sizeof(text), "%+.1f~%.1fppm", ppm, bound);
+    return text;
+}
+
+// Device clocks against the steady clock, and capture against render
+static void logClocks(const RouteStatusEntry& route) {
+    const RouterStatus& rs = route.status;
+    if (!rs.captureClock.valid && !rs.renderClock.valid) return;
+    logLine("[%s] clock cap=%s ren=%s ratio=%s window=%.0fs", route.name.c_str(),
+            clockText(rs.captureClock.valid, rs.captureClock.ppm, rs.captureClock.ppmBound).c_str(),
+            clockText(rs.renderClock.valid, rs.renderClock.ppm, rs.renderClock.ppmBound).c_str(),
+            clockText(rs.clockRatio.valid, rs.clockRatio.ppm, rs.clockRatio.ppmBound).c_str(),
+            (std::max)(rs.captureClock.windowSec, rs.renderClock.windowSec));
+}
+
+// Totals of the passthrough check
+static void logVerify(const RouteStatusEntry& route) {
+    const VerifyStats& v = route.status.verify;
+    if (!v.active) return;
+    logLine("[%s] verify intact=%llu (%.1fMB) dropped=%llu duplicated=%llu corrupted=%llu", route.name.c_str(),
+            static_cast<unsigned long long>(v.blocks), static_cast<double>(v.bytes) / 1e6,
+            static_cast<unsigned long long>(v.dropped),
+            static_cast<unsigned long long>(v.duplicated),
+            static_cast<unsigned long long>(v.corrupted));
+}
+
+static void logStats(const RouteStatusEntry& route) {
+    const RouterStatus& rs = route.status;
+    if (rs.state != RouterState::Running) {
+        logLine("[%s] %s %ls", route.name.c_str(), stateName(rs.state), rs.errorMessage.c_str());
+        return;
+    }
+
+    double concealedMs = rs.renderFormat.sampleRate
+        ? 1000.0 * rs.concealedFrames / rs.renderFormat.sampleRate : 0.0;
+
+    char inserts[32] = "";
+    if (rs.insertStages > 0) std::snprintf(inserts, sizeof(inserts), " inserts=%u", rs.insertStages);
+    char stalls[96] = "";
+    if (rs.captureWatchdog.stalls + rs.renderWatchdog.stalls > 0) {
+        std::snprintf(stalls, sizeof(stalls), " stalls=%llu/%llu recovered=%llu/%llu",
+                      static_cast<unsigned long long>(rs.captureWatchdog.stalls),
+                      static_cast<unsigned long long>(rs.renderWatchdog.stalls),
+                      static_cast<unsigned long long>(rs.captureWatchdog.recoveries),
+                      static_cast<unsigned long long>(rs.renderWatchdog.recoveries));
+    }
+    char rec[96] = "";
+    if (rs.recording && rs.recordFormat.sampleRate > 0) {
+        std::snprintf(rec, sizeof(rec), " rec=%.0fs dropped=%llu%s",
+                      static_cast<double>(rs.recordedFrames) / rs.recordFormat.sampleRate,
+                      static_cast<unsigned long long>(rs.recordDroppedFrames),
+                      rs.recordFailed ? " (write failed)" : "");
+    }
+    logLine("[%s] running cap=%s buf=%u ren=%s buf=%u underruns=%llu plc=%.0fms gate=%s resampler=%s%s locked=%lluK/%lluK%s%s",
+            route.name.c_str(),
+            audioFormatToString(rs.captureFormat).c_str(), rs.captureBufferFrames,
+            audioFormatToString(rs.renderFormat).c_str(), rs.renderBufferFrames,
+            static_cast<unsigned long long>(rs.underruns), concealedMs,
+            gateName(rs), rs.resamplerActive ? "on" : "off", inserts,
+            static_cast<unsigned long long>(rs.lockedBytes / 1024),
+            static_cast<unsigned long long>(rs.arenaBytes / 1024), rec, stalls);
+
+    logLevels(route, rs.captureLevels, "in");
+    logLevels(route, rs.renderLevels, "out");
+    if (rs.spectrum) {
+        logLine("[%s] spectrum frames=%llu dropped=%llu peak=%.1fHz %.1fdBFS", route.name.c_str(),
+                static_cast<unsigned long long>(rs.spectrumFrames),
+                static_cast<unsigned long long>(rs.spectrumDropped), rs.spectrumPeakHz, rs.spectrumPeakDb);
+    }
+    logTransport(route, rs.captureTransport, true);
+    logTransport(route, rs.renderTransport, false);
+    logClocks(route);
+    logVerify(route);
+}
+
+// Stall and recovery events of one endpoint since the last call
+static void logWatchdog(const std::string& name, const char* end, const WatchdogStats& now, WatchdogStats& seen) {
+    if (now.stalls > seen.stalls)
+        logLine("[%s] %s stalled, reopening", name.c_str(), end);
+    if (now.recoveries > seen.recoveries)
+        logLine("[%s] %s recovered in %.0fms (%llu failed attempts so far)", name.c_str(), end,
+                now.lastRecoveryMs, static_cast<unsigned long long>(now.failedAttempts));
+    if (now.gaveUp && !seen.gaveUp)
+        logLine("[%s] %s did not recover, giving up", name.c_str(), end);
+    seen = now;
+}
+
+// Passthrough faults since the last call, with when the latest happened
+static void logVerifyEvents(const std::string& name, const VerifyStats& now, VerifyStats& seen) {
+    if (now.dropped > seen.dropped)
+        logLine("[%s] verify: %llu blocks dropped (at %.3fs)", name.c_str(),
+                static_cast<unsigned long long>(now.dropped - seen.dropped), now.lastDropSec);
+    if (now.duplicated > seen.duplicated)
+        logLine("[%s] verify: %llu blocks duplicated (at %.3fs)", name.c_str(),
+                static_cast<unsigned long long>(now.duplicated - seen.duplicated), now.lastDuplicateSec);
+    if (now.corrupted > seen.corrupted)
+        logLine("[%s] verify: %llu blocks corrupted (at %.3fs)", name.c_str(),
+                static_cast<unsigned long long>(now.corrupted - seen.corrupted), now.lastCorruptSec);
+    seen = now;
+}
+
+static void logThreads(const RouteStatusEntry& route) {
+    const RouterStatus& rs = route.status;
+    if (rs.state != RouterState::Running) return;
+    logLine("[%s] threads capture=%s render=%s resampler=%s", route.name.c_str(),
+            describeRealtime(rs.captureThread).c_str(),
+            describeRealtime(rs.renderThread).c_str(),
+            rs.resamplerActive ? describeRealtime(rs.resamplerThread).c_str() : "-");
+}
+
+// One key=value line per route: every phase of the start and the first render period
+static void logStartup(const std::string& name, const RouterStatus& rs) {
+    logLine("[%s] startup %s", name.c_str(), describeStartup(rs.startup).c_str());
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0) {
+        std::fprintf(stderr, "usage: %s <config.ini>\n", argv[0]);
+#ifdef _WIN32
+        std::fprintf(stderr, "       %s --list-devices\n", argv[0]);
+#endif
+        return 2;
+    }
+
+#ifdef _WIN32
+    CoInitializeGuard comGuard(COINIT_MULTITHREADED);
+    if (!comGuard) {
+        std::fprintf(stderr, "COM initialisation failed\n");
+        return 1;
+    }
+    if (std::strcmp(argv[1], "--list-devices") == 0)
+        return listDevices();
+    SetConsoleCtrlHandler(onConsoleCtrl, TRUE);
+#endif
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    DaemonConfig config;
+    std::string error;
+    if (FAILED(loadDaemonConfig(argv[1], config, error))) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    RouteManager manager(config.workerThreads, config.workerPolicy);
+    int started = 0;
+    for (auto& route : config.routes) {
+        manager.addRoute(route);
+        HRESULT hr = manager.startRoute(route.name);
+        if (SUCCEEDED(hr)) {
+            ++started;
+            logLine("[%s] started", route.name.c_str());
+            RouterStatus rs;
+            if (SUCCEEDED(manager.getStatus(route.name, rs)))
+                logLine("[%s] formats %s", route.name.c_str(), rs.formatPlan.c_str());
+        } else {
+            RouterStatus rs;
+            manager.getStatus(route.name, rs);
+            logLine("[%s] failed to start: %ls", route.name.c_str(), rs.errorMessage.c_str());
+            logStartup(route.name, rs);
+        }
+    }
+    if (started == 0) {
+        logLine("no route could be started");
+        return 1;
+    }
+    logLine("%d of %zu routes running, %u shared worker threads",
+            started, config.routes.size(), manager.workerThreadCount());
+
+    const auto statsInterval = std::chrono::seconds(config.statsIntervalSec);
+    auto nextStats = std::chrono::steady_clock::now() + statsInterval;
+    // Report the scheduling the audio threads obtained, and how long each
+    // route took to its first render period, once they are all up
+    auto threadsAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    bool threadsLogged = false;
+    // Watchdog counters already logged, capture and render per route
+    std::map<std::string, WatchdogStats[2]> watchdogSeen;
+    // Passthrough faults already logged, per route
+    std::map<std::string, VerifyStats> verifySeen;
+    // Blocks in fgets for the life of the process, so it is never joined
+    std::thread(readCommands).detach();
+    while (!g_stopRequested.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::vector<std::string> commands;
+        {
+            std::lock_guard<std::mutex> lock(g_commandMutex);
+            commands.swap(g_commands);
+        }
+        for (const std::string& command : commands)
+            runCommand(manager, command);
+        if (!threadsLogged && std::chrono::steady_clock::now() >= threadsAt) {
+            threadsLogged = true;
+            for (auto& route : manager.getStatus()) {
+                logThreads(route);
+                if (route.status.state == RouterState::Running) logStartup(route.name, route.status);
+            }
+        }
+        if (config.statsIntervalSec > 0 && std::chrono::steady_clock::now() >= nextStats) {
+            nextStats += statsInterval;
+            for (auto& route : manager.getStatus())
+                logStats(route);
+        }
+
+        auto routes = manager.getStatus();
+        for (auto& route : routes) {
+            WatchdogStats* seen = watchdogSeen[route.name];
+            logWatchdog(route.name, "capture", route.status.captureWatchdog, seen[0]);
+            logWatchdog(route.name, "render", route.status.renderWatchdog, seen[1]);
+            logVerifyEvents(route.name, route.status.verify, verifySeen[route.name]);
+        }
+
+        // Offline runs: stop once every running route has played a finite
+        // source (a file without Loop) to the end
+        size_t running = 0, finished = 0;
+        for (auto& route : routes) {
+            if (route.status.state != RouterState::Running) continue;
+            ++running;
+            if (route.status.finished) ++finished;
+        }
+        if (running > 0 && finished == running) {
+            for (auto& route : routes)
+                logStats(route);
+            logLine("all sources finished");
+            break;
+        }
+    }
+
+    logLine("shutting down");
+    for (auto& route : config.routes) {
+        manager.stopRoute(route.name);
+        logLine("[%s] stopped", route.name.c_str());
+    }
+
+#ifdef AUDIOBRIDGE_RT_CHECK
+    // Non-zero exit so scripted runs fail on realtime-unsafe calls
+    UINT64 violations = rtCheckViolations();
+    logLine("realtime check: %llu violations", static_cast<unsigned long long>(violations));
+    if (violations > 0) return 3;
+#endif
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "LevelMeter.h"
+#include "AudioKernels.h"
+#include <algorithm>
+#include <cmath>
+
+void LevelMeter::init(const AudioFormat& format, uint32_t windowMs) {
+    m_format = format;
+    m_channels = (format.isValid() && format.channels <= kMaxMeterChannels) ? format.channels : 0;
+    m_windowFrames = (std::max)(static_cast<uint32_t>(static_cast<uint64_t>(format.sampleRate) * windowMs / 1000), 1u);
+    reset();
+}
+
+void LevelMeter::reset() {
+    m_frames = 0;
+    for (uint32_t c = 0; c < kMaxMeterChannels; ++c) {
+        m_peak[c] = 0.0f;
+        m_sumSquares[c] = 0.0f;
+        m_clipsBlock[c] = 0;
+        m_clips[c] = 0;
+    }
+    // Readers see "no levels" until the first window completes
+    m_seq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_pubChannels.store(0, std::memory_order_relaxed);
+    m_seq.fetch_add(1, std::memory_order_release);
+}
+
+float LevelMeter::process(const uint8_t* data, uint32_t frames) {
+    if (m_channels == 0) return peakAbs(m_format.type, data, static_cast<size_t>(frames) * m_format.channels);
+
+    float peak = accumulateLevels(m_format.type, data, frames, m_channels,
+                                  m_peak, m_sumSquares, m_clipsBlock);
+    advance(frames);
+    return peak;
+}
+
+void LevelMeter::processSilence(uint32_t frames) {
+    if (m_channels == 0) return;
+    advance(frames);
+}
+
+void LevelMeter::advance(uint32_t frames) {
+    m_frames += frames;
+    if (m_frames >= m_windowFrames) publish();
+}
+
+void LevelMeter::publish() {
+    const float invFrames = 1.0f / static_cast<float>(m_frames);
+
+    m_seq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t c = 0; c < m_channels; ++c) {
+        m_clips[c] += m_clipsBlock[c];
+        m_pubPeak[c].store(m_peak[c], std::memory_order_relaxed);
+        m_pubRms[c].store(std::sqrt(m_sumSquares[c] * invFrames), std::memory_order_relaxed);
+        m_pubClips[c].store(m_clips[c], std::memory_order_relaxed);
+        m_peak[c] = 0.0f;
+        m_sumSquares[c] = 0.0f;
+        m_clipsBlock[c] = 0;
+    }
+    m_pubChannels.store(m_channels, std::memory_order_relaxed);
+    m_seq.fetch_add(1, std::memory_order_release);
+
+    m_frames = 0;
+}
+
+LevelSnapshot LevelMeter::snapshot() const {
+    LevelSnapshot s;
+    for (;;) {
+        uint32_t before = m_seq.load(std::memory_order_acquire);
+        if (before & 1) continue;   // the audio thread is mid-publish; a few stores at most
+
+        s.channels = m_pubChannels.load(std::memory_order_relaxed);
+        for (uint32_t c = 0; c < s.channels; ++c) {
+            s.peak[c] = m_pubPeak[c].load(std::memory_order_relaxed);
+            s.rms[c] = m_pubRms[c].load(std::memory_order_relaxed);
+            s.clips[c] = m_pubClips[c].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_seq.load(std::memory_order_relaxed) == before) return s;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include "SampleFormat.h"
+
+// Channels metered per endpoint; a stream with more is not metered
+constexpr uint32_t kMaxMeterChannels = 32;
+
+// Levels of the most recent metering window.
+struct LevelSnapshot {
+    uint32_t channels = 0;                      // 0 = no levels yet
+    float    peak[kMaxMeterChannels] = {};      // linear, full scale = 1.0
+    float    rms[kMaxMeterChannels] = {};
+    uint64_t clips[kMaxMeterChannels] = {};     // clipped samples since start
+};
+
+// Lowest level reported, in dBFS; digital silence reads as this
+constexpr float kMeterFloorDb = -120.0f;
+
+inline float levelToDb(float linear) {
+    return linear > 1e-6f ? 20.0f * std::log10(linear) : kMeterFloorDb;
+}
+
+// Per-channel peak/RMS/clip meter fed by the audio thread.
+//
+// The endpoint hands every block it moves to process(); the statistics are
+// gathered in the same SIMD pass that the activity gate needs anyway. Each
+// completed window (default 100 ms) is published through a sequence lock,
+// so any number of readers (the UI timer, the CLI stats) can take a
+// consistent snapshot without ever blocking the audio thread.
+class LevelMeter {
+public:
+    void init(const AudioFormat& format, uint32_t windowMs = 100);
+    void reset();
+
+    // Audio thread: meter a block; returns its peak over all channels
+    float process(const uint8_t* data, uint32_t frames);
+    void  processSilence(uint32_t frames);
+
+    // Any thread
+    LevelSnapshot snapshot() const;
+
+private:
+    void advance(uint32_t frames);
+    void publish();
+
+    AudioFormat m_format;
+    uint32_t    m_channels = 0;     // metered channels, 0 = off
+    uint32_t    m_windowFrames = 0;
+    uint32_t    m_frames = 0;       // frames in the current window
+
+    // Current window, audio thread only
+    float       m_peak[kMaxMeterChannels] = {};
+    float       m_sumSquares[kMaxMeterChannels] = {};
+    uint32_t    m_clipsBlock[kMaxMeterChannels] = {};
+    uint64_t    m_clips[kMaxMeterChannels] = {};
+
+    // Published window; m_seq is odd while it is being written
+    alignas(64) std::atomic<uint32_t> m_seq{0};
+    std::atomic<uint32_t> m_pubChannels{0};
+    std::atomic<float>    m_pubPeak[kMaxMeterChannels] = {};
+    std::atomic<float>    m_pubRms[kMaxMeterChannels] = {};
+    std::atomic<uint64_t> m_pubClips[kMaxMeterChannels] = {};
+};
@@ -0,0 +1,192 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+
+HRESULT MappedFile::openRead(const std::string& path) {
+    close();
+    m_file = CreateFileW(utf8ToWide(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) return HRESULT_FROM_WIN32(GetLastError());
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(m_file, &size)) {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        close();
+        return hr;
+    }
+    m_size = static_cast<uint64_t>(size.QuadPart);
+    m_writable = false;
+
+    HRESULT hr = map();
+    if (FAILED(hr)) close();
+    return hr;
+}
+
+HRESULT MappedFile::create(const std::string& path, uint64_t bytes) {
+    close();
+    m_file = CreateFileW(utf8ToWide(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                         nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) return HRESULT_FROM_WIN32(GetLastError());
+
+    m_writable = true;
+    HRESULT hr = resize(bytes);
+    if (FAILED(hr)) close();
+    return hr;
+}
+
+HRESULT MappedFile::resize(uint64_t bytes) {
+    if (!m_writable || m_file == INVALID_HANDLE_VALUE) return E_NOT_VALID_STATE;
+
+    // The length of a file cannot change while a view of it exists
+    unmap();
+    LARGE_INTEGER pos = {};
+    pos.QuadPart = static_cast<LONGLONG>(bytes);
+    if (!SetFilePointerEx(m_file, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file))
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    m_size = bytes;
+    return map();
+}
+
+HRESULT MappedFile::map() {
+    if (m_size == 0) return S_OK;   // nothing to map; data() stays null
+
+    m_mapping = CreateFileMappingW(m_file, nullptr, m_writable ? PAGE_READWRITE : PAGE_READONLY,
+                                   0, 0, nullptr);
+    if (!m_mapping) return HRESULT_FROM_WIN32(GetLastError());
+
+    void* view = MapViewOfFile(m_mapping, m_writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return hr;
+    }
+    m_data = static_cast<uint8_t*>(view);
+    return S_OK;
+}
+
+void MappedFile::unmap() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+void MappedFile::close() {
+    unmap();
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    m_size = 0;
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t bytes) const {
+    if (!m_data || offset >= m_size) return;
+    if (bytes > m_size - offset) bytes = m_size - offset;
+
+    WIN32_MEMORY_RANGE_ENTRY range = { m_data + offset, static_cast<SIZE_T>(bytes) };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+
+static HRESULT errnoResult() {
+    switch (errno) {
+        case ENOENT: case EACCES: case EPERM: return E_ACCESSDENIED;
+        case ENOMEM: case ENOSPC:             return E_OUTOFMEMORY;
+        default:                              return E_FAIL;
+    }
+}
+
+HRESULT MappedFile::openRead(const std::string& path) {
+    close();
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) return errnoResult();
+
+    struct stat st = {};
+    if (fstat(m_fd, &st) != 0) {
+        HRESULT hr = errnoResult();
+        close();
+        return hr;
+    }
+    m_size = static_cast<uint64_t>(st.st_size);
+    m_writable = false;
+
+    HRESULT hr = map();
+    if (FAILED(hr)) {
+        close();
+        return hr;
+    }
+    if (m_data) madvise(m_data, m_size, MADV_SEQUENTIAL);
+    return S_OK;
+}
+
+HRESULT MappedFile::create(const std::string& path, uint64_t bytes) {
+    close();
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) return errnoResult();
+
+    m_writable = true;
+    HRESULT hr = resize(bytes);
+    if (FAILED(hr)) close();
+    return hr;
+}
+
+HRESULT MappedFile::resize(uint64_t bytes) {
+    if (!m_writable || m_fd < 0) return E_NOT_VALID_STATE;
+
+    unmap();
+    if (ftruncate(m_fd, static_cast<off_t>(bytes)) != 0) return errnoResult();
+    m_size = bytes;
+    return map();
+}
+
+HRESULT MappedFile::map() {
+    if (m_size == 0) return S_OK;   // nothing to map; data() stays null
+
+    void* p = mmap(nullptr, static_cast<size_t>(m_size), m_writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                   MAP_SHARED, m_fd, 0);
+    if (p == MAP_FAILED) return errnoResult();
+    m_data = static_cast<uint8_t*>(p);
+    return S_OK;
+}
+
+void MappedFile::unmap() {
+    if (m_data) {
+        munmap(m_data, static_cast<size_t>(m_size));
+        m_data = nullptr;
+    }
+}
+
+void MappedFile::close() {
+    unmap();
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t bytes) const {
+    if (!m_data || offset >= m_size) return;
+    if (bytes > m_size - offset) bytes = m_size - offset;
+
+    // madvise wants a page-aligned start
+    const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const uint64_t start = offset & ~(page - 1);
+    madvise(m_data + start, static_cast<size_t>(bytes + (offset - start)), MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "Platform.h"
+
+// A whole file mapped into memory, read-only or writable.
+//
+// Backends read and write sample data straight through the mapping, so
+// there is no read()/write() copy and file size is bounded only by the
+// address space.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    HRESULT openRead(const std::string& path);
+    // Creates (or truncates) the file at 'bytes' and maps it writable
+    HRESULT create(const std::string& path, uint64_t bytes);
+    // Writable files only: changes the length and maps it again, so
+    // pointers into the old view become invalid. New space reads as zeros.
+    HRESULT resize(uint64_t bytes);
+    void    close();
+
+    uint8_t* data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+
+    // Starts reading [offset, offset + bytes) into memory in the background
+    void prefetch(uint64_t offset, uint64_t bytes) const;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+    HRESULT map();
+    void    unmap();
+
+    uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+    bool     m_writable = false;
+#ifdef _WIN32
+    HANDLE   m_file = INVALID_HANDLE_VALUE;
+    HANDLE   m_mapping = nullptr;
+#else
+    int      m_fd = -1;
+#endif
+};
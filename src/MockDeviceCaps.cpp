@@ -0,0 +1,50 @@
+#include "MockDeviceCaps.h"
+#include <algorithm>
+
+#ifndef AUDCLNT_E_ALREADY_INITIALIZED
+#define AUDCLNT_E_ALREADY_INITIALIZED ((HRESULT)0x88890002L)
+#endif
+
+bool MockDeviceCaps::isSupported(const AudioFormat& format) {
+    ++m_calls;
+    m_simulatedMs += costs.supportedMs;
+    return std::find(supported.begin(), supported.end(), format) != supported.end();
+}
+
+HRESULT MockDeviceCaps::devicePeriod(HnsTime& defaultPeriodOut, HnsTime& minPeriodOut) {
+    ++m_calls;
+    m_simulatedMs += costs.periodMs;
+    defaultPeriodOut = defaultPeriod;
+    minPeriodOut = minPeriod;
+    return S_OK;
+}
+
+HRESULT MockDeviceCaps::open(const AudioFormat& format, HnsTime period, UINT32& alignedFrames) {
+    ++m_calls;
+    m_simulatedMs += costs.openMs;
+    if (m_used) return AUDCLNT_E_ALREADY_INITIALIZED;
+    if (!format.isValid() || std::find(supported.begin(), supported.end(), format) == supported.end())
+        return AUDCLNT_E_UNSUPPORTED_FORMAT;
+    if (period < minPeriod) return E_INVALIDARG;
+
+    const UINT32 frames = static_cast<UINT32>(static_cast<double>(period) * format.sampleRate / 10000000.0 + 0.5);
+    if (alignFrames > 0 && frames % alignFrames != 0) {
+        alignedFrames = (frames / alignFrames + 1) * alignFrames;
+        m_used = true;
+        return AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED;
+    }
+
+    m_used = true;
+    m_open = true;
+    m_openFormat = format;
+    m_openPeriod = period;
+    return S_OK;
+}
+
+HRESULT MockDeviceCaps::reactivate() {
+    ++m_calls;
+    m_simulatedMs += costs.activateMs;
+    m_used = false;
+    m_open = false;
+    return S_OK;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "FormatNegotiator.h"
+
+// DeviceCaps answered from a table, for running the negotiation and the
+// format cache without hardware. Behaves like an exclusive-mode WASAPI
+// client where it matters: a client that has been initialized (or refused
+// with AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) has to be activated again, and
+// periods must be a whole number of alignFrames. Every call is counted and
+// charged at the given costs, so the time a slow driver would take can be
+// compared without waiting for it.
+class MockDeviceCaps : public DeviceCaps {
+public:
+    struct Costs {
+        double supportedMs = 2.0;
+        double periodMs    = 0.2;
+        double openMs      = 25.0;
+        double activateMs  = 10.0;
+    };
+
+    std::vector<AudioFormat> supported;
+    HnsTime defaultPeriod = 100000;     // 10 ms
+    HnsTime minPeriod     = 30000;      // 3 ms
+    UINT32  alignFrames   = 0;          // 0 = any period
+    Costs   costs;
+
+    bool    isSupported(const AudioFormat& format) override;
+    HRESULT devicePeriod(HnsTime& defaultPeriodOut, HnsTime& minPeriodOut) override;
+    HRESULT open(const AudioFormat& format, HnsTime period, UINT32& alignedFrames) override;
+    HRESULT reactivate() override;
+
+    bool        isOpen()      const { return m_open; }
+    AudioFormat openFormat()  const { return m_openFormat; }
+    HnsTime     openPeriod()  const { return m_openPeriod; }
+    UINT32      calls()       const { return m_calls; }
+    double      simulatedMs() const { return m_simulatedMs; }
+    void        resetCounters() { m_calls = 0; m_simulatedMs = 0.0; }
+
+private:
+    bool        m_used = false;     // needs reactivate() before the next open()
+    bool        m_open = false;
+    AudioFormat m_openFormat;
+    HnsTime     m_openPeriod = 0;
+    UINT32      m_calls = 0;
+    double      m_simulatedMs = 0.0;
+};
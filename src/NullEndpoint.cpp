@@ -0,0 +1,49 @@
+#include "NullEndpoint.h"
+#include <cmath>
+
+static const double kTwoPi = 6.283185307179586;
+
+HRESULT NullCapture::init(const AudioFormat& format, float toneHz, RingBuffer* ringBuffer) {
+    if (!format.isValid()) return E_INVALIDARG;
+
+    m_format = format;
+    m_ringBuffer = ringBuffer;
+    m_phase = 0.0;
+    m_phaseStep = (toneHz > 0.0f) ? kTwoPi * toneHz / format.sampleRate : 0.0;
+
+    initPeriod();
+    initPipeline();
+    return S_OK;
+}
+
+const uint8_t* NullCapture::produce(uint32_t frames) {
+    if (m_phaseStep == 0.0) return nullptr;
+
+    // -20 dBFS sine on all channels
+    const uint32_t step = bytesPerSample(m_format.type);
+    const uint32_t blockAlign = m_format.blockAlign();
+    uint8_t* data = periodBuffer();
+    for (uint32_t f = 0; f < frames; ++f) {
+        float v = static_cast<float>(0.1 * std::sin(m_phase));
+        m_phase += m_phaseStep;
+        if (m_phase >= kTwoPi) m_phase -= kTwoPi;
+        for (uint32_t c = 0; c < m_format.channels; ++c)
+            storeSample(m_format.type, data + static_cast<size_t>(f) * blockAlign + c * step, v);
+    }
+    return data;
+}
+
+HRESULT NullRender::init(const AudioFormat& format, RingBuffer* ringBuffer,
+                         const AudioFormat* preferredFormat) {
+    if (format.isValid())
+        m_format = format;
+    else if (preferredFormat && preferredFormat->isValid())
+        m_format = *preferredFormat;
+    else
+        return E_INVALIDARG;
+
+    m_ringBuffer = ringBuffer;
+    initPeriod();
+    initPipeline();
+    return S_OK;
+}
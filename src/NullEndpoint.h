@@ -0,0 +1,32 @@
+#pragma once
+
+#include "PacedEndpoint.h"
+
+// Capture without a device: produces silence or a test tone in real time.
+class NullCapture : public PacedCapture {
+public:
+    ~NullCapture() override { stop(); }
+
+    HRESULT init(const AudioFormat& format, float toneHz, RingBuffer* ringBuffer);
+
+protected:
+    const uint8_t* produce(uint32_t frames) override;
+
+private:
+    double m_phase = 0.0;
+    double m_phaseStep = 0.0;
+};
+
+// Render without a device: drains the ring buffer in real time and discards it.
+class NullRender : public PacedRender {
+public:
+    ~NullRender() override { stop(); }
+
+    // With no explicit format the render side follows the preferred (capture)
+    // format, so a null sink never forces a resampler into the route.
+    HRESULT init(const AudioFormat& format, RingBuffer* ringBuffer,
+                 const AudioFormat* preferredFormat = nullptr);
+
+protected:
+    void consume(const uint8_t*, uint32_t, bool) override {}
+};
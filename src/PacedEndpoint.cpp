@@ -0,0 +1,145 @@
+#include "PacedEndpoint.h"
+#include "StartupTrace.h"
+#include "RealtimeCheck.h"
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+// Falling further behind than this (e.g. after a suspend) restarts the pacing
+// instead of bursting to catch up.
+static constexpr auto kMaxLag = std::chrono::milliseconds(200);
+// Unpaced endpoints poll the ring this often while it is full or empty
+static constexpr auto kUnpacedPoll = std::chrono::milliseconds(1);
+
+// ── Capture ───────────────────────────────────────────────────────
+
+void PacedCapture::initPeriod() {
+    m_bufferFrames = (std::max)(m_format.sampleRate * kPeriodMs / 1000, 1u);
+    m_period = ArenaVector<uint8_t>(static_cast<size_t>(m_bufferFrames) * m_format.blockAlign(), 0,
+                                    ArenaAllocator<uint8_t>(m_arena));
+}
+
+HRESULT PacedCapture::start() {
+    if (m_running.load()) return S_FALSE;
+    if (m_period.empty() || !m_ringBuffer) return E_NOT_VALID_STATE;
+
+    m_threadReport.clear();
+    resetClock();
+    m_finished.store(false, std::memory_order_relaxed);
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&PacedCapture::loop, this);
+    return S_OK;
+}
+
+void PacedCapture::stop() {
+    if (!m_running.load()) return;
+
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void PacedCapture::loop() {
+    RealtimeThreadScope rt(m_rtPolicy, ThreadRole::Device);
+    m_threadReport.publish(rt.report());
+
+    const auto period = std::chrono::milliseconds(kPeriodMs);
+    const size_t periodBytes = static_cast<size_t>(m_bufferFrames) * m_format.blockAlign();
+    auto next = Clock::now();
+    UINT64 position = 0;
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        if (!m_paced) {
+            // Backpressure: never drop, wait for the consumer instead
+            if (!m_ringBuffer->canWrite(periodBytes)) {
+                std::this_thread::sleep_for(kUnpacedPoll);
+                continue;
+            }
+        }
+
+        {
+            RealtimeSection section("capture");
+            const uint8_t* packet = produce(m_bufferFrames);
+            if (isFinished()) break;
+            if (packet)
+                deliver(packet, m_bufferFrames);
+            else
+                deliverSilence(m_bufferFrames);
+        }
+        if (!m_paced) continue;
+
+        // The steady clock is this endpoint's device clock
+        position += m_bufferFrames;
+        observeClock(position, startupClockNs());
+
+        next += period;
+        auto now = Clock::now();
+        if (now - next > kMaxLag) next = now;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+// ── Render ────────────────────────────────────────────────────────
+
+void PacedRender::initPeriod() {
+    m_bufferFrames = (std::max)(m_format.sampleRate * kPeriodMs / 1000, 1u);
+    m_period = ArenaVector<uint8_t>(static_cast<size_t>(m_bufferFrames) * m_format.blockAlign(), 0,
+                                    ArenaAllocator<uint8_t>(m_arena));
+}
+
+HRESULT PacedRender::start() {
+    if (m_running.load()) return S_FALSE;
+    if (m_period.empty() || !m_ringBuffer) return E_NOT_VALID_STATE;
+
+    resetPipeline();
+    resetClock();
+    m_threadReport.clear();
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&PacedRender::loop, this);
+    return S_OK;
+}
+
+void PacedRender::stop() {
+    if (!m_running.load()) return;
+
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void PacedRender::loop() {
+    RealtimeThreadScope rt(m_rtPolicy, ThreadRole::Device);
+    m_threadReport.publish(rt.report());
+
+    const auto period = std::chrono::milliseconds(kPeriodMs);
+    const size_t periodBytes = static_cast<size_t>(m_bufferFrames) * m_format.blockAlign();
+    auto next = Clock::now();
+    UINT64 position = 0;
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        if (!m_paced) {
+            // Only whole periods, so an empty ring is waited out rather than
+            // concealed. Once the stream has ended there is nothing to wait for.
+            if (isDrained() ||
+                (m_ringBuffer->availableToRead() < periodBytes && !m_ringBuffer->ended())) {
+                std::this_thread::sleep_for(isDrained() ? period : kUnpacedPoll);
+                continue;
+            }
+        }
+
+        {
+            RealtimeSection section("render");
+            uint8_t* target = periodTarget(m_bufferFrames);
+            bool silent = pull(target, m_bufferFrames);
+            if (!isDrained()) consume(target, m_bufferFrames, silent);
+        }
+        if (!m_paced) continue;
+
+        // The steady clock is this endpoint's device clock
+        position += m_bufferFrames;
+        observeClock(position, startupClockNs());
+
+        next += period;
+        auto now = Clock::now();
+        if (now - next > kMaxLag) next = now;
+        std::this_thread::sleep_until(next);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "AudioEndpoint.h"
+
+// Base for endpoints without a hardware clock (null and file backends).
+//
+// A worker thread runs one period every kPeriodMs against the steady clock,
+// so these endpoints consume and produce audio at the same rate a sound card
+// would. Unpaced, they run as fast as the other side of the ring allows
+// instead: capture waits only for room in the ring, render only for a full
+// period of data. Derived classes only fill or drain the period buffer.
+class PacedCapture : public CaptureEndpoint {
+public:
+    ~PacedCapture() override { stop(); }
+
+    HRESULT start() override;
+    void    stop() override;
+
+    void setPaced(bool paced) { m_paced = paced; }
+    // Unpaced, the other side of the ring sets the pace
+    double periodMs() const override { return m_paced ? CaptureEndpoint::periodMs() : 0.0; }
+
+protected:
+    static constexpr UINT32 kPeriodMs = 10;
+
+    // Called by the derived class at the end of its init
+    void initPeriod();
+
+    // Return 'frames' frames of audio: the period buffer after filling it,
+    // or memory of the backend's own. nullptr sends a silent packet; calling
+    // endOfStream() instead ends the capture.
+    virtual const uint8_t* produce(uint32_t frames) = 0;
+
+    uint8_t* periodBuffer() { return m_period.data(); }
+
+private:
+    void loop();
+
+    std::thread          m_thread;
+    ArenaVector<uint8_t> m_period;
+    bool                 m_paced = true;
+};
+
+class PacedRender : public RenderEndpoint {
+public:
+    ~PacedRender() override { stop(); }
+
+    HRESULT start() override;
+    void    stop() override;
+
+    void setPaced(bool paced) { m_paced = paced; }
+    // Unpaced, the other side of the ring sets the pace
+    double periodMs() const override { return m_paced ? RenderEndpoint::periodMs() : 0.0; }
+
+protected:
+    static constexpr UINT32 kPeriodMs = 10;
+
+    void initPeriod();
+
+    // Where the next period is rendered to. By default the period buffer;
+    // a backend may return its own memory so that pull() writes in place.
+    virtual uint8_t* periodTarget(uint32_t) { return m_period.data(); }
+
+    // Consume one period. 'silent' periods may contain stale bytes.
+    virtual void consume(const uint8_t* data, uint32_t frames, bool silent) = 0;
+
+private:
+    void loop();
+
+    std::thread          m_thread;
+    ArenaVector<uint8_t> m_period;
+    bool                 m_paced = true;
+};
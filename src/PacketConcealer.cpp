@@ -0,0 +1,169 @@
+#include "PacketConcealer.h"
+#include <algorithm>
+#include <cmath>
+
+void PacketConcealer::init(const AudioFormat& format, AudioArena* arena) {
+    m_format = format;
+    m_blockAlign = format.blockAlign();
+
+    const uint32_t rate = format.sampleRate > 0 ? format.sampleRate : 48000;
+
+    // Pitch search between 2.5 ms and 20 ms covers voice and most tonal content
+    m_minLag      = (std::max)(rate / 400, 16u);
+    m_maxLag      = (std::max)(rate / 50, m_minLag + 1);
+    m_matchLen    = (std::max)(rate / 400, 16u);
+    m_fadeFrames  = rate * 60 / 1000;   // fade to silence over 60 ms
+    m_xfadeFrames = (std::max)(rate * 3 / 1000, 8u);
+
+    m_historyCap = m_maxLag + m_matchLen;
+    m_history = ArenaVector<uint8_t>(static_cast<size_t>(m_historyCap) * m_blockAlign, 0,
+                                     ArenaAllocator<uint8_t>(arena));
+    m_loop = ArenaVector<float>(static_cast<size_t>(m_historyCap) * format.channels, 0.0f,
+                                ArenaAllocator<float>(arena));
+    m_mono = ArenaVector<float>(m_historyCap, 0.0f, ArenaAllocator<float>(arena));
+
+    reset();
+}
+
+void PacketConcealer::reset() {
+    m_historyFrames = 0;
+    m_loopLen = 0;
+    m_loopPos = 0;
+    m_concealing = false;
+    m_gapFrames = 0;
+    m_concealedFrames = 0;
+}
+
+void PacketConcealer::pushHistory(const uint8_t* data, uint32_t frames) {
+    if (frames == 0 || m_historyCap == 0) return;
+
+    if (frames >= m_historyCap) {
+        std::memcpy(m_history.data(),
+                    data + static_cast<size_t>(frames - m_historyCap) * m_blockAlign,
+                    static_cast<size_t>(m_historyCap) * m_blockAlign);
+        m_historyFrames = m_historyCap;
+        return;
+    }
+
+    if (m_historyFrames + frames > m_historyCap) {
+        uint32_t drop = m_historyFrames + frames - m_historyCap;
+        std::memmove(m_history.data(),
+                     m_history.data() + static_cast<size_t>(drop) * m_blockAlign,
+                     static_cast<size_t>(m_historyFrames - drop) * m_blockAlign);
+        m_historyFrames -= drop;
+    }
+
+    std::memcpy(m_history.data() + static_cast<size_t>(m_historyFrames) * m_blockAlign,
+                data, static_cast<size_t>(frames) * m_blockAlign);
+    m_historyFrames += frames;
+}
+
+void PacketConcealer::beginConcealment() {
+    m_loopLen = 0;
+    m_loopPos = 0;
+
+    const uint32_t H = m_historyFrames;
+    if (H < m_minLag + m_matchLen) return; // not enough context: plain fade-in later
+
+    const uint32_t ch = m_format.channels;
+    samplesToFloat(m_format.type, m_history.data(), m_loop.data(),
+                   static_cast<size_t>(H) * ch);
+
+    const float invCh = 1.0f / ch;
+    for (uint32_t f = 0; f < H; ++f) {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < ch; ++c) sum += m_loop[static_cast<size_t>(f) * ch + c];
+        m_mono[f] = sum * invCh;
+    }
+
+    // Find the lag whose preceding segment best matches the most recent audio.
+    // Repeating that many frames makes both splice points line up.
+    const float* ref = m_mono.data() + (H - m_matchLen);
+    const uint32_t maxLag = (std::min)(m_maxLag, H - m_matchLen);
+    uint32_t bestLag = maxLag;
+    float bestScore = -1.0f;
+    for (uint32_t lag = m_minLag; lag <= maxLag; ++lag) {
+        const float* cand = ref - lag;
+        float corr = 0.0f, energy = 0.0f;
+        for (uint32_t i = 0; i < m_matchLen; ++i) {
+            corr   += ref[i] * cand[i];
+            energy += cand[i] * cand[i];
+        }
+        if (energy <= 1e-12f) continue;
+        float score = corr / std::sqrt(energy);
+        if (score > bestScore) {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    m_loopStart = H - bestLag;
+    m_loopLen = bestLag;
+}
+
+float PacketConcealer::nextConcealSample(uint32_t ch) const {
+    if (m_loopLen == 0 || m_gapFrames >= m_fadeFrames) return 0.0f;
+    float gain = 1.0f - static_cast<float>(m_gapFrames) / m_fadeFrames;
+    size_t idx = static_cast<size_t>(m_loopStart + m_loopPos) * m_format.channels + ch;
+    return m_loop[idx] * gain;
+}
+
+void PacketConcealer::advanceConceal() {
+    if (m_loopLen > 0) m_loopPos = (m_loopPos + 1) % m_loopLen;
+    if (m_gapFrames < m_fadeFrames) ++m_gapFrames;
+}
+
+bool PacketConcealer::process(uint8_t* data, uint32_t framesValid, uint32_t framesTotal) {
+    if (m_blockAlign == 0) return false;
+
+    const uint32_t ch = m_format.channels;
+    const uint32_t step = bytesPerSample(m_format.type);
+
+    // Real audio is back after a gap: crossfade from the concealment signal
+    if (m_concealing && framesValid > 0) {
+        uint32_t n = (std::min)(m_xfadeFrames, framesValid);
+        for (uint32_t f = 0; f < n; ++f) {
+            float w = static_cast<float>(f + 1) / (n + 1);
+            uint8_t* frame = data + static_cast<size_t>(f) * m_blockAlign;
+            for (uint32_t c = 0; c < ch; ++c) {
+                uint8_t* p = frame + c * step;
+                float v = loadSample(m_format.type, p) * w + nextConcealSample(c) * (1.0f - w);
+                storeSample(m_format.type, p, v);
+            }
+            advanceConceal();
+        }
+        m_concealing = false;
+        m_gapFrames = 0;
+    }
+
+    pushHistory(data, framesValid);
+
+    if (framesValid >= framesTotal) return false;
+
+    if (!m_concealing) {
+        beginConcealment();
+        m_concealing = true;
+        m_gapFrames = 0;
+    }
+
+    bool silent = (framesValid == 0);
+    uint32_t f = framesValid;
+    for (; f < framesTotal; ++f) {
+        if (m_loopLen == 0 || m_gapFrames >= m_fadeFrames) break;
+
+        uint8_t* frame = data + static_cast<size_t>(f) * m_blockAlign;
+        for (uint32_t c = 0; c < ch; ++c) {
+            float v = nextConcealSample(c);
+            if (v != 0.0f) silent = false;
+            storeSample(m_format.type, frame + c * step, v);
+        }
+        advanceConceal();
+        ++m_concealedFrames;
+    }
+
+    if (f < framesTotal) {
+        std::memset(data + static_cast<size_t>(f) * m_blockAlign, 0,
+                    static_cast<size_t>(framesTotal - f) * m_blockAlign);
+    }
+    return silent;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "SampleFormat.h"
+#include "AudioArena.h"
+
+// Render-side packet-loss concealment.
+//
+// Keeps the most recent output in its native format. When the ring buffer
+// comes up short, the gap is filled by repeating the last pitch period
+// (found by a short correlation search) with a linear fade, so a single late
+// packet is heard as a slight dip instead of a click. Long gaps fade out to
+// silence. When real audio resumes, it is crossfaded in from the concealment
+// signal.
+//
+// All buffers are sized in init() (from the arena when given); process()
+// does not allocate.
+class PacketConcealer {
+public:
+    void init(const AudioFormat& format, AudioArena* arena = nullptr);
+    void reset();
+
+    // 'data' holds framesTotal frames of which the first framesValid came from
+    // the ring buffer. Fills the remainder and smooths gap boundaries.
+    // Returns true if the whole buffer ended up silent.
+    bool process(uint8_t* data, uint32_t framesValid, uint32_t framesTotal);
+
+    // A silent period was passed straight to the device. Concealment after
+    // it should not replay audio from before the silence.
+    void pushSilence() { m_historyFrames = 0; }
+
+    bool isConcealing() const { return m_concealing; }
+
+    uint64_t concealedFrames() const { return m_concealedFrames; }
+
+private:
+    void pushHistory(const uint8_t* data, uint32_t frames);
+    void beginConcealment();
+    float nextConcealSample(uint32_t ch) const;
+    void  advanceConceal();
+
+    AudioFormat          m_format;
+    uint32_t             m_blockAlign = 0;
+
+    // Raw history of the last m_historyCap frames (oldest first)
+    ArenaVector<uint8_t> m_history;
+    uint32_t             m_historyCap = 0;
+    uint32_t             m_historyFrames = 0;
+
+    // Float copy of the history used while concealing
+    ArenaVector<float>   m_loop;
+    ArenaVector<float>   m_mono;
+    uint32_t             m_loopStart = 0;   // first frame of the repeated period
+    uint32_t             m_loopLen = 0;     // pitch period in frames
+    uint32_t             m_loopPos = 0;
+
+    uint32_t             m_minLag = 0;
+    uint32_t             m_maxLag = 0;
+    uint32_t             m_matchLen = 0;
+    uint32_t             m_fadeFrames = 0;  // gap length after which output is silent
+    uint32_t             m_xfadeFrames = 0; // crossfade back into real audio
+
+    bool                 m_concealing = false;
+    uint32_t             m_gapFrames = 0;   // frames concealed in the current gap
+    uint64_t             m_concealedFrames = 0;
+};
@@ -0,0 +1,23 @@
+#include "ParamQueue.h"
+
+ParamQueue::~ParamQueue() {
+    clear();
+}
+
+void ParamQueue::clear() {
+    // The audio thread is gone: whatever it did not take is ours to free
+    ParamCommand command;
+    while (m_commands.pop(command)) delete command.params;
+    collect();
+}
+
+bool ParamQueue::send(const ParamCommand& command) {
+    collect();
+    return m_commands.push(command);
+}
+
+void ParamQueue::collect() {
+    std::lock_guard<std::mutex> lock(m_collectMutex);
+    DspParamSet* params = nullptr;
+    while (m_retired.pop(params)) delete params;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Bounded multi-producer, single-consumer queue.
+//
+// Every cell carries a sequence number that tells producers and the consumer
+// whose turn it is, so producers only contend on one CAS of the tail and the
+// consumer never waits: pop() is a load and, if something is there, a copy
+// and a store. N must be a power of two.
+template <class T, size_t N>
+class MpscQueue {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < N; ++i) m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread; false if the queue is full
+    bool push(const T& value) {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[pos & (N - 1)];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only; false if nothing is queued
+    bool pop(T& value) {
+        Cell& cell = m_cells[m_head & (N - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != m_head + 1) return false;
+        value = cell.value;
+        cell.sequence.store(m_head + N, std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T                   value;
+    };
+
+    Cell                            m_cells[N];
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) size_t              m_head = 0;
+};
+
+// Live parameters of a running route.
+enum class ParamId : uint32_t {
+    OutputGain,     // value: linear gain
+    Mute,           // value: 0 or 1
+    MatrixGain,     // index: output channel, index2: input channel, value: linear gain
+    Insert          // index: insert (config order), params: new stage parameters
+};
+
+// Parameters of one insert, prepared on a control thread (coefficients are
+// designed there, not on the audio thread).
+struct DspParamSet {
+    uint32_t type = 0;              // DspStageType of the insert it is meant for
+    float    values[5] = {};        // Eq: b0 b1 b2 a1 a2; DcBlock: pole; Gain: linear;
+                                    // Gate: threshold, attack, release, hold frames
+};
+
+struct ParamCommand {
+    ParamId      id = ParamId::OutputGain;
+    uint32_t     index = 0;
+    uint32_t     index2 = 0;
+    float        value = 0.0f;
+    DspParamSet* params = nullptr;
+};
+
+// Control → audio thread parameter channel of one route.
+//
+// Control threads (UI, CLI, IPC) send commands; the render thread polls
+// once per period and applies them at the next block boundary. Parameter
+// sets are allocated by the sender and handed back by the audio thread
+// through a second queue, so they are freed on a control thread, never on
+// the audio thread.
+class ParamQueue {
+public:
+    static constexpr size_t kCapacity = 256;
+
+    ~ParamQueue();
+
+    // Control threads. Frees parameter sets the audio thread is done with,
+    // then queues the command. False if the queue is full, in which case the
+    // command's parameter set still belongs to the caller.
+    bool send(const ParamCommand& command);
+    // Control threads: free retired parameter sets now
+    void collect();
+    // Drops everything queued; only while no audio thread polls
+    void clear();
+
+    // Audio thread
+    bool poll(ParamCommand& command) { return m_commands.pop(command); }
+    // Hands a set back for freeing. Cannot fail: send() collects before
+    // queueing, so no more than kCapacity sets are ever waiting here.
+    void retire(DspParamSet* params) {
+        if (params) m_retired.push(params);
+    }
+
+private:
+    MpscQueue<ParamCommand, kCapacity>     m_commands;
+    MpscQueue<DspParamSet*, kCapacity * 2> m_retired;
+    std::mutex                             m_collectMutex;   // m_retired has a single consumer
+};
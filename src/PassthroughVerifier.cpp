@@ -0,0 +1,150 @@
+#include "PassthroughVerifier.h"
+#include "StartupTrace.h"
+#include <algorithm>
+
+// Adler-32 (RFC 1950): the modulo is taken once per kAdlerRun bytes, the
+// most that cannot overflow the 32-bit sums
+static constexpr UINT32 kAdlerBase = 65521;
+static constexpr size_t kAdlerRun = 5552;
+
+static UINT32 adlerUpdate(UINT32 sum, const uint8_t* data, size_t bytes) {
+    UINT32 a = sum & 0xFFFF;
+    UINT32 b = sum >> 16;
+    while (bytes > 0) {
+        size_t run = (std::min)(bytes, kAdlerRun);
+        bytes -= run;
+        // 16 bytes at a time without the byte-to-byte chain through 'a':
+        // b gains 16 a plus each byte weighted by how often it is added
+        for (; run >= 16; run -= 16, data += 16) {
+            UINT32 plain = 0, weighted = 0;
+            for (UINT32 i = 0; i < 16; ++i) {
+                plain += data[i];
+                weighted += (16 - i) * data[i];
+            }
+            b += 16 * a + weighted;
+            a += plain;
+        }
+        for (; run > 0; --run) {
+            a += *data++;
+            b += a;
+        }
+        a %= kAdlerBase;
+        b %= kAdlerBase;
+    }
+    return (b << 16) | a;
+}
+
+// The same for 'bytes' zeros, without touching them: a stays, b gains bytes * a
+static UINT32 adlerZeros(UINT32 sum, size_t bytes) {
+    const UINT32 a = sum & 0xFFFF;
+    const UINT64 b = (sum >> 16) + static_cast<UINT64>(bytes % kAdlerBase) * a;
+    return (static_cast<UINT32>(b % kAdlerBase) << 16) | a;
+}
+
+void PassthroughVerifier::init(AudioArena* arena, INT64 originNs) {
+    m_blocks = ArenaVector<Block>(kMaxBlocks, Block{}, ArenaAllocator<Block>(arena));
+    m_originNs = originNs;
+}
+
+bool PassthroughVerifier::push(const Block& block) {
+    const UINT64 head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= kMaxBlocks) return false;
+    m_blocks[head % kMaxBlocks] = block;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool PassthroughVerifier::pop(Block& block) {
+    const UINT64 tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) return false;
+    block = m_blocks[tail % kMaxBlocks];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void PassthroughVerifier::write(RingBuffer& ring, const uint8_t* data, size_t bytes) {
+    if (bytes == 0) return;
+    // A dropped block still uses up its number: render sees the gap
+    const UINT64 sequence = m_sequence++;
+    if (!ring.canWrite(bytes)) return;
+    // Queued before the audio, so render never reads bytes it has no block for
+    if (!push({sequence, bytes, adlerUpdate(1, data, bytes)})) return;
+    ring.write(data, bytes);
+}
+
+void PassthroughVerifier::writeSilence(RingBuffer& ring, size_t bytes) {
+    if (bytes == 0) return;
+    const UINT64 sequence = m_sequence++;
+    if (!ring.canWrite(bytes)) return;
+    if (!push({sequence, bytes, adlerZeros(1, bytes)})) return;
+    ring.writeSilence(bytes);
+}
+
+void PassthroughVerifier::consume(Read read, const uint8_t* data, size_t bytes) {
+    while (bytes > 0) {
+        if (m_remaining == 0) {
+            if (!pop(m_current)) {
+                // Audio capture never wrote
+                event(m_duplicated, m_lastDuplicateNs, 1);
+                return;
+            }
+            if (m_current.sequence > m_expected)
+                event(m_dropped, m_lastDropNs, m_current.sequence - m_expected);
+            m_expected = m_current.sequence + 1;
+            m_remaining = m_current.bytes;
+            m_checksum = 1;
+            m_discarded = false;
+        }
+
+        const size_t n = (std::min)(bytes, m_remaining);
+        if (read == Read::Data) {
+            m_checksum = adlerUpdate(m_checksum, data, n);
+            data += n;
+        } else if (read == Read::Silence) {
+            m_checksum = adlerZeros(m_checksum, n);
+        } else {
+            m_discarded = true;
+        }
+        bytes -= n;
+        m_remaining -= n;
+        if (m_remaining == 0) finishBlock();
+    }
+}
+
+void PassthroughVerifier::finishBlock() {
+    if (m_discarded) {
+        event(m_dropped, m_lastDropNs, 1);
+    } else if (m_checksum == m_current.checksum) {
+        m_intact.fetch_add(1, std::memory_order_relaxed);
+        m_intactBytes.fetch_add(m_current.bytes, std::memory_order_relaxed);
+    } else if (m_current.bytes == m_previous.bytes && m_checksum == m_previous.checksum) {
+        // The previous block once more in its place
+        event(m_duplicated, m_lastDuplicateNs, 1);
+    } else {
+        event(m_corrupted, m_lastCorruptNs, 1);
+    }
+    m_previous = m_current;
+}
+
+void PassthroughVerifier::event(std::atomic<UINT64>& counter, std::atomic<INT64>& lastNs, UINT64 count) {
+    counter.fetch_add(count, std::memory_order_relaxed);
+    lastNs.store(startupClockNs(), std::memory_order_relaxed);
+}
+
+VerifyStats PassthroughVerifier::stats() const {
+    auto sinceOrigin = [this](const std::atomic<INT64>& ns) {
+        const INT64 at = ns.load(std::memory_order_relaxed);
+        return at != 0 ? static_cast<double>(at - m_originNs) / 1e9 : -1.0;
+    };
+    VerifyStats s;
+    s.active = true;
+    s.blocks = m_intact.load(std::memory_order_relaxed);
+    s.bytes = m_intactBytes.load(std::memory_order_relaxed);
+    s.dropped = m_dropped.load(std::memory_order_relaxed);
+    s.duplicated = m_duplicated.load(std::memory_order_relaxed);
+    s.corrupted = m_corrupted.load(std::memory_order_relaxed);
+    s.lastDropSec = sinceOrigin(m_lastDropNs);
+    s.lastDuplicateSec = sinceOrigin(m_lastDuplicateNs);
+    s.lastCorruptSec = sinceOrigin(m_lastCorruptNs);
+    return s;
+}
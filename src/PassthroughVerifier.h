@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include "Platform.h"
+#include "AudioArena.h"
+#include "RingBuffer.h"
+
+// Counters of the passthrough check on one route
+struct VerifyStats {
+    bool   active = false;          // blocks are being checked
+    UINT64 blocks = 0;              // capture blocks that reached render intact
+    UINT64 bytes = 0;               // ... and their size
+    UINT64 dropped = 0;             // blocks that never reached render
+    UINT64 duplicated = 0;          // blocks render got again, or bytes capture never wrote
+    UINT64 corrupted = 0;           // blocks that reached render altered
+    // Seconds since the route started, -1 = never
+    double lastDropSec = -1.0;
+    double lastDuplicateSec = -1.0;
+    double lastCorruptSec = -1.0;
+};
+
+// Checks that a route without conversion passes audio bit for bit. The
+// capture side gives every block it writes into the ring a sequence number
+// and an Adler-32 checksum, carried next to the audio in a queue of their
+// own so the samples themselves stay untouched. The render side checksums
+// the bytes it reads in stream order and compares block by block: a gap in
+// the sequence is a drop, bytes without a block or a block that repeats the
+// previous one are duplicates, anything else that differs is corruption.
+//
+// Both sides run on the period threads without locks or allocation.
+class PassthroughVerifier {
+public:
+    // Blocks between capture and render; far more than the ring holds
+    static constexpr size_t kMaxBlocks = 4096;
+
+    // Control thread, before either end starts; times are counted from 'originNs'
+    // (startupClockNs() scale)
+    void init(AudioArena* arena, INT64 originNs);
+
+    // Capture thread: writes the block into 'ring' whole, or drops it whole
+    // when the ring or the block queue is full
+    void write(RingBuffer& ring, const uint8_t* data, size_t bytes);
+    void writeSilence(RingBuffer& ring, size_t bytes);
+
+    // Render thread: bytes just taken from the ring, in stream order
+    void check(const uint8_t* data, size_t bytes) { consume(Read::Data, data, bytes); }
+    void checkSilence(size_t bytes) { consume(Read::Silence, nullptr, bytes); }
+    // Render thread: bytes taken from the ring and thrown away; the blocks
+    // they belong to count as dropped
+    void discard(size_t bytes) { consume(Read::Discard, nullptr, bytes); }
+
+    VerifyStats stats() const;
+
+private:
+    struct Block {
+        UINT64 sequence;
+        size_t bytes;
+        UINT32 checksum;
+    };
+
+    enum class Read { Data, Silence, Discard };
+
+    bool push(const Block& block);
+    bool pop(Block& block);
+    void consume(Read read, const uint8_t* data, size_t bytes);
+    void finishBlock();
+    void event(std::atomic<UINT64>& counter, std::atomic<INT64>& lastNs, UINT64 count);
+
+    ArenaVector<Block> m_blocks;
+    INT64              m_originNs = 0;
+
+    // Capture line
+    alignas(64) std::atomic<UINT64> m_head{0};
+    UINT64                          m_sequence = 0;
+
+    // Render line: the block being checked and what it is compared with
+    alignas(64) std::atomic<UINT64> m_tail{0};
+    Block  m_current = {};
+    size_t m_remaining = 0;
+    UINT32 m_checksum = 0;
+    bool   m_discarded = false;     // part of the block was thrown away
+    UINT64 m_expected = 0;
+    Block  m_previous = {};
+
+    // Written by render, read by stats()
+    alignas(64) std::atomic<UINT64> m_intact{0};
+    std::atomic<UINT64> m_intactBytes{0};
+    std::atomic<UINT64> m_dropped{0};
+    std::atomic<UINT64> m_duplicated{0};
+    std::atomic<UINT64> m_corrupted{0};
+    std::atomic<INT64>  m_lastDropNs{0};
+    std::atomic<INT64>  m_lastDuplicateNs{0};
+    std::atomic<INT64>  m_lastCorruptNs{0};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+// Minimal portability layer for the audio core.
+//
+// The core keeps the HRESULT error convention of the Windows code. On other
+// platforms the handful of types and codes it uses are defined here so the
+// portable backends, the router and the headless entry point build unchanged.
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <string>
+
+// UTF-8 <-> UTF-16 for device IDs and paths coming from config files
+inline std::wstring utf8ToWide(const std::string& s) {
+    if (s.empty()) return std::wstring();
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0);
+    std::wstring out(static_cast<size_t>(len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), &out[0], len);
+    return out;
+}
+
+inline std::string wideToUtf8(const std::wstring& s) {
+    if (s.empty()) return std::string();
+    int len = WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
+                                  nullptr, 0, nullptr, nullptr);
+    std::string out(static_cast<size_t>(len), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()),
+                        &out[0], len, nullptr, nullptr);
+    return out;
+}
+
+#else
+
+#include <cstdint>
+#include <string>
+
+typedef int32_t  HRESULT;
+typedef uint8_t  BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef int64_t  INT64;
+
+#define S_OK                ((HRESULT)0)
+#define S_FALSE             ((HRESULT)1)
+#define E_NOTIMPL           ((HRESULT)0x80004001L)
+#define E_ABORT             ((HRESULT)0x80004004L)
+#define E_PENDING           ((HRESULT)0x8000000AL)
+#define E_FAIL              ((HRESULT)0x80004005L)
+#define E_UNEXPECTED        ((HRESULT)0x8000FFFFL)
+#define E_ACCESSDENIED      ((HRESULT)0x80070005L)
+#define E_OUTOFMEMORY       ((HRESULT)0x8007000EL)
+#define E_INVALIDARG        ((HRESULT)0x80070057L)
+#define E_NOT_VALID_STATE   ((HRESULT)0x8007139FL)
+
+#define SUCCEEDED(hr)       (((HRESULT)(hr)) >= 0)
+#define FAILED(hr)          (((HRESULT)(hr)) < 0)
+
+inline std::wstring utf8ToWide(const std::string& s) {
+    // Config values are treated as Latin-1/ASCII outside Windows; the wide
+    // form is only used for display.
+    return std::wstring(s.begin(), s.end());
+}
+
+#endif
+
+#define RETURN_IF_FAILED(hr)                                    \
+    do {                                                        \
+        HRESULT _hr = (hr);                                     \
+        if (FAILED(_hr)) {                                      \
+            return _hr;                                         \
+        }                                                       \
+    } while (false)
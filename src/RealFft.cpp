@@ -0,0 +1,85 @@
+#include "RealFft.h"
+#include <cmath>
+
+using Complex = std::complex<float>;
+
+// Plain product; std::complex's operator* adds NaN/Inf recovery that is not
+// needed here and keeps the loops from vectorizing
+static inline Complex mul(Complex a, Complex b) {
+    return { a.real() * b.real() - a.imag() * b.imag(),
+             a.real() * b.imag() + a.imag() * b.real() };
+}
+
+bool RealFft::init(uint32_t size) {
+    if (size < kMinFftSize || size > kMaxFftSize || (size & (size - 1)) != 0) return false;
+
+    m_size = size;
+    const uint32_t half = size / 2;
+    const double pi = 3.14159265358979323846;
+
+    m_work.assign(half, Complex());
+    m_twiddle.resize(half / 2);
+    for (uint32_t k = 0; k < half / 2; ++k) {
+        double a = -2.0 * pi * k / half;
+        m_twiddle[k] = Complex(static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a)));
+    }
+    m_split.resize(half);
+    for (uint32_t k = 0; k < half; ++k) {
+        double a = -2.0 * pi * k / size;
+        m_split[k] = Complex(static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a)));
+    }
+
+    uint32_t bits = 0;
+    while ((1u << bits) < half) ++bits;
+    m_bitReverse.resize(half);
+    for (uint32_t i = 0; i < half; ++i) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; ++b)
+            if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+        m_bitReverse[i] = r;
+    }
+    return true;
+}
+
+void RealFft::forward(const float* in, Complex* out) {
+    const uint32_t half = m_size / 2;
+    Complex* a = m_work.data();
+
+    // Even samples as real parts, odd samples as imaginary parts, loaded
+    // straight into bit-reversed order
+    for (uint32_t i = 0; i < half; ++i)
+        a[m_bitReverse[i]] = Complex(in[2 * i], in[2 * i + 1]);
+
+    // First stage has no twiddles
+    for (uint32_t i = 0; i < half; i += 2) {
+        Complex u = a[i], v = a[i + 1];
+        a[i] = u + v;
+        a[i + 1] = u - v;
+    }
+    for (uint32_t len = 4; len <= half; len <<= 1) {
+        const uint32_t span = len / 2;
+        const uint32_t step = half / len;
+        for (uint32_t i = 0; i < half; i += len) {
+            for (uint32_t j = 0; j < span; ++j) {
+                Complex u = a[i + j];
+                Complex v = mul(a[i + j + span], m_twiddle[j * step]);
+                a[i + j] = u + v;
+                a[i + j + span] = u - v;
+            }
+        }
+    }
+
+    // Split the packed spectrum Z into the real signal's X:
+    //   X[k] = (Z[k] + conj(Z[h-k])) / 2 - i/2 · W^k · (Z[k] - conj(Z[h-k]))
+    out[0] = Complex(a[0].real() + a[0].imag(), 0.0f);
+    out[half] = Complex(a[0].real() - a[0].imag(), 0.0f);
+    for (uint32_t k = 1; k < half; ++k) {
+        Complex z = a[k];
+        Complex zc = std::conj(a[half - k]);
+        Complex even = 0.5f * (z + zc);
+        Complex odd = 0.5f * (z - zc);
+        // -i · odd
+        Complex rot(odd.imag(), -odd.real());
+        out[k] = even + mul(m_split[k], rot);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+// FFT sizes the analyzer accepts
+constexpr uint32_t kMinFftSize = 64;
+constexpr uint32_t kMaxFftSize = 32768;
+
+// Forward FFT of a real signal, power-of-two size.
+//
+// The N real samples are packed as N/2 complex points, transformed by an
+// iterative radix-2 FFT and split into the N/2+1 bins of the real
+// spectrum, which halves the work of a complex FFT of the same size.
+// Twiddles and the bit-reversal table are built by init(); forward() does
+// not allocate or call sin/cos.
+class RealFft {
+public:
+    // False unless size is a power of two in [kMinFftSize, kMaxFftSize]
+    bool init(uint32_t size);
+
+    uint32_t size() const { return m_size; }
+    uint32_t bins() const { return m_size / 2 + 1; }
+
+    // 'in' holds size() samples, 'out' receives bins() values (unscaled)
+    void forward(const float* in, std::complex<float>* out);
+
+private:
+    uint32_t                         m_size = 0;
+    std::vector<std::complex<float>> m_work;       // size/2 packed points
+    std::vector<std::complex<float>> m_twiddle;    // half-size FFT, size/4 entries
+    std::vector<std::complex<float>> m_split;      // e^(-2πik/size), size/2 entries
+    std::vector<uint32_t>            m_bitReverse; // size/2 entries
+};
@@ -0,0 +1,238 @@
+// Interposers for AUDIOBRIDGE_RT_CHECK builds (Linux/glibc only).
+//
+// The functions below replace the libc ones for the whole process. Outside a
+// RealtimeSection they forward straight to the real implementation; inside
+// one they first record a violation.
+
+#include "RealtimeCheck.h"
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void  __libc_free(void*);
+void* __libc_memalign(size_t, size_t);
+}
+
+static __thread int         t_depth = 0;        // > 0 inside a realtime section
+static __thread const char* t_label = nullptr;
+static __thread int         t_reporting = 0;    // set while a violation is being reported
+
+static std::atomic<UINT64> g_violations{0};
+
+// Hashes of the call stacks already printed, so a violation in a period loop
+// is shown once instead of a hundred times per second
+static constexpr size_t kSeenSlots = 512;
+static std::atomic<uint64_t> g_seen[kSeenSlots];
+
+// ── Real functions ────────────────────────────────────────────────
+
+using MutexLockFn = int (*)(pthread_mutex_t*);
+using CondWaitFn  = int (*)(pthread_cond_t*, pthread_mutex_t*);
+using CondTimedFn = int (*)(pthread_cond_t*, pthread_mutex_t*, const timespec*);
+using NanosleepFn = int (*)(const timespec*, timespec*);
+using ClockSleepFn = int (*)(clockid_t, int, const timespec*, timespec*);
+using ReadFn      = ssize_t (*)(int, void*, size_t);
+using WriteFn     = ssize_t (*)(int, const void*, size_t);
+using FreadFn     = size_t (*)(void*, size_t, size_t, FILE*);
+using FwriteFn    = size_t (*)(const void*, size_t, size_t, FILE*);
+using FopenFn     = FILE* (*)(const char*, const char*);
+using FcloseFn    = int (*)(FILE*);
+using FflushFn    = int (*)(FILE*);
+
+static MutexLockFn  s_mutexLock;
+static CondWaitFn   s_condWait;
+static CondTimedFn  s_condTimedWait;
+static NanosleepFn  s_nanosleep;
+static ClockSleepFn s_clockNanosleep;
+static ReadFn       s_read;
+static WriteFn      s_write;
+static FreadFn      s_fread;
+static FwriteFn     s_fwrite;
+static FopenFn      s_fopen;
+static FcloseFn     s_fclose;
+static FflushFn     s_fflush;
+
+template <class Fn>
+static Fn realFn(Fn& cache, const char* name) {
+    if (!cache) cache = reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+    return cache;
+}
+
+// Resolve everything (and load the unwinder) before any audio thread runs
+__attribute__((constructor)) static void rtCheckInit() {
+    realFn(s_mutexLock, "pthread_mutex_lock");
+    realFn(s_condWait, "pthread_cond_wait");
+    realFn(s_condTimedWait, "pthread_cond_timedwait");
+    realFn(s_nanosleep, "nanosleep");
+    realFn(s_clockNanosleep, "clock_nanosleep");
+    realFn(s_read, "read");
+    realFn(s_write, "write");
+    realFn(s_fread, "fread");
+    realFn(s_fwrite, "fwrite");
+    realFn(s_fopen, "fopen");
+    realFn(s_fclose, "fclose");
+    realFn(s_fflush, "fflush");
+
+    void* frames[2];
+    backtrace(frames, 2);
+}
+
+// ── Reporting ─────────────────────────────────────────────────────
+
+static bool firstSighting(uint64_t hash) {
+    if (hash == 0) hash = 1;
+    for (size_t i = 0; i < kSeenSlots; ++i) {
+        std::atomic<uint64_t>& slot = g_seen[(hash + i) % kSeenSlots];
+        uint64_t cur = slot.load(std::memory_order_relaxed);
+        if (cur == hash) return false;
+        if (cur == 0 && slot.compare_exchange_strong(cur, hash)) return true;
+        if (cur == hash) return false;
+    }
+    return false;   // table full: count, but stop printing
+}
+
+static void violation(const char* what) {
+    if (t_depth == 0 || t_reporting) return;
+    t_reporting = 1;
+
+    g_violations.fetch_add(1, std::memory_order_relaxed);
+
+    void* frames[32];
+    int n = backtrace(frames, 32);
+    uint64_t hash = 1469598103934665603ull;     // FNV-1a over the return addresses
+    for (int i = 1; i < n; ++i) {
+        hash ^= reinterpret_cast<uintptr_t>(frames[i]);
+        hash *= 1099511628211ull;
+    }
+
+    if (firstSighting(hash)) {
+        char line[160];
+        int len = std::snprintf(line, sizeof(line), "realtime violation: %s on %s thread\n",
+                                what, t_label ? t_label : "audio");
+        if (len > 0) realFn(s_write, "write")(STDERR_FILENO, line, static_cast<size_t>(len));
+        backtrace_symbols_fd(frames + 1, n - 1, STDERR_FILENO);
+    }
+
+    t_reporting = 0;
+}
+
+void rtCheckEnter(const char* label) {
+    if (t_depth++ == 0) t_label = label;
+}
+
+void rtCheckLeave() {
+    if (t_depth > 0) --t_depth;
+}
+
+UINT64 rtCheckViolations() {
+    return g_violations.load(std::memory_order_relaxed);
+}
+
+// ── Interposers ───────────────────────────────────────────────────
+
+extern "C" {
+
+void* malloc(size_t size) {
+    violation("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    violation("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    violation("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    if (ptr) violation("free");
+    __libc_free(ptr);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    violation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    violation("posix_memalign");
+    void* p = __libc_memalign(alignment, size);
+    if (!p) return 12;  // ENOMEM
+    *out = p;
+    return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    violation("pthread_mutex_lock");
+    return realFn(s_mutexLock, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    violation("pthread_cond_wait");
+    return realFn(s_condWait, "pthread_cond_wait")(cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const timespec* abstime) {
+    violation("pthread_cond_timedwait");
+    return realFn(s_condTimedWait, "pthread_cond_timedwait")(cond, mutex, abstime);
+}
+
+int nanosleep(const timespec* req, timespec* rem) {
+    violation("nanosleep");
+    return realFn(s_nanosleep, "nanosleep")(req, rem);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const timespec* req, timespec* rem) {
+    violation("clock_nanosleep");
+    return realFn(s_clockNanosleep, "clock_nanosleep")(clock, flags, req, rem);
+}
+
+ssize_t read(int fd, void* buf, size_t count) {
+    violation("read");
+    return realFn(s_read, "read")(fd, buf, count);
+}
+
+ssize_t write(int fd, const void* buf, size_t count) {
+    violation("write");
+    return realFn(s_write, "write")(fd, buf, count);
+}
+
+size_t fread(void* ptr, size_t size, size_t count, FILE* stream) {
+    violation("fread");
+    return realFn(s_fread, "fread")(ptr, size, count, stream);
+}
+
+size_t fwrite(const void* ptr, size_t size, size_t count, FILE* stream) {
+    violation("fwrite");
+    return realFn(s_fwrite, "fwrite")(ptr, size, count, stream);
+}
+
+FILE* fopen(const char* path, const char* mode) {
+    violation("fopen");
+    return realFn(s_fopen, "fopen")(path, mode);
+}
+
+int fclose(FILE* stream) {
+    violation("fclose");
+    return realFn(s_fclose, "fclose")(stream);
+}
+
+int fflush(FILE* stream) {
+    violation("fflush");
+    return realFn(s_fflush, "fflush")(stream);
+}
+
+} // extern "C"
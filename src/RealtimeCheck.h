@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Platform.h"
+
+// Debug aid: catches calls that can block inside the realtime sections of the
+// audio threads (capture/render period work, resampler step).
+//
+// Configure with -DAUDIOBRIDGE_RT_CHECK=ON (Linux/glibc). Heap allocation,
+// mutex locks, condition waits, sleeps and file I/O made from inside a
+// RealtimeSection are then counted and reported on stderr together with a
+// stack trace (once per call site). Without the option the sections compile
+// to nothing.
+#ifdef AUDIOBRIDGE_RT_CHECK
+void   rtCheckEnter(const char* label);
+void   rtCheckLeave();
+UINT64 rtCheckViolations();
+#else
+inline void   rtCheckEnter(const char*) {}
+inline void   rtCheckLeave() {}
+inline UINT64 rtCheckViolations() { return 0; }
+#endif
+
+// Marks the enclosing scope as realtime work. 'label' must be a string literal.
+class RealtimeSection {
+public:
+    explicit RealtimeSection(const char* label) { rtCheckEnter(label); }
+    ~RealtimeSection() { rtCheckLeave(); }
+
+    RealtimeSection(const RealtimeSection&) = delete;
+    RealtimeSection& operator=(const RealtimeSection&) = delete;
+};
@@ -0,0 +1,205 @@
+#include "RealtimeThread.h"
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#define AUDIOBRIDGE_MXCSR 1
+#include <xmmintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <avrt.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+// POSIX priority for Device threads when the policy does not name one; Worker
+// threads run this much lower so they never preempt a device period.
+static constexpr int kDefaultDevicePriority = 70;
+static constexpr int kWorkerPriorityOffset  = 10;
+
+#ifdef AUDIOBRIDGE_MXCSR
+static constexpr unsigned kMxcsrFtz = 0x8000;
+static constexpr unsigned kMxcsrDaz = 0x0040;
+#elif defined(__aarch64__)
+static constexpr UINT64 kFpcrFz = 1ull << 24;
+
+static UINT64 readFpcr() {
+    UINT64 v;
+    __asm__ volatile("mrs %0, fpcr" : "=r"(v));
+    return v;
+}
+static void writeFpcr(UINT64 v) {
+    __asm__ volatile("msr fpcr, %0" : : "r"(v));
+}
+#endif
+
+RealtimeThreadScope::RealtimeThreadScope(const RealtimePolicy& policy, ThreadRole role) {
+    m_report.applied = true;
+    m_report.role = role;
+
+    // Scheduling class
+    if (policy.realtime) {
+#ifdef _WIN32
+        DWORD taskIndex = 0;
+        m_mmcss = AvSetMmThreadCharacteristicsW(role == ThreadRole::Device ? L"Pro Audio" : L"Audio",
+                                                &taskIndex);
+        m_report.realtime = (m_mmcss != nullptr);
+#else
+        sched_param saved = {};
+        if (pthread_getschedparam(pthread_self(), &m_savedSchedPolicy, &saved) == 0)
+            m_savedSchedPriority = saved.sched_priority;
+        else
+            m_savedSchedPolicy = -1;
+
+        const int sched = (role == ThreadRole::Device) ? SCHED_FIFO : SCHED_RR;
+        int prio = policy.priority > 0 ? policy.priority : kDefaultDevicePriority;
+        if (role == ThreadRole::Worker) prio -= kWorkerPriorityOffset;
+        prio = (std::min)((std::max)(prio, sched_get_priority_min(sched)), sched_get_priority_max(sched));
+
+        sched_param sp = {};
+        sp.sched_priority = prio;
+        if (pthread_setschedparam(pthread_self(), sched, &sp) == 0) {
+            m_report.realtime = true;
+            m_report.priority = prio;
+        }
+#endif
+    }
+
+    // Core pinning
+    if (policy.cpuMask != 0) {
+#ifdef _WIN32
+        m_savedAffinity = SetThreadAffinityMask(GetCurrentThread(),
+                                                static_cast<DWORD_PTR>(policy.cpuMask));
+        if (m_savedAffinity != 0) m_report.cpuMask = policy.cpuMask;
+#elif defined(__linux__)
+        cpu_set_t current;
+        CPU_ZERO(&current);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(current), &current) == 0) {
+            for (int cpu = 0; cpu < 64; ++cpu)
+                if (CPU_ISSET(cpu, &current)) m_savedAffinity |= 1ull << cpu;
+            m_affinitySaved = true;
+        }
+
+        cpu_set_t wanted;
+        CPU_ZERO(&wanted);
+        for (int cpu = 0; cpu < 64; ++cpu)
+            if (policy.cpuMask & (1ull << cpu)) CPU_SET(cpu, &wanted);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(wanted), &wanted) == 0)
+            m_report.cpuMask = policy.cpuMask;
+#endif
+    }
+
+    // Denormals: decaying filter tails otherwise hit the slow microcode path
+    if (policy.flushDenormals) {
+#ifdef AUDIOBRIDGE_MXCSR
+        unsigned csr = _mm_getcsr();
+        m_savedFpControl = csr;
+        m_fpSaved = true;
+        _mm_setcsr(csr | kMxcsrFtz | kMxcsrDaz);
+        m_report.denormalsOff = true;
+#elif defined(__aarch64__)
+        m_savedFpControl = readFpcr();
+        m_fpSaved = true;
+        writeFpcr(m_savedFpControl | kFpcrFz);
+        m_report.denormalsOff = true;
+#endif
+    }
+}
+
+RealtimeThreadScope::~RealtimeThreadScope() {
+    if (m_fpSaved) {
+#ifdef AUDIOBRIDGE_MXCSR
+        _mm_setcsr(static_cast<unsigned>(m_savedFpControl));
+#elif defined(__aarch64__)
+        writeFpcr(m_savedFpControl);
+#endif
+    }
+
+#ifdef _WIN32
+    if (m_report.cpuMask != 0 && m_savedAffinity != 0)
+        SetThreadAffinityMask(GetCurrentThread(), m_savedAffinity);
+    if (m_mmcss) AvRevertMmThreadCharacteristics(m_mmcss);
+#else
+#ifdef __linux__
+    if (m_report.cpuMask != 0 && m_affinitySaved) {
+        cpu_set_t saved;
+        CPU_ZERO(&saved);
+        for (int cpu = 0; cpu < 64; ++cpu)
+            if (m_savedAffinity & (1ull << cpu)) CPU_SET(cpu, &saved);
+        pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    }
+#endif
+    if (m_report.realtime && m_savedSchedPolicy >= 0) {
+        sched_param sp = {};
+        sp.sched_priority = m_savedSchedPriority;
+        pthread_setschedparam(pthread_self(), m_savedSchedPolicy, &sp);
+    }
+#endif
+}
+
+void lowerThreadPriority() {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+}
+
+bool parseCpuList(const std::string& text, UINT64& mask) {
+    mask = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = text.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        item.erase(std::remove(item.begin(), item.end(), ' '), item.end());
+        if (item.empty()) continue;
+
+        char* end = nullptr;
+        long first = std::strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-') last = std::strtol(end + 1, &end, 10);
+        if (*end != '\0' || first < 0 || last < first || last > 63) return false;
+
+        for (long cpu = first; cpu <= last; ++cpu)
+            mask |= 1ull << cpu;
+    }
+    return true;
+}
+
+std::string cpuListToString(UINT64 mask) {
+    std::string out;
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (!(mask & (1ull << cpu))) continue;
+        if (!out.empty()) out += ',';
+        out += std::to_string(cpu);
+    }
+    return out;
+}
+
+std::string describeRealtime(const RealtimeReport& report) {
+    if (!report.applied) return "-";
+
+    std::string out;
+    if (!report.realtime) {
+        out = "normal";
+    } else {
+#ifdef _WIN32
+        out = "mmcss";
+#else
+        out = (report.role == ThreadRole::Device ? "fifo:" : "rr:") + std::to_string(report.priority);
+#endif
+    }
+    if (report.cpuMask != 0) out += " cpu=" + cpuListToString(report.cpuMask);
+    if (report.denormalsOff) out += " ftz";
+    return out;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include "Platform.h"
+
+// What a thread does in the pipeline; decides how it is scheduled.
+enum class ThreadRole {
+    Device,     // capture/render period loop: MMCSS "Pro Audio" / SCHED_FIFO
+    Worker      // resampler and other stages: MMCSS "Audio" / SCHED_RR, lower priority
+};
+
+// Requested scheduling for the audio threads of a route.
+struct RealtimePolicy {
+    bool   realtime       = true;   // MMCSS task (Windows) or SCHED_FIFO/RR (POSIX)
+    int    priority       = 0;      // POSIX priority for Device threads, 0 = default
+    UINT64 cpuMask        = 0;      // bit n = core n, 0 = let the OS choose
+    bool   flushDenormals = true;   // FTZ/DAZ for the thread's float math
+};
+
+// What a thread actually got; requests may fail without privileges.
+struct RealtimeReport {
+    bool       applied    = false;  // thread has started and applied its policy
+    ThreadRole role       = ThreadRole::Device;
+    bool       realtime   = false;  // MMCSS task joined / realtime class obtained
+    int        priority   = 0;      // POSIX priority obtained (0 on Windows)
+    UINT64     cpuMask    = 0;      // affinity set, 0 = not pinned
+    bool       denormalsOff = false; // FTZ/DAZ set
+};
+
+// Applies a policy to the calling thread for the lifetime of the scope and
+// restores the previous settings afterwards. Create it first thing in the
+// thread function.
+class RealtimeThreadScope {
+public:
+    RealtimeThreadScope(const RealtimePolicy& policy, ThreadRole role);
+    ~RealtimeThreadScope();
+
+    const RealtimeReport& report() const { return m_report; }
+
+    RealtimeThreadScope(const RealtimeThreadScope&) = delete;
+    RealtimeThreadScope& operator=(const RealtimeThreadScope&) = delete;
+
+private:
+    RealtimeReport m_report;
+#ifdef _WIN32
+    HANDLE    m_mmcss = nullptr;
+    DWORD_PTR m_savedAffinity = 0;
+#else
+    int       m_savedSchedPolicy = -1;
+    int       m_savedSchedPriority = 0;
+    bool      m_affinitySaved = false;
+    UINT64    m_savedAffinity = 0;
+#endif
+    bool      m_fpSaved = false;
+    UINT64    m_savedFpControl = 0;
+};
+
+// Publishes a thread's report to other threads (status readers) without
+// locking: the audio thread writes it once at startup.
+class RealtimeReportSlot {
+public:
+    void publish(const RealtimeReport& report) {
+        m_report = report;
+        m_ready.store(true, std::memory_order_release);
+    }
+    void clear() { m_ready.store(false, std::memory_order_relaxed); }
+
+    RealtimeReport load() const {
+        return m_ready.load(std::memory_order_acquire) ? m_report : RealtimeReport();
+    }
+
+private:
+    RealtimeReport    m_report;
+    std::atomic<bool> m_ready{false};
+};
+
+// Background threads (recording writer, spectrum analyzer) call this first
+// so they never compete with the audio threads for the CPU
+void lowerThreadPriority();
+
+// "2,3" or "0-3" <-> core mask
+bool        parseCpuList(const std::string& text, UINT64& mask);
+std::string cpuListToString(UINT64 mask);
+
+// Short description for logs, e.g. "fifo:70 cpu=2,3 ftz" or "mmcss ftz"
+std::string describeRealtime(const RealtimeReport& report);
@@ -4,13 +4,22 @@
 #include <cstring>
 #include <vector>
 #include <algorithm>
+#include "AudioArena.h"
 
 // Single-Producer Single-Consumer lock-free ring buffer.
 // Stores raw audio bytes. Thread-safe without mutexes.
+// Runs of silence can be queued as compact markers (writeSilence) so that
+// no zero bytes are written, copied or filtered until a consumer needs them.
+//
+// Each side keeps a private copy of the other side's index and only reloads
+// the shared atomic when the copy says the ring is too full (producer) or too
+// empty (consumer). In steady state the index cache lines then move between
+// cores about once per refill instead of on every call.
 class RingBuffer {
 public:
-    explicit RingBuffer(size_t capacityBytes)
-        : m_buffer(capacityBytes > 0 ? capacityBytes : 1)
+    // With an arena the storage is taken from it (prefaulted and locked)
+    explicit RingBuffer(size_t capacityBytes, AudioArena* arena = nullptr)
+        : m_buffer(capacityBytes > 0 ? capacityBytes : 1, 0, ArenaAllocator<uint8_t>(arena))
         , m_capacity(capacityBytes > 0 ? capacityBytes : 1)
         , m_head(0)
         , m_tail(0)
@@ -19,28 +28,38 @@ public:
     void reset() {
         m_head.store(0, std::memory_order_relaxed);
         m_tail.store(0, std::memory_order_relaxed);
+        m_markerHead.store(0, std::memory_order_relaxed);
+        m_markerTail.store(0, std::memory_order_relaxed);
+        m_ended.store(false, std::memory_order_relaxed);
+        m_tailCache = 0;
+        m_headCache = 0;
     }
 
     size_t capacity() const { return m_capacity; }
 
+    // Exact fill level from both shared indices; safe from any thread
     size_t availableToRead() const {
         size_t h = m_head.load(std::memory_order_acquire);
         size_t t = m_tail.load(std::memory_order_relaxed);
-        return (h >= t) ? (h - t) : (m_capacity - t + h);
+        return used(h, t);
     }
 
     size_t availableToWrite() const {
         return m_capacity - 1 - availableToRead();
     }
 
+    // Producer: whether 'bytes' more fit, for callers that write all or nothing
+    bool canWrite(size_t bytes) {
+        return writable(m_head.load(std::memory_order_relaxed), bytes) >= bytes;
+    }
+
     // Producer: write data into the ring buffer.
     // Returns number of bytes actually written.
     size_t write(const void* data, size_t bytes) {
-        size_t avail = availableToWrite();
-        size_t toWrite = (std::min)(bytes, avail);
+        size_t h = m_head.load(std::memory_order_relaxed);
+        size_t toWrite = (std::min)(bytes, writable(h, bytes));
         if (toWrite == 0) return 0;
 
-        size_t h = m_head.load(std::memory_order_relaxed);
         const uint8_t* src = static_cast<const uint8_t*>(data);
 
         size_t firstPart = (std::min)(toWrite, m_capacity - h);
@@ -54,20 +73,162 @@ public:
         return toWrite;
     }
 
-    // Consumer: read data from the ring buffer.
-    // Returns number of bytes actually read.
-    size_t read(void* dest, size_t bytes) {
-        size_t avail = availableToRead();
-        size_t toRead = (std::min)(bytes, avail);
-        if (toRead == 0) return 0;
+    // Producer: append a run of silence without touching the data bytes.
+    // The run is carried as a marker and expanded (or skipped) by the consumer.
+    // Returns number of bytes of silence actually queued.
+    size_t writeSilence(size_t bytes) {
+        size_t h = m_head.load(std::memory_order_relaxed);
+        size_t toWrite = (std::min)(bytes, writable(h, bytes));
+        if (toWrite == 0) return 0;
 
+        size_t mh = m_markerHead.load(std::memory_order_relaxed);
+        size_t mt = m_markerTail.load(std::memory_order_acquire);
+
+        if (mh - mt < kMaxMarkers) {
+            m_markers[mh % kMaxMarkers] = { h, toWrite };
+            m_markerHead.store(mh + 1, std::memory_order_release);
+        } else {
+            // Marker queue full: fall back to real zero bytes
+            size_t firstPart = (std::min)(toWrite, m_capacity - h);
+            std::memset(m_buffer.data() + h, 0, firstPart);
+            if (toWrite > firstPart) {
+                std::memset(m_buffer.data(), 0, toWrite - firstPart);
+            }
+        }
+
+        size_t newHead = (h + toWrite) % m_capacity;
+        m_head.store(newHead, std::memory_order_release);
+        return toWrite;
+    }
+
+    // Consumer: length of the run at the read position and whether it is
+    // silence. Data runs end where the next silence marker starts.
+    // 'wanted' is how much the caller hopes to take; the producer's index is
+    // only reloaded when less than that is known to be queued.
+    size_t nextRun(bool& silent, size_t wanted = 1) {
         size_t t = m_tail.load(std::memory_order_relaxed);
-        uint8_t* dst = static_cast<uint8_t*>(dest);
+        size_t avail = readable(t, wanted);
+        silent = false;
+        if (avail == 0) return 0;
+
+        const SilenceMarker* m = frontMarker();
+        if (!m) return avail;
+
+        size_t dist = (m->offset + m_capacity - t) % m_capacity;
+        if (dist == 0) {
+            silent = true;
+            return (std::min)(m->length, avail);
+        }
+        return (std::min)(dist, avail);
+    }
+
+    // Producer: the stream is complete, nothing more will be written
+    void markEnd() { m_ended.store(true, std::memory_order_release); }
+
+    // Any thread: the producer has ended the stream (data may still be queued)
+    bool ended() const { return m_ended.load(std::memory_order_acquire); }
+
+    // Consumer: the producer has ended the stream and all of it has been read
+    bool drained() {
+        if (!m_ended.load(std::memory_order_acquire)) return false;
+        return readable(m_tail.load(std::memory_order_relaxed), 1) == 0;
+    }
+
+    // Consumer: read data from the ring buffer. Silence runs are expanded
+    // into zeros. Returns number of bytes actually read.
+    size_t read(void* dest, size_t bytes) {
+        return consume(static_cast<uint8_t*>(dest), bytes);
+    }
+
+    // Consumer: discard bytes (data or silence) without copying them.
+    size_t skip(size_t bytes) {
+        return consume(nullptr, bytes);
+    }
+
+private:
+    struct SilenceMarker {
+        size_t offset;  // ring position where the run starts
+        size_t length;  // bytes remaining in the run
+    };
+    static constexpr size_t kMaxMarkers = 256;
+
+    size_t used(size_t h, size_t t) const {
+        return (h >= t) ? (h - t) : (m_capacity - t + h);
+    }
+
+    // Producer: free space, reloading the consumer's index only when the
+    // cached one leaves less than 'wanted' bytes
+    size_t writable(size_t h, size_t wanted) {
+        size_t space = m_capacity - 1 - used(h, m_tailCache);
+        if (space < wanted) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            space = m_capacity - 1 - used(h, m_tailCache);
+        }
+        return space;
+    }
+
+    // Consumer: queued bytes, reloading the producer's index only when the
+    // cached one shows less than 'wanted' bytes
+    size_t readable(size_t t, size_t wanted) {
+        size_t avail = used(m_headCache, t);
+        if (avail < wanted) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            avail = used(m_headCache, t);
+        }
+        return avail;
+    }
 
-        size_t firstPart = (std::min)(toRead, m_capacity - t);
+    SilenceMarker* frontMarker() {
+        size_t mt = m_markerTail.load(std::memory_order_relaxed);
+        if (mt == m_markerHead.load(std::memory_order_acquire)) return nullptr;
+        return &m_markers[mt % kMaxMarkers];
+    }
+
+    void copyOut(uint8_t* dst, size_t t, size_t n) const {
+        size_t firstPart = (std::min)(n, m_capacity - t);
         std::memcpy(dst, m_buffer.data() + t, firstPart);
-        if (toRead > firstPart) {
-            std::memcpy(dst + firstPart, m_buffer.data(), toRead - firstPart);
+        if (n > firstPart) {
+            std::memcpy(dst + firstPart, m_buffer.data(), n - firstPart);
+        }
+    }
+
+    size_t consume(uint8_t* dst, size_t bytes) {
+        size_t t = m_tail.load(std::memory_order_relaxed);
+        size_t toRead = (std::min)(bytes, readable(t, bytes));
+        if (toRead == 0) return 0;
+
+        SilenceMarker* m = frontMarker();
+
+        if (!m) {
+            // Fast path: plain data only
+            if (dst) copyOut(dst, t, toRead);
+        } else {
+            size_t done = 0;
+            size_t pos = t;
+            while (done < toRead) {
+                size_t n = toRead - done;
+                if (m) {
+                    size_t dist = (m->offset + m_capacity - pos) % m_capacity;
+                    if (dist == 0) {
+                        n = (std::min)(n, m->length);
+                        if (dst) std::memset(dst + done, 0, n);
+                        m->offset = (m->offset + n) % m_capacity;
+                        m->length -= n;
+                        if (m->length == 0) {
+                            m_markerTail.store(m_markerTail.load(std::memory_order_relaxed) + 1,
+                                               std::memory_order_release);
+                            m = frontMarker();
+                        }
+                        done += n;
+                        pos = (pos + n) % m_capacity;
+                        continue;
+                    }
+                    n = (std::min)(n, dist);
+                }
+                if (dst) copyOut(dst + done, pos, n);
+                done += n;
+                pos = (pos + n) % m_capacity;
+            }
         }
 
         size_t newTail = (t + toRead) % m_capacity;
@@ -75,10 +236,22 @@ public:
         return toRead;
     }
 
-private:
-    std::vector<uint8_t> m_buffer;
-    size_t               m_capacity;
-    // Separate cache lines to avoid false sharing
+    // Read-only after construction; on a line of their own so that neither
+    // index store invalidates them
+    alignas(64) ArenaVector<uint8_t> m_buffer;
+    size_t                           m_capacity;
+
+    // Producer line: its index and its copy of the consumer's
     alignas(64) std::atomic<size_t> m_head;
+    size_t                          m_tailCache = 0;
+
+    // Consumer line: its index and its copy of the producer's
     alignas(64) std::atomic<size_t> m_tail;
+    size_t                          m_headCache = 0;
+
+    // Silence runs queued by the producer, consumed in order by the consumer
+    alignas(64) SilenceMarker       m_markers[kMaxMarkers] = {};
+    alignas(64) std::atomic<size_t> m_markerHead{0};
+    std::atomic<bool>               m_ended{false};     // written once by the producer
+    alignas(64) std::atomic<size_t> m_markerTail{0};
 };
@@ -0,0 +1,327 @@
+#include "RouteConfig.h"
+#include "WavFile.h"
+#include <cstdlib>
+#include <cctype>
+#include <vector>
+
+static std::string trim(const std::string& s) {
+    size_t b = 0, e = s.size();
+    while (b < e && std::isspace(static_cast<unsigned char>(s[b]))) ++b;
+    while (e > b && std::isspace(static_cast<unsigned char>(s[e - 1]))) --e;
+    return s.substr(b, e - b);
+}
+
+static bool iequals(const std::string& a, const char* b) {
+    size_t n = std::char_traits<char>::length(b);
+    if (a.size() != n) return false;
+    for (size_t i = 0; i < n; ++i)
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+    return true;
+}
+
+bool parseAudioFormat(const std::string& text, AudioFormat& format) {
+    size_t s1 = text.find('/');
+    size_t s2 = (s1 == std::string::npos) ? s1 : text.find('/', s1 + 1);
+    if (s2 == std::string::npos) return false;
+
+    long rate = std::strtol(text.substr(0, s1).c_str(), nullptr, 10);
+    long channels = std::strtol(text.substr(s1 + 1, s2 - s1 - 1).c_str(), nullptr, 10);
+    std::string type = trim(text.substr(s2 + 1));
+
+    SampleType t = SampleType::Unknown;
+    if (iequals(type, "s16"))      t = SampleType::Int16;
+    else if (iequals(type, "s24")) t = SampleType::Int24;
+    else if (iequals(type, "s32")) t = SampleType::Int32;
+    else if (iequals(type, "f32")) t = SampleType::Float32;
+    const bool in32 = iequals(type, "s24in32");
+    if (in32) t = SampleType::Int32;
+
+    if (rate <= 0 || channels <= 0 || channels > 32 || t == SampleType::Unknown) return false;
+    format = makeAudioFormat(static_cast<uint32_t>(rate), static_cast<uint16_t>(channels), t);
+    if (in32) format.validBits = 24;
+    return true;
+}
+
+std::string audioFormatToString(const AudioFormat& format) {
+    const char* type = "?";
+    switch (format.type) {
+        case SampleType::Int16:   type = "s16"; break;
+        case SampleType::Int24:   type = "s24"; break;
+        case SampleType::Int32:   type = (format.validBits == 24) ? "s24in32" : "s32"; break;
+        case SampleType::Float32: type = "f32"; break;
+        default: break;
+    }
+    return std::to_string(format.sampleRate) + "/" + std::to_string(format.channels) + "/" + type;
+}
+
+// "wasapi:<id>", "file:<path>", "rtp:<host>:<port>", "shm:<name>" or "null"
+static bool parseEndpoint(const std::string& value, EndpointConfig& ep) {
+    size_t colon = value.find(':');
+    std::string kind = trim(value.substr(0, colon));
+    std::string arg = (colon == std::string::npos) ? std::string() : trim(value.substr(colon + 1));
+
+    if (iequals(kind, "wasapi") && !arg.empty()) ep.backend = EndpointBackend::Wasapi;
+    else if (iequals(kind, "file") && !arg.empty()) ep.backend = EndpointBackend::File;
+    else if (iequals(kind, "rtp") && arg.find(':') != std::string::npos) ep.backend = EndpointBackend::Rtp;
+    else if (iequals(kind, "shm") && !arg.empty()) ep.backend = EndpointBackend::SharedMemory;
+    else if (iequals(kind, "null")) ep.backend = EndpointBackend::Null;
+    else return false;
+
+    ep.device = arg;
+    return true;
+}
+
+bool parseRecordTap(const std::string& text, RecordTap& tap) {
+    if (iequals(text, "capture"))     tap = RecordTap::Capture;
+    else if (iequals(text, "render")) tap = RecordTap::Render;
+    else return false;
+    return true;
+}
+
+// Whole field must be a number
+static bool parseNumber(const std::string& text, float& value) {
+    std::string t = trim(text);
+    if (t.empty()) return false;
+    char* end = nullptr;
+    double v = std::strtod(t.c_str(), &end);
+    if (*end != '\0') return false;
+    value = static_cast<float>(v);
+    return true;
+}
+
+bool parseInsertStage(const std::string& text, DspStageConfig& stage) {
+    std::vector<std::string> f;
+    size_t pos = 0;
+    for (;;) {
+        size_t colon = text.find(':', pos);
+        f.push_back(trim(text.substr(pos, colon == std::string::npos ? std::string::npos : colon - pos)));
+        if (colon == std::string::npos) break;
+        pos = colon + 1;
+    }
+
+    stage = DspStageConfig();
+    const std::string& kind = f[0];
+    if (iequals(kind, "gain")) {
+        stage.type = DspStageType::Gain;
+        return f.size() == 2 && parseNumber(f[1], stage.gainDb);
+    }
+    if (iequals(kind, "dcblock")) {
+        stage.type = DspStageType::DcBlock;
+        stage.frequencyHz = 10.0f;
+        if (f.size() > 2) return false;
+        return f.size() == 1 || (parseNumber(f[1], stage.frequencyHz) && stage.frequencyHz > 0.0f);
+    }
+    if (iequals(kind, "gate")) {
+        stage.type = DspStageType::Gate;
+        if (f.size() < 2 || f.size() > 5) return false;
+        if (!parseNumber(f[1], stage.thresholdDb)) return false;
+        if (f.size() > 2 && !parseNumber(f[2], stage.holdMs)) return false;
+        if (f.size() > 3 && !parseNumber(f[3], stage.releaseMs)) return false;
+        if (f.size() > 4 && !parseNumber(f[4], stage.attackMs)) return false;
+        return stage.holdMs >= 0.0f && stage.releaseMs >= 0.0f && stage.attackMs >= 0.0f;
+    }
+    if (iequals(kind, "eq")) {
+        stage.type = DspStageType::Eq;
+        if (f.size() < 4 || f.size() > 5) return false;
+        const std::string& type = f[1];
+        if (iequals(type, "lowpass"))        stage.filter = BiquadType::LowPass;
+        else if (iequals(type, "highpass"))  stage.filter = BiquadType::HighPass;
+        else if (iequals(type, "bandpass"))  stage.filter = BiquadType::BandPass;
+        else if (iequals(type, "notch"))     stage.filter = BiquadType::Notch;
+        else if (iequals(type, "peak"))      stage.filter = BiquadType::Peak;
+        else if (iequals(type, "lowshelf"))  stage.filter = BiquadType::LowShelf;
+        else if (iequals(type, "highshelf")) stage.filter = BiquadType::HighShelf;
+        else return false;
+        if (!parseNumber(f[2], stage.frequencyHz) || !parseNumber(f[3], stage.q)) return false;
+        if (f.size() == 5 && !parseNumber(f[4], stage.gainDb)) return false;
+        return stage.frequencyHz > 0.0f && stage.q > 0.0f;
+    }
+    return false;
+}
+
+bool parseSpectrumWindow(const std::string& text, SpectrumWindow& window) {
+    if (iequals(text, "hann"))                window = SpectrumWindow::Hann;
+    else if (iequals(text, "blackmanharris")) window = SpectrumWindow::BlackmanHarris;
+    else if (iequals(text, "flattop"))        window = SpectrumWindow::FlatTop;
+    else return false;
+    return true;
+}
+
+HRESULT loadDaemonConfig(const std::string& path, DaemonConfig& config, std::string& error) {
+    FILE* f = openFileUtf8(path.c_str(), "rb");
+    if (!f) {
+        error = "cannot open " + path;
+        return E_ACCESSDENIED;
+    }
+
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+
+    config = DaemonConfig();
+    std::string formatCache = "formatcache.ini";
+    RouteConfig* route = nullptr;
+    bool inDaemon = false;
+    int lineNo = 0;
+
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos) eol = text.size();
+        std::string line = trim(text.substr(pos, eol - pos));
+        pos = eol + 1;
+        ++lineNo;
+
+        if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+        auto fail = [&](const std::string& what) {
+            error = path + ":" + std::to_string(lineNo) + ": " + what;
+            return E_INVALIDARG;
+        };
+
+        if (line.front() == '[') {
+            if (line.back() != ']') return fail("malformed section header");
+            std::string section = trim(line.substr(1, line.size() - 2));
+            inDaemon = iequals(section, "Daemon");
+            route = nullptr;
+            if (!inDaemon) {
+                if (section.size() <= 6 || !iequals(section.substr(0, 6), "Route."))
+                    return fail("unknown section [" + section + "]");
+                std::string name = section.substr(6);
+                for (auto& r : config.routes)
+                    if (r.name == name) return fail("duplicate route " + name);
+                config.routes.emplace_back();
+                route = &config.routes.back();
+                route->name = name;
+                route->capture.backend = EndpointBackend::Null;
+                route->render.backend = EndpointBackend::Null;
+                route->capture.format = makeAudioFormat(48000, 2, SampleType::Float32);
+            }
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) return fail("expected key = value");
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        // Allow trailing comments
+        size_t semi = value.find(" ;");
+        if (semi != std::string::npos) value = trim(value.substr(0, semi));
+
+        if (inDaemon) {
+            if (iequals(key, "StatsInterval")) config.statsIntervalSec = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+            else if (iequals(key, "WorkerThreads")) config.workerThreads = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+            else if (iequals(key, "WorkerRealtime")) config.workerPolicy.realtime = (std::atoi(value.c_str()) != 0);
+            else if (iequals(key, "WorkerCpuAffinity")) {
+                if (!parseCpuList(value, config.workerPolicy.cpuMask)) return fail("bad cpu list " + value);
+            }
+            else if (iequals(key, "FormatCache")) {
+                formatCache = value;
+            }
+            else return fail("unknown key " + key);
+            continue;
+        }
+        if (!route) return fail("key outside of a section");
+
+        if (iequals(key, "Capture")) {
+            if (!parseEndpoint(value, route->capture)) return fail("bad endpoint " + value);
+        } else if (iequals(key, "Render")) {
+            if (!parseEndpoint(value, route->render)) return fail("bad endpoint " + value);
+        } else if (iequals(key, "Exclusive")) {
+            route->capture.exclusive = route->render.exclusive = (std::atoi(value.c_str()) != 0);
+        } else if (iequals(key, "CaptureFormat")) {
+            if (!parseAudioFormat(value, route->capture.format)) return fail("bad format " + value);
+        } else if (iequals(key, "RenderFormat")) {
+            if (!parseAudioFormat(value, route->render.format)) return fail("bad format " + value);
+        } else if (iequals(key, "ToneHz")) {
+            route->capture.toneHz = static_cast<float>(std::atof(value.c_str()));
+        } else if (iequals(key, "Loop")) {
+            route->capture.loop = (std::atoi(value.c_str()) != 0);
+        } else if (iequals(key, "Pacing")) {
+            if (iequals(value, "realtime"))  route->capture.paced = route->render.paced = true;
+            else if (iequals(value, "fast")) route->capture.paced = route->render.paced = false;
+            else return fail("bad pacing " + value);
+        } else if (iequals(key, "ShmBufferMs")) {
+            route->capture.bufferMs = route->render.bufferMs =
+                static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "RtpPayloadType")) {
+            route->render.rtp.payloadType = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "RtpJitterMinMs")) {
+            route->capture.rtp.jitterMinMs = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "RtpJitterMaxMs")) {
+            route->capture.rtp.jitterMaxMs = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "RtpLossPercent")) {
+            route->render.rtp.lossPercent = static_cast<float>(std::atof(value.c_str()));
+        } else if (iequals(key, "RtpReorderPercent")) {
+            route->render.rtp.reorderPercent = static_cast<float>(std::atof(value.c_str()));
+        } else if (iequals(key, "ActivityGate")) {
+            route->options.gateEnabled = (std::atoi(value.c_str()) != 0);
+        } else if (iequals(key, "GateThresholdDb")) {
+            route->options.gateThresholdDb = static_cast<float>(std::atof(value.c_str()));
+        } else if (iequals(key, "GateHoldMs")) {
+            route->options.gateHoldMs = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "Realtime")) {
+            route->options.realtime.realtime = (std::atoi(value.c_str()) != 0);
+        } else if (iequals(key, "RealtimePriority")) {
+            route->options.realtime.priority = std::atoi(value.c_str());
+        } else if (iequals(key, "CpuAffinity")) {
+            if (!parseCpuList(value, route->options.realtime.cpuMask)) return fail("bad cpu list " + value);
+        } else if (iequals(key, "FlushDenormals")) {
+            route->options.realtime.flushDenormals = (std::atoi(value.c_str()) != 0);
+        } else if (iequals(key, "Record")) {
+            route->options.recordPath = value;
+        } else if (iequals(key, "RecordTap")) {
+            if (!parseRecordTap(value, route->options.recordTap)) return fail("bad record tap " + value);
+        } else if (iequals(key, "RecordBufferMs")) {
+            route->options.recordBufferMs = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "Insert")) {
+            DspStageConfig stage;
+            if (!parseInsertStage(value, stage)) return fail("bad insert " + value);
+            route->options.inserts.push_back(stage);
+        } else if (iequals(key, "OutputGainDb")) {
+            route->options.outputGainDb = static_cast<float>(std::atof(value.c_str()));
+        } else if (iequals(key, "Mute")) {
+            route->options.mute = (std::atoi(value.c_str()) != 0);
+        } else if (iequals(key, "Verify")) {
+            route->options.verify = (std::atoi(value.c_str()) != 0);
+        } else if (iequals(key, "Spectrum")) {
+            route->options.spectrum = !iequals(value, "off");
+            if (route->options.spectrum && !parseRecordTap(value, route->options.spectrumTap))
+                return fail("bad spectrum tap " + value);
+        } else if (iequals(key, "SpectrumFftSize")) {
+            route->options.spectrumOptions.fftSize = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "SpectrumOverlap")) {
+            route->options.spectrumOptions.overlapPercent = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "SpectrumRate")) {
+            route->options.spectrumOptions.updateHz = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "SpectrumAverages")) {
+            route->options.spectrumOptions.averages = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "SpectrumDecimation")) {
+            route->options.spectrumOptions.decimation = static_cast<UINT32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (iequals(key, "SpectrumWindow")) {
+            if (!parseSpectrumWindow(value, route->options.spectrumOptions.window))
+                return fail("bad spectrum window " + value);
+        } else {
+            return fail("unknown key " + key);
+        }
+    }
+
+    if (config.routes.empty()) {
+        error = path + ": no [Route.<name>] sections";
+        return E_INVALIDARG;
+    }
+
+    // Relative paths are taken from the config file's directory
+    if (!iequals(formatCache, "off") && !formatCache.empty()) {
+        const bool absolute = formatCache[0] == '/' || formatCache[0] == '\\'
+                           || (formatCache.size() > 1 && formatCache[1] == ':');
+        const size_t slash = path.find_last_of("/\\");
+        config.formatCachePath = (absolute || slash == std::string::npos)
+                               ? formatCache : path.substr(0, slash + 1) + formatCache;
+    }
+    for (auto& r : config.routes)
+        r.options.formatCachePath = config.formatCachePath;
+    return S_OK;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Platform.h"
+#include "AudioEndpoint.h"
+#include "RealtimeThread.h"
+
+// Per-route tuning that is not part of the device selection.
+struct RouteOptions {
+    // Activity gate: input below the threshold for longer than the hold time
+    // idles the resampler and render stages until signal returns. Off by
+    // default: it turns very quiet input into silence.
+    bool   gateEnabled     = false;
+    float  gateThresholdDb = -90.0f;
+    UINT32 gateHoldMs      = 500;
+
+    // Scheduling of the route's capture, render and resampler threads
+    RealtimePolicy realtime;
+
+    // Exclusive-mode formats negotiated per device are remembered here, so
+    // the next start opens the device at once (empty = off)
+    std::string formatCachePath;
+
+    // Recording tap: the route's audio is also written to this WAV file,
+    // empty = off. The side buffer absorbs disk stalls of up to bufferMs.
+    std::string recordPath;
+    RecordTap   recordTap      = RecordTap::Render;
+    UINT32      recordBufferMs = 2000;
+
+    // Insert chain on the render side, in order
+    std::vector<DspStageConfig> inserts;
+    // Output gain and mute after the inserts; both can also be changed live
+    float  outputGainDb = 0.0f;
+    bool   mute         = false;
+
+    // Check that the route passes audio bit for bit: every capture block is
+    // checksummed and compared where render reads it. Only where nothing in
+    // between converts (no resampler); the activity gate is bypassed.
+    bool verify = false;
+
+    // Spectrum analyzer tap, analyzed off the audio threads
+    bool            spectrum    = false;
+    RecordTap       spectrumTap = RecordTap::Render;
+    SpectrumOptions spectrumOptions;
+};
+
+// Everything needed to start one capture → render route.
+struct RouteConfig {
+    std::string    name;
+    EndpointConfig capture;
+    EndpointConfig render;
+    RouteOptions   options;
+};
+
+// Contents of a headless configuration file.
+struct DaemonConfig {
+    UINT32                   statsIntervalSec = 10;
+    UINT32                   workerThreads = 0;     // shared pool size, 0 = automatic
+    RealtimePolicy           workerPolicy;          // shared pool scheduling
+    std::string              formatCachePath;       // also copied into every route's options
+    std::vector<RouteConfig> routes;
+};
+
+// Load an INI-style file:
+//
+//   [Daemon]
+//   StatsInterval = 10
+//   WorkerThreads = 0                           ; shared pool, 0 = automatic
+//   WorkerRealtime = 1
+//   WorkerCpuAffinity = 1
+//   FormatCache = formatcache.ini               ; default: next to the config file, off = none
+//
+//   [Route.radio1]
+//   Capture  = wasapi:{0.0.1.00000000}.{...}   ; or file:<path>, rtp:<host>:<port>, shm:<name>, null
+//   Render   = file:/tmp/radio1.wav             ; rtp:<host>:<port> sends to that address
+//   Exclusive = 0
+//   CaptureFormat = 48000/2/f32                 ; null, rtp and shm capture (shm: if it creates the segment)
+//   RenderFormat  = 48000/2/s16                 ; null/file render, default follows capture
+//   ToneHz = 1000                               ; null capture test tone
+//   Loop = 1                                    ; file capture, 0 = the route ends with the file
+//   Pacing = realtime                           ; null/file: realtime or fast (as fast as possible)
+//   ShmBufferMs = 100                           ; shm: ring length when creating the segment
+//   RtpPayloadType = 96                         ; rtp render
+//   RtpJitterMinMs = 10                         ; rtp capture: jitter buffer target bounds
+//   RtpJitterMaxMs = 200
+//   RtpLossPercent = 0                          ; rtp render, testing: drop packets
+//   RtpReorderPercent = 0                       ; rtp render, testing: reorder packets
+//   ActivityGate = 1
+//   GateThresholdDb = -60
+//   GateHoldMs = 500
+//   Realtime = 1                                ; MMCSS / SCHED_FIFO for the route's threads
+//   RealtimePriority = 70                       ; POSIX only, 0 = default
+//   CpuAffinity = 2,3                           ; cores, or a range like 2-3
+//   FlushDenormals = 1
+//   Record = /var/rec/radio1.wav                ; recording tap, WAV/RF64
+//   RecordTap = render                          ; capture (before resampling) or render
+//   RecordBufferMs = 2000
+//   Insert = dcblock:10                         ; insert chain, one stage per line, in order:
+//   Insert = eq:highshelf:8000:0.7:-3           ;   gain:<dB>, dcblock[:<Hz>],
+//   Insert = gate:-55:50:150                    ;   eq:<type>:<Hz>:<Q>[:<dB>],
+//   Insert = gain:-1.5                          ;   gate:<dB>[:<hold ms>[:<release ms>[:<attack ms>]]]
+//   OutputGainDb = 0                            ; after the inserts
+//   Mute = 0
+//   Verify = 1                                  ; check bit-exact passthrough (gate bypassed)
+//   Spectrum = render                           ; analyzer tap: capture or render, off by default
+//   SpectrumFftSize = 4096                      ; power of two, 64..32768
+//   SpectrumOverlap = 50                        ; percent
+//   SpectrumRate = 10                           ; frames per second
+//   SpectrumAverages = 4                        ; FFTs averaged per frame
+//   SpectrumDecimation = 1                      ; 1..16, narrows the band to zoom in
+//   SpectrumWindow = hann                       ; hann, blackmanharris or flattop
+//
+// On failure 'error' describes the offending line.
+HRESULT loadDaemonConfig(const std::string& path, DaemonConfig& config, std::string& error);
+
+// "48000/2/f32" (sample types s16, s24, s32, f32, and s24in32 for 24 valid
+// bits in a 32-bit container) <-> AudioFormat
+bool        parseAudioFormat(const std::string& text, AudioFormat& format);
+std::string audioFormatToString(const AudioFormat& format);
+
+// "capture" or "render"
+bool        parseRecordTap(const std::string& text, RecordTap& tap);
+
+// One Insert value, e.g. "eq:peak:1000:1.4:+3" (types lowpass, highpass,
+// bandpass, notch, peak, lowshelf, highshelf)
+bool        parseInsertStage(const std::string& text, DspStageConfig& stage);
+
+// "hann", "blackmanharris" or "flattop"
+bool        parseSpectrumWindow(const std::string& text, SpectrumWindow& window);
@@ -0,0 +1,207 @@
+#include "RouteManager.h"
+#include <algorithm>
+
+RouteManager::RouteManager(UINT32 workerThreads, const RealtimePolicy& workerPolicy)
+    : m_pool(workerThreads, workerPolicy)
+{}
+
+RouteManager::~RouteManager() {
+    stopAll();
+}
+
+RouteManager::Route* RouteManager::findRoute(const std::string& name) {
+    for (auto& r : m_routes)
+        if (r->config.name == name) return r.get();
+    return nullptr;
+}
+
+const RouteManager::Route* RouteManager::findRoute(const std::string& name) const {
+    for (auto& r : m_routes)
+        if (r->config.name == name) return r.get();
+    return nullptr;
+}
+
+std::shared_ptr<RouteManager::Route> RouteManager::sharedRoute(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& r : m_routes)
+        if (r->config.name == name) return r;
+    return nullptr;
+}
+
+// Status of a route while its start() or stop() runs
+static RouterStatus transitionStatus(bool starting) {
+    RouterStatus status;
+    status.state = starting ? RouterState::Starting : RouterState::Stopping;
+    return status;
+}
+
+HRESULT RouteManager::addRoute(const RouteConfig& config) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (findRoute(config.name)) return E_INVALIDARG;
+
+    auto route = std::make_shared<Route>();
+    route->config = config;
+    route->router = std::make_unique<AudioRouter>();
+    m_routes.push_back(std::move(route));
+    return S_OK;
+}
+
+HRESULT RouteManager::removeRoute(const std::string& name) {
+    std::shared_ptr<Route> route = sharedRoute(name);
+    if (!route) return E_INVALIDARG;
+    // Waits for a start or stop in progress
+    std::lock_guard<std::mutex> control(route->control);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find(m_routes.begin(), m_routes.end(), route);
+        if (it == m_routes.end()) return E_INVALIDARG;   // removed meanwhile
+        m_routes.erase(it);
+    }
+    // Out of the list, so nobody else reaches the router; 'route' keeps it alive
+    route->router->stop();
+    return S_OK;
+}
+
+// Device init and the prebuffer wait take a while: other routes' status
+// and live changes must not wait for them, so m_mutex is only held to
+// take the config and to flag the route
+HRESULT RouteManager::startRoute(Route& route) {
+    std::lock_guard<std::mutex> control(route.control);
+    RouteConfig config;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        config = route.config;
+        route.starting = true;
+    }
+    HRESULT hr = route.router->start(config, &m_pool);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        route.starting = false;
+    }
+    return hr;
+}
+
+// Stopping joins the route's threads and drains the recorder to disk, so
+// like start() it runs with the route flagged instead of under m_mutex
+void RouteManager::stopRoute(Route& route) {
+    std::lock_guard<std::mutex> control(route.control);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        route.stopping = true;
+    }
+    route.router->stop();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        route.stopping = false;
+    }
+}
+
+HRESULT RouteManager::startRoute(const std::string& name) {
+    std::shared_ptr<Route> route = sharedRoute(name);
+    if (!route) return E_INVALIDARG;
+    return startRoute(*route);
+}
+
+HRESULT RouteManager::stopRoute(const std::string& name) {
+    std::shared_ptr<Route> route = sharedRoute(name);
+    if (!route) return E_INVALIDARG;
+    stopRoute(*route);
+    return S_OK;
+}
+
+size_t RouteManager::startAll() {
+    std::vector<std::shared_ptr<Route>> routes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        routes = m_routes;
+    }
+    size_t running = 0;
+    for (auto& r : routes) {
+        bool isRunning = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            isRunning = !r->busy() && r->router->getStatus().state == RouterState::Running;
+        }
+        if (isRunning || SUCCEEDED(startRoute(*r)))
+            ++running;
+    }
+    return running;
+}
+
+void RouteManager::stopAll() {
+    std::vector<std::shared_ptr<Route>> routes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        routes = m_routes;
+    }
+    for (auto& r : routes)
+        stopRoute(*r);
+}
+
+std::vector<RouteStatusEntry> RouteManager::getStatus() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<RouteStatusEntry> result;
+    result.reserve(m_routes.size());
+    for (auto& r : m_routes)
+        result.push_back({ r->config.name, r->busy() ? transitionStatus(r->starting) : r->router->getStatus() });
+    return result;
+}
+
+HRESULT RouteManager::getStatus(const std::string& name, RouterStatus& status) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Route* route = findRoute(name);
+    if (!route) return E_INVALIDARG;
+    status = route->busy() ? transitionStatus(route->starting) : route->router->getStatus();
+    return S_OK;
+}
+
+HRESULT RouteManager::getSpectrum(const std::string& name, SpectrumFrame& frame) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Route* route = findRoute(name);
+    if (!route) return E_INVALIDARG;
+    if (route->busy()) return S_FALSE;
+    return route->router->getSpectrum(frame) ? S_OK : S_FALSE;
+}
+
+HRESULT RouteManager::setOutputGain(const std::string& name, float gainDb) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Route* route = findRoute(name);
+    if (!route) return E_INVALIDARG;
+    if (route->busy()) return E_NOT_VALID_STATE;
+    HRESULT hr = route->router->setOutputGain(gainDb);
+    if (SUCCEEDED(hr)) route->config.options.outputGainDb = gainDb;
+    return hr;
+}
+
+HRESULT RouteManager::setMute(const std::string& name, bool mute) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Route* route = findRoute(name);
+    if (!route) return E_INVALIDARG;
+    if (route->busy()) return E_NOT_VALID_STATE;
+    HRESULT hr = route->router->setMute(mute);
+    if (SUCCEEDED(hr)) route->config.options.mute = mute;
+    return hr;
+}
+
+HRESULT RouteManager::setMatrixGain(const std::string& name, UINT32 output, UINT32 input, float gain) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Route* route = findRoute(name);
+    if (!route) return E_INVALIDARG;
+    if (route->busy()) return E_NOT_VALID_STATE;
+    return route->router->setMatrixGain(output, input, gain);
+}
+
+HRESULT RouteManager::setInsert(const std::string& name, UINT32 index, const DspStageConfig& stage) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Route* route = findRoute(name);
+    if (!route) return E_INVALIDARG;
+    if (route->busy()) return E_NOT_VALID_STATE;
+    HRESULT hr = route->router->setInsert(index, stage);
+    if (SUCCEEDED(hr)) route->config.options.inserts[index] = stage;
+    return hr;
+}
+
+size_t RouteManager::routeCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_routes.size();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AudioRouter.h"
+#include "RouteConfig.h"
+#include "WorkerPool.h"
+
+// Status of one hosted route, as returned by RouteManager::getStatus().
+struct RouteStatusEntry {
+    std::string  name;
+    RouterStatus status;
+};
+
+// Hosts any number of independent routes in one process.
+//
+// Every route keeps its own device threads, but the non-realtime stages of
+// all routes share one WorkerPool, and status for all of them is read from
+// a single place. Routes are addressed by their (unique) name and can be
+// started and stopped individually.
+class RouteManager {
+public:
+    // 0 worker threads picks the pool default
+    explicit RouteManager(UINT32 workerThreads = 0,
+                          const RealtimePolicy& workerPolicy = RealtimePolicy());
+    ~RouteManager();
+
+    HRESULT addRoute(const RouteConfig& config);   // E_INVALIDARG on a duplicate name
+    HRESULT removeRoute(const std::string& name);  // stops the route first
+
+    HRESULT startRoute(const std::string& name);
+    HRESULT stopRoute(const std::string& name);
+
+    // Returns the number of routes that are running afterwards
+    size_t startAll();
+    void   stopAll();
+
+    std::vector<RouteStatusEntry> getStatus() const;
+    HRESULT getStatus(const std::string& name, RouterStatus& status) const;
+    // S_FALSE if the route has no analyzer frame (yet)
+    HRESULT getSpectrum(const std::string& name, SpectrumFrame& frame) const;
+
+    // Live changes to a running route (see AudioRouter). Output gain, mute
+    // and inserts are also kept in the route's config, so they survive a
+    // restart; the channel matrix starts from identity again.
+    HRESULT setOutputGain(const std::string& name, float gainDb);
+    HRESULT setMute(const std::string& name, bool mute);
+    HRESULT setMatrixGain(const std::string& name, UINT32 output, UINT32 input, float gain);
+    HRESULT setInsert(const std::string& name, UINT32 index, const DspStageConfig& stage);
+
+    size_t routeCount() const;
+    UINT32 workerThreadCount() const { return m_pool.threadCount(); }
+    RealtimeReport workerThreadReport() const { return m_pool.threadReport(); }
+
+    RouteManager(const RouteManager&) = delete;
+    RouteManager& operator=(const RouteManager&) = delete;
+
+private:
+    struct Route {
+        RouteConfig                  config;
+        std::unique_ptr<AudioRouter> router;
+        // Held across start(), stop() and removal of this route. Taken
+        // before m_mutex, never while holding it.
+        std::mutex                   control;
+        // start() or stop() is running without m_mutex: status and live
+        // changes leave the router alone (guarded by m_mutex)
+        bool                         starting = false;
+        bool                         stopping = false;
+        bool busy() const { return starting || stopping; }
+    };
+
+    Route* findRoute(const std::string& name);
+    const Route* findRoute(const std::string& name) const;
+    std::shared_ptr<Route> sharedRoute(const std::string& name) const;
+    HRESULT startRoute(Route& route);
+    void    stopRoute(Route& route);
+
+    // Declared first so it is destroyed after every router has stopped
+    WorkerPool m_pool;
+
+    // Guards the route list, configs and the starting/stopping flags; short holds only
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<Route>> m_routes;
+};
@@ -0,0 +1,429 @@
+#include "RtpEndpoint.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <random>
+
+static constexpr size_t   kHeaderBytes = 12;
+// Payload per packet: 5 ms of audio, kept well below a 1500 byte MTU
+static constexpr uint32_t kPacketMs = 5;
+static constexpr size_t   kSendPayloadBytes = 1200;
+// Packets between the receive thread and the capture thread
+static constexpr size_t   kQueuePackets = 256;
+// Jitter buffer slots; a packet further ahead than this restarts the stream
+static constexpr uint16_t kSlots = 256;
+// Smoothing of the buffer depth the drift correction acts on (per period)
+static constexpr double   kDepthSmoothing = 0.05;
+
+// ── Wire format ───────────────────────────────────────────────────
+
+static void storeBe16(uint8_t* p, uint16_t v) { p[0] = uint8_t(v >> 8); p[1] = uint8_t(v); }
+static void storeBe32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v);
+}
+static uint16_t loadBe16(const uint8_t* p) { return uint16_t((p[0] << 8) | p[1]); }
+static uint32_t loadBe32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// Little-endian host samples <-> network byte order (the swap is symmetric)
+static void swapSamples(uint8_t* dst, const uint8_t* src, size_t samples, uint32_t step) {
+    for (size_t i = 0; i < samples; ++i, dst += step, src += step)
+        for (uint32_t b = 0; b < step; ++b) dst[b] = src[step - 1 - b];
+}
+
+// Whole frames per packet for this format
+static uint32_t packetFramesFor(const AudioFormat& format, size_t maxPayload) {
+    uint32_t frames = (std::max)(format.sampleRate * kPacketMs / 1000, 1u);
+    uint32_t fit = static_cast<uint32_t>(maxPayload / format.blockAlign());
+    return (std::max)((std::min)(frames, fit), 1u);
+}
+
+// ── Render (sender) ───────────────────────────────────────────────
+
+RtpRender::~RtpRender() {
+    stop();
+}
+
+HRESULT RtpRender::init(const std::string& address, const AudioFormat& format, RingBuffer* ringBuffer,
+                        const AudioFormat* preferredFormat, const RtpOptions& options) {
+    if (format.isValid())
+        m_format = format;
+    else if (preferredFormat && preferredFormat->isValid())
+        m_format = *preferredFormat;
+    else
+        return E_INVALIDARG;
+    if (m_format.blockAlign() > kSendPayloadBytes) return E_INVALIDARG;
+
+    RETURN_IF_FAILED(m_socket.connect(address));
+
+    m_options = options;
+    m_packetFrames = packetFramesFor(m_format, kSendPayloadBytes);
+    const size_t packetBytes = kHeaderBytes + static_cast<size_t>(m_packetFrames) * m_format.blockAlign();
+    m_packet = ArenaVector<uint8_t>(packetBytes, 0, ArenaAllocator<uint8_t>(m_arena));
+    m_held = ArenaVector<uint8_t>(packetBytes, 0, ArenaAllocator<uint8_t>(m_arena));
+    m_heldBytes = 0;
+    m_fill = 0;
+    m_first = true;
+
+    // Random initial values, as RFC 3550 asks
+    std::random_device rd;
+    m_ssrc = rd();
+    m_seq = static_cast<uint16_t>(rd());
+    m_timestamp = rd();
+    m_random = m_ssrc | 1;
+
+    m_ringBuffer = ringBuffer;
+    initPeriod();
+    initPipeline();
+    return S_OK;
+}
+
+TransportStats RtpRender::transportStats() const {
+    TransportStats s;
+    s.transport = "rtp";
+    s.packets = m_sent.load(std::memory_order_relaxed);
+    s.lost = m_dropped.load(std::memory_order_relaxed);
+    s.reordered = m_reordered.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool RtpRender::chance(float percent) {
+    if (percent <= 0.0f) return false;
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return (m_random % 10000) < static_cast<uint32_t>(percent * 100.0f);
+}
+
+void RtpRender::consume(const uint8_t* data, uint32_t frames, bool silent) {
+    const uint32_t blockAlign = m_format.blockAlign();
+    const uint32_t step = bytesPerSample(m_format.type);
+
+    uint32_t done = 0;
+    while (done < frames) {
+        uint32_t n = (std::min)(frames - done, m_packetFrames - m_fill);
+        uint8_t* dst = m_packet.data() + kHeaderBytes + static_cast<size_t>(m_fill) * blockAlign;
+        if (silent)
+            std::memset(dst, 0, static_cast<size_t>(n) * blockAlign);
+        else
+            swapSamples(dst, data + static_cast<size_t>(done) * blockAlign,
+                        static_cast<size_t>(n) * m_format.channels, step);
+        m_fill += n;
+        done += n;
+        if (m_fill == m_packetFrames) sendPacket();
+    }
+}
+
+void RtpRender::sendPacket() {
+    uint8_t* h = m_packet.data();
+    h[0] = 0x80;                                        // V=2, no padding/extension/CSRC
+    h[1] = static_cast<uint8_t>((m_options.payloadType & 0x7f) | (m_first ? 0x80 : 0));
+    storeBe16(h + 2, m_seq);
+    storeBe32(h + 4, m_timestamp);
+    storeBe32(h + 8, m_ssrc);
+    const size_t bytes = m_packet.size();
+
+    ++m_seq;
+    m_timestamp += m_packetFrames;
+    m_fill = 0;
+    m_first = false;
+
+    if (chance(m_options.lossPercent)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (m_heldBytes == 0 && chance(m_options.reorderPercent)) {
+        // Goes out right after the next packet
+        std::memcpy(m_held.data(), h, bytes);
+        m_heldBytes = bytes;
+        m_reordered.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (m_socket.send(h, bytes) > 0) m_sent.fetch_add(1, std::memory_order_relaxed);
+    if (m_heldBytes) {
+        if (m_socket.send(m_held.data(), m_heldBytes) > 0) m_sent.fetch_add(1, std::memory_order_relaxed);
+        m_heldBytes = 0;
+    }
+}
+
+// ── Capture (receiver) ────────────────────────────────────────────
+
+RtpCapture::~RtpCapture() {
+    stop();
+}
+
+HRESULT RtpCapture::init(const std::string& address, const AudioFormat& format, RingBuffer* ringBuffer,
+                         const RtpOptions& options) {
+    if (!format.isValid() || format.blockAlign() > kMaxPayloadBytes) return E_INVALIDARG;
+
+    // Bind here, so that a port in use fails the route start
+    RETURN_IF_FAILED(m_socket.bind(address));
+
+    m_format = format;
+    m_options = options;
+    m_ringBuffer = ringBuffer;
+    m_queue = ArenaVector<Packet>(kQueuePackets, Packet(), ArenaAllocator<Packet>(m_arena));
+    m_slots = ArenaVector<Packet>(kSlots, Packet(), ArenaAllocator<Packet>(m_arena));
+    m_concealer.init(m_format, m_arena);
+
+    m_minFrames = static_cast<uint32_t>(static_cast<uint64_t>(m_format.sampleRate) * options.jitterMinMs / 1000);
+    m_maxFrames = static_cast<uint32_t>(static_cast<uint64_t>(m_format.sampleRate) * options.jitterMaxMs / 1000);
+    initPeriod();
+    // Arrivals are only looked at once per period, so a smaller target cannot be held
+    m_maxFrames = (std::max)({m_maxFrames, m_minFrames, m_bufferFrames});
+
+    initPipeline();
+    return S_OK;
+}
+
+HRESULT RtpCapture::start() {
+    if (m_running.load()) return S_FALSE;
+    if (!m_socket.isOpen()) return E_NOT_VALID_STATE;
+
+    m_queueHead.store(0, std::memory_order_relaxed);
+    m_queueTail.store(0, std::memory_order_relaxed);
+    for (auto& slot : m_slots) slot.valid = false;
+    m_concealer.reset();
+    m_started = false;
+    m_buffering = true;
+    m_emptyFrames = 0;
+    m_insertFrames = 0;
+    m_skipPending = false;
+    m_jitter = 0.0;
+    m_lateBoost = 0.0;
+    m_haveTransit = false;
+
+    m_receiving.store(true, std::memory_order_release);
+    m_receiveThread = std::thread(&RtpCapture::receiveLoop, this);
+    HRESULT hr = PacedCapture::start();
+    if (FAILED(hr)) {
+        m_receiving.store(false);
+        m_receiveThread.join();
+    }
+    return hr;
+}
+
+void RtpCapture::stop() {
+    PacedCapture::stop();
+    m_receiving.store(false, std::memory_order_release);
+    if (m_receiveThread.joinable()) m_receiveThread.join();
+}
+
+TransportStats RtpCapture::transportStats() const {
+    TransportStats s;
+    s.transport = "rtp";
+    s.packets = m_received.load(std::memory_order_relaxed);
+    s.lost = m_lost.load(std::memory_order_relaxed);
+    s.late = m_late.load(std::memory_order_relaxed);
+    s.skipped = m_skipped.load(std::memory_order_relaxed);
+    s.inserted = m_inserted.load(std::memory_order_relaxed);
+    s.jitterMs = m_jitterMs.load(std::memory_order_relaxed);
+    s.bufferMs = m_bufferMs.load(std::memory_order_relaxed);
+    s.targetMs = m_targetMs.load(std::memory_order_relaxed);
+    return s;
+}
+
+void RtpCapture::receiveLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto epoch = Clock::now();
+    const uint32_t blockAlign = m_format.blockAlign();
+    const uint32_t step = bytesPerSample(m_format.type);
+    uint8_t buf[2048];
+
+    while (m_receiving.load(std::memory_order_relaxed)) {
+        int n = m_socket.receive(buf, sizeof(buf), 50);
+        if (n <= 0) continue;
+        const double arrival = std::chrono::duration<double>(Clock::now() - epoch).count() * m_format.sampleRate;
+
+        // Header, CSRC list, extension and padding
+        size_t len = static_cast<size_t>(n);
+        if (len < kHeaderBytes || (buf[0] >> 6) != 2) continue;
+        size_t offset = kHeaderBytes + 4u * (buf[0] & 0x0f);
+        if ((buf[0] & 0x10) && offset + 4 <= len) offset += 4 + 4u * loadBe16(buf + offset + 2);
+        if ((buf[0] & 0x20) && len > 0) len -= (std::min)(len, static_cast<size_t>(buf[len - 1]));
+        if (offset >= len) continue;
+
+        // A payload that does not fit the configured format is dropped
+        const size_t payload = len - offset;
+        if (payload % blockAlign != 0 || payload > kMaxPayloadBytes) continue;
+
+        const size_t head = m_queueHead.load(std::memory_order_relaxed);
+        if (head - m_queueTail.load(std::memory_order_acquire) >= kQueuePackets) {
+            m_lost.fetch_add(1, std::memory_order_relaxed);     // capture thread stalled
+            continue;
+        }
+        Packet& p = m_queue[head % kQueuePackets];
+        p.seq = loadBe16(buf + 2);
+        p.timestamp = loadBe32(buf + 4);
+        p.ssrc = loadBe32(buf + 8);
+        p.frames = static_cast<uint32_t>(payload / blockAlign);
+        p.arrival = arrival;
+        swapSamples(p.payload, buf + offset, payload / step, step);
+        m_queueHead.store(head + 1, std::memory_order_release);
+    }
+}
+
+void RtpCapture::restart(const Packet& p) {
+    for (auto& slot : m_slots) slot.valid = false;
+    m_started = true;
+    m_buffering = true;
+    m_ssrc = p.ssrc;
+    m_playSeq = p.seq;
+    m_newestSeq = p.seq;
+    m_playOffset = 0;
+    m_packetFrames = p.frames;
+    m_emptyFrames = 0;
+    m_insertFrames = 0;
+    m_skipPending = false;
+    m_haveTransit = false;
+}
+
+void RtpCapture::accept(const Packet& p) {
+    if (!m_started || p.ssrc != m_ssrc) restart(p);
+
+    m_received.fetch_add(1, std::memory_order_relaxed);
+
+    // Interarrival jitter, RFC 3550 section 6.4.1
+    if (m_haveTransit) {
+        double d = (p.arrival - m_lastArrival) - static_cast<int32_t>(p.timestamp - m_lastTimestamp);
+        m_jitter += (std::fabs(d) - m_jitter) / 16.0;
+    }
+    m_lastArrival = p.arrival;
+    m_lastTimestamp = p.timestamp;
+    m_haveTransit = true;
+
+    Packet& slot = m_slots[p.seq % kSlots];
+    if (slot.valid && slot.seq == p.seq) return;    // duplicate
+
+    const int16_t ahead = static_cast<int16_t>(p.seq - m_playSeq);
+    if (ahead < 0 || (ahead == 0 && m_playOffset > 0)) {
+        // Its turn has passed; make room for the next one
+        m_late.fetch_add(1, std::memory_order_relaxed);
+        m_lateBoost = (std::min)(m_lateBoost + p.frames, static_cast<double>(m_maxFrames));
+        return;
+    }
+    if (ahead >= static_cast<int16_t>(kSlots)) {
+        restart(p);     // sequence jump: the sender restarted
+    }
+
+    std::memcpy(&slot, &p, offsetof(Packet, payload) + static_cast<size_t>(p.frames) * m_format.blockAlign());
+    slot.valid = true;
+
+    if (static_cast<int16_t>(p.seq - m_newestSeq) > 0) m_newestSeq = p.seq;
+    m_packetFrames = p.frames;
+}
+
+int32_t RtpCapture::depthFrames() const {
+    int32_t packets = static_cast<int16_t>(m_newestSeq - m_playSeq) + 1;
+    if (packets <= 0) return 0;
+    return packets * static_cast<int32_t>(m_packetFrames) - static_cast<int32_t>(m_playOffset);
+}
+
+void RtpCapture::updateTarget() {
+    // One packet plus four times the jitter covers nearly all arrivals;
+    // late packets push the target up until they stop
+    double target = m_packetFrames + 4.0 * m_jitter + m_lateBoost;
+    m_targetFrames = static_cast<uint32_t>(std::clamp(target, static_cast<double>(m_minFrames),
+                                                      static_cast<double>(m_maxFrames)));
+    m_lateBoost -= m_lateBoost / 256.0;
+}
+
+void RtpCapture::publishStats() {
+    const float msPerFrame = 1000.0f / m_format.sampleRate;
+    m_jitterMs.store(static_cast<float>(m_jitter) * msPerFrame, std::memory_order_relaxed);
+    m_bufferMs.store(m_started ? depthFrames() * msPerFrame : 0.0f, std::memory_order_relaxed);
+    m_targetMs.store(m_targetFrames * msPerFrame, std::memory_order_relaxed);
+}
+
+const uint8_t* RtpCapture::produce(uint32_t frames) {
+    // Take everything the receive thread has queued
+    size_t tail = m_queueTail.load(std::memory_order_relaxed);
+    const size_t head = m_queueHead.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) accept(m_queue[tail % kQueuePackets]);
+    m_queueTail.store(tail, std::memory_order_release);
+
+    if (m_started) updateTarget();
+    publishStats();
+
+    // The target is the slack left once this period has been played out
+    const int32_t depth = m_started ? depthFrames() - static_cast<int32_t>(frames) : 0;
+    if (!m_started || (m_buffering && depth < static_cast<int32_t>(m_targetFrames))) {
+        m_concealer.pushSilence();
+        return nullptr;
+    }
+    if (m_buffering) {
+        m_buffering = false;
+        m_avgDepth = depth;
+    }
+
+    // Drift: keep the averaged depth within a band around the target
+    m_avgDepth += (depth - m_avgDepth) * kDepthSmoothing;
+    const double margin = m_packetFrames + m_targetFrames / 4.0;
+    if (!m_skipPending && m_insertFrames == 0) {
+        if (m_avgDepth > m_targetFrames + margin) {
+            m_skipPending = true;
+            m_avgDepth -= m_packetFrames;
+        } else if (m_avgDepth < m_targetFrames - margin && depth > -static_cast<int32_t>(frames)) {
+            m_insertFrames = m_packetFrames;
+            m_inserted.fetch_add(1, std::memory_order_relaxed);
+            m_avgDepth += m_packetFrames;
+        }
+    }
+
+    uint8_t* out = periodBuffer();
+    const uint32_t blockAlign = m_format.blockAlign();
+    uint32_t done = 0;
+    while (done < frames) {
+        uint8_t* dst = out + static_cast<size_t>(done) * blockAlign;
+
+        if (m_playOffset == 0 && m_insertFrames > 0) {
+            uint32_t n = (std::min)(frames - done, m_insertFrames);
+            m_concealer.process(dst, 0, n);
+            m_insertFrames -= n;
+            done += n;
+            continue;
+        }
+
+        Packet& slot = m_slots[m_playSeq % kSlots];
+        const bool have = slot.valid && slot.seq == m_playSeq;
+
+        if (m_playOffset == 0 && m_skipPending && have) {
+            slot.valid = false;
+            ++m_playSeq;
+            m_skipPending = false;
+            m_skipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        const uint32_t packetFrames = have ? slot.frames : m_packetFrames;
+        const uint32_t n = (std::min)(frames - done, packetFrames - m_playOffset);
+        if (have) {
+            std::memcpy(dst, slot.payload + static_cast<size_t>(m_playOffset) * blockAlign,
+                        static_cast<size_t>(n) * blockAlign);
+            m_concealer.process(dst, n, n);
+        } else {
+            if (m_playOffset == 0) m_lost.fetch_add(1, std::memory_order_relaxed);
+            m_concealer.process(dst, 0, n);
+        }
+        done += n;
+        m_playOffset += n;
+        if (m_playOffset >= packetFrames) {
+            slot.valid = false;
+            ++m_playSeq;
+            m_playOffset = 0;
+        }
+    }
+
+    // Played past everything received: the stream stalled or stopped. After
+    // concealing for as long as the target, wait for it to start over.
+    if (static_cast<int16_t>(m_newestSeq - m_playSeq) < 0) {
+        m_emptyFrames += frames;
+        if (m_emptyFrames > m_targetFrames) m_started = false;
+    } else {
+        m_emptyFrames = 0;
+    }
+    return out;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include "PacedEndpoint.h"
+#include "UdpSocket.h"
+
+// RTP over UDP (RFC 3550) with linear PCM payloads in network byte order:
+// s16 as L16, s24 as L24, f32 as big-endian IEEE floats and s32 as L32.
+// Both sides must be configured with the same stream format; there is no
+// SDP exchange.
+
+// Send every rendered period as fixed-size RTP packets.
+//
+// The stream is continuous: silent periods are sent as zeros so that the
+// receiver's clock keeps running. Loss and reordering can be induced for
+// testing a receiver.
+class RtpRender : public PacedRender {
+public:
+    ~RtpRender() override;
+
+    HRESULT init(const std::string& address, const AudioFormat& format, RingBuffer* ringBuffer,
+                 const AudioFormat* preferredFormat, const RtpOptions& options);
+
+    TransportStats transportStats() const override;
+
+protected:
+    void consume(const uint8_t* data, uint32_t frames, bool silent) override;
+
+private:
+    void sendPacket();
+    bool chance(float percent);
+
+    UdpSocket            m_socket;
+    RtpOptions           m_options;
+    uint32_t             m_packetFrames = 0;
+    uint32_t             m_fill = 0;            // frames in m_packet so far
+    ArenaVector<uint8_t> m_packet;              // header + payload being assembled
+    ArenaVector<uint8_t> m_held;                // packet held back for reordering
+    size_t               m_heldBytes = 0;
+    uint16_t             m_seq = 0;
+    uint32_t             m_timestamp = 0;
+    uint32_t             m_ssrc = 0;
+    uint32_t             m_random = 1;          // xorshift state for the impairments
+    bool                 m_first = true;
+
+    std::atomic<UINT64>  m_sent{0};
+    std::atomic<UINT64>  m_dropped{0};
+    std::atomic<UINT64>  m_reordered{0};
+};
+
+// Receive an RTP stream through an adaptive jitter buffer.
+//
+// A receive thread parses packets into a lock-free queue. The paced capture
+// thread moves them into a sequence-indexed jitter buffer and plays it out:
+// missing packets are concealed, packets arriving after their turn are
+// counted as late and dropped. The buffer target follows the measured
+// interarrival jitter and grows after late packets. Sender/receiver clock
+// drift is absorbed at packet granularity: when the averaged depth leaves
+// the target band a packet is dropped or a concealed one inserted.
+class RtpCapture : public PacedCapture {
+public:
+    ~RtpCapture() override;
+
+    HRESULT init(const std::string& address, const AudioFormat& format, RingBuffer* ringBuffer,
+                 const RtpOptions& options);
+    HRESULT start() override;
+    void    stop() override;
+
+    TransportStats transportStats() const override;
+
+protected:
+    const uint8_t* produce(uint32_t frames) override;
+
+private:
+    static constexpr size_t kMaxPayloadBytes = 1460;
+
+    struct Packet {
+        bool     valid = false;
+        uint16_t seq = 0;
+        uint32_t timestamp = 0;
+        uint32_t ssrc = 0;
+        uint32_t frames = 0;
+        double   arrival = 0.0;     // receive time in frames
+        uint8_t  payload[kMaxPayloadBytes] = {};
+    };
+
+    void receiveLoop();
+    void accept(const Packet& p);
+    void restart(const Packet& p);
+    int32_t depthFrames() const;
+    void updateTarget();
+    void publishStats();
+
+    UdpSocket            m_socket;
+    RtpOptions           m_options;
+    std::thread          m_receiveThread;
+    std::atomic<bool>    m_receiving{false};
+
+    // Receive thread → capture thread
+    ArenaVector<Packet>  m_queue;
+    alignas(64) std::atomic<size_t> m_queueHead{0};
+    alignas(64) std::atomic<size_t> m_queueTail{0};
+
+    // Jitter buffer, capture thread only
+    ArenaVector<Packet>  m_slots;
+    PacketConcealer      m_concealer;
+    bool                 m_started = false;     // anchored on a stream
+    bool                 m_buffering = true;    // filling up to the target
+    uint32_t             m_ssrc = 0;
+    uint16_t             m_playSeq = 0;
+    uint16_t             m_newestSeq = 0;
+    uint32_t             m_playOffset = 0;      // frames played of m_playSeq
+    uint32_t             m_packetFrames = 0;    // size of the latest packet
+    uint32_t             m_targetFrames = 0;
+    uint32_t             m_minFrames = 0;
+    uint32_t             m_maxFrames = 0;
+    uint32_t             m_emptyFrames = 0;     // played with nothing buffered
+    uint32_t             m_insertFrames = 0;    // concealment still to insert
+    bool                 m_skipPending = false;
+    double               m_avgDepth = 0.0;
+    double               m_jitter = 0.0;        // frames
+    double               m_lateBoost = 0.0;     // frames
+    double               m_lastArrival = 0.0;
+    uint32_t             m_lastTimestamp = 0;
+    bool                 m_haveTransit = false;
+
+    std::atomic<UINT64>  m_received{0};
+    std::atomic<UINT64>  m_lost{0};
+    std::atomic<UINT64>  m_late{0};
+    std::atomic<UINT64>  m_skipped{0};
+    std::atomic<UINT64>  m_inserted{0};
+    std::atomic<float>   m_jitterMs{0.0f};
+    std::atomic<float>   m_bufferMs{0.0f};
+    std::atomic<float>   m_targetMs{0.0f};
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmreg.h>
+#include <ks.h>
+#include <ksmedia.h>
+#endif
+
+// Sample encodings that appear on the endpoints we support.
+// Int24 is packed 3-byte PCM; 24-bit audio in a 32-bit container
+// (as negotiated in exclusive mode) is left-justified and handled as Int32.
+enum class SampleType : uint8_t {
+    Unknown,
+    Int16,
+    Int24,
+    Int32,
+    Float32
+};
+
+// Platform-neutral description of an interleaved PCM stream.
+struct AudioFormat {
+    uint32_t   sampleRate    = 0;
+    uint16_t   channels      = 0;
+    uint16_t   bitsPerSample = 0;   // container size
+    uint16_t   validBits     = 0;
+    SampleType type          = SampleType::Unknown;
+
+    uint32_t blockAlign() const { return static_cast<uint32_t>(channels) * bitsPerSample / 8; }
+    bool     isValid()    const { return sampleRate > 0 && channels > 0 && type != SampleType::Unknown; }
+
+    bool operator==(const AudioFormat& o) const {
+        return sampleRate == o.sampleRate && channels == o.channels &&
+               bitsPerSample == o.bitsPerSample && validBits == o.validBits &&
+               type == o.type;
+    }
+    bool operator!=(const AudioFormat& o) const { return !(*this == o); }
+};
+
+inline uint32_t bytesPerSample(SampleType t) {
+    switch (t) {
+        case SampleType::Int16:   return 2;
+        case SampleType::Int24:   return 3;
+        case SampleType::Int32:   return 4;
+        case SampleType::Float32: return 4;
+        default:                  return 0;
+    }
+}
+
+inline AudioFormat makeAudioFormat(uint32_t sampleRate, uint16_t channels, SampleType type) {
+    AudioFormat f;
+    f.sampleRate    = sampleRate;
+    f.channels      = channels;
+    f.bitsPerSample = static_cast<uint16_t>(bytesPerSample(type) * 8);
+    f.validBits     = f.bitsPerSample;
+    f.type          = type;
+    return f;
+}
+
+// ── Scalar sample access ──────────────────────────────────────────
+// Full scale maps to [-1.0, 1.0). Stores clamp to the target range.
+
+inline float loadSample(SampleType t, const uint8_t* p) {
+    switch (t) {
+        case SampleType::Int16: {
+            int16_t v; std::memcpy(&v, p, 2);
+            return v * (1.0f / 32768.0f);
+        }
+        case SampleType::Int24: {
+            int32_t v = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+                                             (static_cast<uint32_t>(p[1]) << 16) |
+                                             (static_cast<uint32_t>(p[2]) << 24));
+            return static_cast<float>(v) * (1.0f / 2147483648.0f);
+        }
+        case SampleType::Int32: {
+            int32_t v; std::memcpy(&v, p, 4);
+            return static_cast<float>(v) * (1.0f / 2147483648.0f);
+        }
+        case SampleType::Float32: {
+            float v; std::memcpy(&v, p, 4);
+            return v;
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+inline void storeSample(SampleType t, uint8_t* p, float v) {
+    if (v > 1.0f)  v = 1.0f;
+    if (v < -1.0f) v = -1.0f;
+    switch (t) {
+        case SampleType::Int16: {
+            float s = v * 32768.0f;
+            int16_t i = (s >= 32767.0f) ? 32767 : static_cast<int16_t>(s);
+            std::memcpy(p, &i, 2);
+            break;
+        }
+        case SampleType::Int24: {
+            double s = static_cast<double>(v) * 2147483648.0;
+            int32_t i = (s >= 2147483647.0) ? 2147483647 : static_cast<int32_t>(s);
+            uint32_t u = static_cast<uint32_t>(i);
+            p[0] = static_cast<uint8_t>(u >> 8);
+            p[1] = static_cast<uint8_t>(u >> 16);
+            p[2] = static_cast<uint8_t>(u >> 24);
+            break;
+        }
+        case SampleType::Int32: {
+            double s = static_cast<double>(v) * 2147483648.0;
+            int32_t i = (s >= 2147483647.0) ? 2147483647 : static_cast<int32_t>(s);
+            std::memcpy(p, &i, 4);
+            break;
+        }
+        case SampleType::Float32:
+            std::memcpy(p, &v, 4);
+            break;
+        default:
+            break;
+    }
+}
+
+// ── Block conversion ──────────────────────────────────────────────
+
+inline void samplesToFloat(SampleType t, const uint8_t* src, float* dst, size_t samples) {
+    const uint32_t step = bytesPerSample(t);
+    if (t == SampleType::Float32) {
+        std::memcpy(dst, src, samples * sizeof(float));
+        return;
+    }
+    for (size_t i = 0; i < samples; ++i)
+        dst[i] = loadSample(t, src + i * step);
+}
+
+inline void samplesFromFloat(SampleType t, const float* src, uint8_t* dst, size_t samples) {
+    const uint32_t step = bytesPerSample(t);
+    for (size_t i = 0; i < samples; ++i)
+        storeSample(t, dst + i * step, src[i]);
+}
+
+#ifdef _WIN32
+// Derive the portable description from a WASAPI/MF wave format.
+inline AudioFormat audioFormatFromWave(const WAVEFORMATEX* wfx) {
+    AudioFormat f;
+    f.sampleRate    = wfx->nSamplesPerSec;
+    f.channels      = wfx->nChannels;
+    f.bitsPerSample = wfx->wBitsPerSample;
+    f.validBits     = wfx->wBitsPerSample;
+
+    bool isFloat = (wfx->wFormatTag == WAVE_FORMAT_IEEE_FLOAT);
+    if (wfx->wFormatTag == WAVE_FORMAT_EXTENSIBLE && wfx->cbSize >= 22) {
+        auto* wfxe = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(wfx);
+        isFloat = IsEqualGUID(wfxe->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) != FALSE;
+        if (wfxe->Samples.wValidBitsPerSample)
+            f.validBits = wfxe->Samples.wValidBitsPerSample;
+    }
+
+    if (isFloat && wfx->wBitsPerSample == 32) f.type = SampleType::Float32;
+    else if (wfx->wBitsPerSample == 16)       f.type = SampleType::Int16;
+    else if (wfx->wBitsPerSample == 24)       f.type = SampleType::Int24;
+    else if (wfx->wBitsPerSample == 32)       f.type = SampleType::Int32;
+    return f;
+}
+
+inline WAVEFORMATEXTENSIBLE waveFormatFromAudio(const AudioFormat& f) {
+    WAVEFORMATEXTENSIBLE wfx = {};
+    wfx.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    wfx.Format.nChannels = f.channels;
+    wfx.Format.nSamplesPerSec = f.sampleRate;
+    wfx.Format.wBitsPerSample = f.bitsPerSample;
+    wfx.Format.nBlockAlign = static_cast<WORD>(f.blockAlign());
+    wfx.Format.nAvgBytesPerSec = f.sampleRate * f.blockAlign();
+    wfx.Format.cbSize = 22;
+    wfx.Samples.wValidBitsPerSample = f.validBits;
+    wfx.SubFormat = (f.type == SampleType::Float32) ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+                                                    : KSDATAFORMAT_SUBTYPE_PCM;
+    if (f.channels == 1) wfx.dwChannelMask = SPEAKER_FRONT_CENTER;
+    else if (f.channels == 2) wfx.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+    return wfx;
+}
+#endif
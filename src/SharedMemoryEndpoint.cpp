@@ -0,0 +1,168 @@
+#include "SharedMemoryEndpoint.h"
+#include "RealtimeCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Poll interval of both directions
+static constexpr UINT32 kPollMicros = 250;
+// Largest block handed on at once
+static constexpr UINT32 kChunkMs = 10;
+
+static UINT32 framesForMs(const AudioFormat& format, UINT32 ms) {
+    return (std::max)(static_cast<UINT32>(static_cast<uint64_t>(format.sampleRate) * ms / 1000), 1u);
+}
+
+static void pollWait() {
+    std::this_thread::sleep_for(std::chrono::microseconds(kPollMicros));
+}
+
+// ── Capture ───────────────────────────────────────────────────────
+
+SharedMemoryCapture::~SharedMemoryCapture() {
+    stop();
+}
+
+HRESULT SharedMemoryCapture::init(const std::string& name, const AudioFormat& format, UINT32 bufferMs,
+                                  RingBuffer* ringBuffer) {
+    if (!format.isValid()) return E_INVALIDARG;
+    RETURN_IF_FAILED(m_shared.open(name, format, framesForMs(format, bufferMs), true));
+
+    m_format = m_shared.format();
+    m_bufferFrames = framesForMs(m_format, kChunkMs);
+    m_ringBuffer = ringBuffer;
+    initPipeline();
+    return S_OK;
+}
+
+HRESULT SharedMemoryCapture::start() {
+    if (m_running.load()) return S_FALSE;
+    if (!m_shared.isOpen() || !m_ringBuffer) return E_NOT_VALID_STATE;
+
+    // Whatever the writer left while nobody was reading is stale by now
+    m_shared.discard();
+    m_threadReport.clear();
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&SharedMemoryCapture::loop, this);
+    return S_OK;
+}
+
+void SharedMemoryCapture::stop() {
+    if (!m_running.load()) return;
+
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) m_thread.join();
+}
+
+TransportStats SharedMemoryCapture::transportStats() const {
+    TransportStats s;
+    if (!m_shared.isOpen()) return s;
+    s.transport = "shm";
+    s.position = m_shared.writeFrames();
+    s.bufferMs = 1000.0f * m_shared.fill() / m_format.blockAlign() / m_format.sampleRate;
+    return s;
+}
+
+void SharedMemoryCapture::loop() {
+    RealtimeThreadScope rt(m_rtPolicy, ThreadRole::Device);
+    m_threadReport.publish(rt.report());
+
+    const uint32_t blockAlign = m_format.blockAlign();
+    while (m_running.load(std::memory_order_relaxed)) {
+        size_t bytes = 0;
+        const uint8_t* data = m_shared.readRegion(bytes);
+        const uint32_t frames = (std::min)(static_cast<uint32_t>(bytes / blockAlign), m_bufferFrames);
+        if (frames == 0) {
+            pollWait();
+            continue;
+        }
+
+        RealtimeSection section("capture");
+        deliver(data, frames);
+        m_shared.commitRead(static_cast<size_t>(frames) * blockAlign);
+    }
+}
+
+// ── Render ────────────────────────────────────────────────────────
+
+SharedMemoryRender::~SharedMemoryRender() {
+    stop();
+}
+
+HRESULT SharedMemoryRender::init(const std::string& name, const AudioFormat& format, UINT32 bufferMs,
+                                 RingBuffer* ringBuffer, const AudioFormat* preferredFormat) {
+    if (format.isValid())
+        m_format = format;
+    else if (preferredFormat && preferredFormat->isValid())
+        m_format = *preferredFormat;
+    else
+        return E_INVALIDARG;
+
+    RETURN_IF_FAILED(m_shared.open(name, m_format, framesForMs(m_format, bufferMs), false));
+
+    m_bufferFrames = framesForMs(m_format, kChunkMs);
+    m_ringBuffer = ringBuffer;
+    initPipeline();
+    return S_OK;
+}
+
+HRESULT SharedMemoryRender::start() {
+    if (m_running.load()) return S_FALSE;
+    if (!m_shared.isOpen() || !m_ringBuffer) return E_NOT_VALID_STATE;
+
+    resetPipeline();
+    m_droppedFrames.store(0, std::memory_order_relaxed);
+    m_threadReport.clear();
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&SharedMemoryRender::loop, this);
+    return S_OK;
+}
+
+void SharedMemoryRender::stop() {
+    if (!m_running.load()) return;
+
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) m_thread.join();
+}
+
+TransportStats SharedMemoryRender::transportStats() const {
+    TransportStats s;
+    if (!m_shared.isOpen()) return s;
+    s.transport = "shm";
+    s.position = m_shared.writeFrames();
+    s.bufferMs = 1000.0f * m_shared.fill() / m_format.blockAlign() / m_format.sampleRate;
+    s.droppedFrames = m_droppedFrames.load(std::memory_order_relaxed);
+    return s;
+}
+
+void SharedMemoryRender::loop() {
+    RealtimeThreadScope rt(m_rtPolicy, ThreadRole::Device);
+    m_threadReport.publish(rt.report());
+
+    const uint32_t blockAlign = m_format.blockAlign();
+    while (m_running.load(std::memory_order_relaxed)) {
+        size_t space = 0;
+        uint8_t* target = m_shared.writeRegion(space);
+
+        // Only what is queued: the reader is the clock, so nothing is concealed.
+        // At the end of a finite stream pull() marks the endpoint drained.
+        const uint32_t queued = static_cast<uint32_t>(
+            (std::min)(m_ringBuffer->availableToRead() / blockAlign, static_cast<size_t>(m_bufferFrames)));
+        if (queued == 0) {
+            if (m_ringBuffer->ended()) pull(target, 0);
+            pollWait();
+            continue;
+        }
+
+        RealtimeSection section("render");
+        const uint32_t frames = (std::min)(queued, static_cast<uint32_t>(space / blockAlign));
+        if (frames == 0) {
+            // Ring full: the reader is not keeping up
+            discardQueued(static_cast<size_t>(queued) * blockAlign);
+            m_droppedFrames.fetch_add(queued, std::memory_order_relaxed);
+            continue;
+        }
+        if (pull(target, frames)) std::memset(target, 0, static_cast<size_t>(frames) * blockAlign);
+        m_shared.commitWrite(static_cast<size_t>(frames) * blockAlign);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include "AudioEndpoint.h"
+#include "SharedRing.h"
+
+// Virtual cable to another process through a named shared-memory ring.
+//
+// There is no device clock on this side: the other process sets the pace.
+// Each endpoint's thread polls its rings every kPollMicros and hands over
+// whatever whole frames are there, straight from or into the shared
+// segment, so audio crosses within a fraction of a millisecond.
+
+// Read what another process writes into the ring. The segment's format
+// wins over the configured one; data queued before start() is skipped.
+class SharedMemoryCapture : public CaptureEndpoint {
+public:
+    ~SharedMemoryCapture() override;
+
+    HRESULT init(const std::string& name, const AudioFormat& format, UINT32 bufferMs,
+                 RingBuffer* ringBuffer);
+    HRESULT start() override;
+    void    stop() override;
+
+    TransportStats transportStats() const override;
+    // The other process sets the pace
+    double periodMs() const override { return 0.0; }
+
+private:
+    void loop();
+
+    SharedRing  m_shared;
+    std::thread m_thread;
+};
+
+// Write the route's audio into the ring for another process to read. When
+// the reader falls behind (or none is attached) and the ring is full, new
+// audio is dropped and counted.
+class SharedMemoryRender : public RenderEndpoint {
+public:
+    ~SharedMemoryRender() override;
+
+    HRESULT init(const std::string& name, const AudioFormat& format, UINT32 bufferMs,
+                 RingBuffer* ringBuffer, const AudioFormat* preferredFormat = nullptr);
+    HRESULT start() override;
+    void    stop() override;
+
+    TransportStats transportStats() const override;
+    // The other process sets the pace
+    double periodMs() const override { return 0.0; }
+
+private:
+    void loop();
+
+    SharedRing          m_shared;
+    std::thread         m_thread;
+    std::atomic<UINT64> m_droppedFrames{0};
+};
@@ -0,0 +1,217 @@
+#include "SharedRing.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A segment found half-initialised is given this long to complete
+static constexpr auto kAttachTimeout = std::chrono::seconds(1);
+
+static void fillHeader(SharedRingHeader* h, const AudioFormat& format, uint64_t capacityBytes) {
+    h->version = kSharedRingVersion;
+    h->headerBytes = kSharedRingHeaderBytes;
+    h->sampleRate = format.sampleRate;
+    h->channels = format.channels;
+    h->bitsPerSample = format.bitsPerSample;
+    h->validBits = format.validBits;
+    h->isFloat = (format.type == SampleType::Float32) ? 1 : 0;
+    h->capacityBytes = capacityBytes;
+    h->writePos.store(0, std::memory_order_relaxed);
+    h->readPos.store(0, std::memory_order_relaxed);
+    h->magic.store(kSharedRingMagic, std::memory_order_release);
+}
+
+static bool headerFormat(const SharedRingHeader* h, AudioFormat& format) {
+    SampleType type = SampleType::Unknown;
+    if (h->isFloat)                    type = (h->bitsPerSample == 32) ? SampleType::Float32 : SampleType::Unknown;
+    else if (h->bitsPerSample == 16)   type = SampleType::Int16;
+    else if (h->bitsPerSample == 24)   type = SampleType::Int24;
+    else if (h->bitsPerSample == 32)   type = SampleType::Int32;
+
+    format = makeAudioFormat(h->sampleRate, h->channels, type);
+    if (type == SampleType::Int32 && h->validBits) format.validBits = h->validBits;
+    return format.isValid();
+}
+
+static bool waitForMagic(const SharedRingHeader* h) {
+    const auto deadline = std::chrono::steady_clock::now() + kAttachTimeout;
+    while (h->magic.load(std::memory_order_acquire) != kSharedRingMagic) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+HRESULT SharedRing::mapSegment(const std::string& name, uint64_t bytes, bool& created) {
+    const std::wstring objectName = L"Local\\AudioBridge." + utf8ToWide(name);
+    m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                   static_cast<DWORD>(bytes >> 32), static_cast<DWORD>(bytes),
+                                   objectName.c_str());
+    if (!m_mapping) return HRESULT_FROM_WIN32(GetLastError());
+    created = (GetLastError() != ERROR_ALREADY_EXISTS);
+
+    // An existing segment keeps the size it was created with
+    void* view = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!view) return HRESULT_FROM_WIN32(GetLastError());
+    MEMORY_BASIC_INFORMATION info = {};
+    VirtualQuery(view, &info, sizeof(info));
+    m_mappedBytes = info.RegionSize;
+    m_header = static_cast<SharedRingHeader*>(view);
+    return S_OK;
+}
+
+void SharedRing::unmap() {
+    if (m_header) UnmapViewOfFile(m_header);
+    m_header = nullptr;
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+#else
+
+static HRESULT errnoResult() {
+    switch (errno) {
+        case ENOENT: case EACCES: case EPERM: return E_ACCESSDENIED;
+        case ENOMEM: case ENOSPC:             return E_OUTOFMEMORY;
+        default:                              return E_FAIL;
+    }
+}
+
+HRESULT SharedRing::mapSegment(const std::string& name, uint64_t bytes, bool& created) {
+    if (name.find('/') != std::string::npos) return E_INVALIDARG;
+    const std::string objectName = "/audiobridge." + name;
+
+    created = true;
+    int fd = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(objectName.c_str(), O_RDWR, 0);
+    }
+    if (fd < 0) return errnoResult();
+
+    struct stat st = {};
+    if (created) {
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            HRESULT hr = errnoResult();
+            ::close(fd);
+            shm_unlink(objectName.c_str());
+            return hr;
+        }
+    } else {
+        // The creator may not have sized it yet
+        const auto deadline = std::chrono::steady_clock::now() + kAttachTimeout;
+        while (fstat(fd, &st) == 0 && st.st_size < static_cast<off_t>(kSharedRingHeaderBytes) &&
+               std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kSharedRingHeaderBytes)) {
+        ::close(fd);
+        return E_NOT_VALID_STATE;
+    }
+
+    m_mappedBytes = static_cast<size_t>(st.st_size);
+    void* view = mmap(nullptr, m_mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return errnoResult();
+    m_header = static_cast<SharedRingHeader*>(view);
+    return S_OK;
+}
+
+void SharedRing::unmap() {
+    if (m_header) munmap(m_header, m_mappedBytes);
+    m_header = nullptr;
+}
+
+#endif
+
+HRESULT SharedRing::open(const std::string& name, const AudioFormat& format, uint32_t capacityFrames,
+                         bool adoptFormat) {
+    close();
+    if (name.empty() || !format.isValid() || capacityFrames == 0) return E_INVALIDARG;
+
+    const uint64_t capacity = static_cast<uint64_t>(capacityFrames) * format.blockAlign();
+    bool created = false;
+    HRESULT hr = mapSegment(name, kSharedRingHeaderBytes + capacity, created);
+    if (FAILED(hr)) {
+        close();
+        return hr;
+    }
+    if (created) fillHeader(m_header, format, capacity);
+
+    // From here on the segment may have been created by another process
+    if (!waitForMagic(m_header) || m_header->version != kSharedRingVersion ||
+        m_header->headerBytes < sizeof(SharedRingHeader) ||
+        m_header->headerBytes + m_header->capacityBytes > m_mappedBytes ||
+        !headerFormat(m_header, m_format) || m_header->capacityBytes % m_format.blockAlign() != 0) {
+        close();
+        return E_NOT_VALID_STATE;
+    }
+    if (!adoptFormat && m_format != format) {
+        close();
+        return E_INVALIDARG;
+    }
+
+    m_data = reinterpret_cast<uint8_t*>(m_header) + m_header->headerBytes;
+    m_capacity = m_header->capacityBytes;
+    return S_OK;
+}
+
+void SharedRing::close() {
+    // The segment itself stays for the other side, or the next run
+    unmap();
+    m_data = nullptr;
+    m_capacity = 0;
+    m_mappedBytes = 0;
+}
+
+uint8_t* SharedRing::writeRegion(size_t& bytes) const {
+    const uint64_t w = m_header->writePos.load(std::memory_order_relaxed);
+    const uint64_t r = m_header->readPos.load(std::memory_order_acquire);
+    const uint64_t offset = w % m_capacity;
+    const uint64_t free = m_capacity - (w - r);
+    bytes = static_cast<size_t>((std::min)(free, m_capacity - offset));
+    return m_data + offset;
+}
+
+void SharedRing::commitWrite(size_t bytes) {
+    const uint64_t w = m_header->writePos.load(std::memory_order_relaxed);
+    m_header->writePos.store(w + bytes, std::memory_order_release);
+}
+
+const uint8_t* SharedRing::readRegion(size_t& bytes) const {
+    const uint64_t r = m_header->readPos.load(std::memory_order_relaxed);
+    const uint64_t w = m_header->writePos.load(std::memory_order_acquire);
+    const uint64_t offset = r % m_capacity;
+    bytes = static_cast<size_t>((std::min)(w - r, m_capacity - offset));
+    return m_data + offset;
+}
+
+void SharedRing::commitRead(size_t bytes) {
+    const uint64_t r = m_header->readPos.load(std::memory_order_relaxed);
+    m_header->readPos.store(r + bytes, std::memory_order_release);
+}
+
+void SharedRing::discard() {
+    m_header->readPos.store(m_header->writePos.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+uint64_t SharedRing::fill() const {
+    const uint64_t r = m_header->readPos.load(std::memory_order_acquire);
+    const uint64_t w = m_header->writePos.load(std::memory_order_acquire);
+    return w >= r ? w - r : 0;
+}
+
+uint64_t SharedRing::writeFrames() const {
+    return m_header->writePos.load(std::memory_order_acquire) / m_format.blockAlign();
+}
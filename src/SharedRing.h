@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Platform.h"
+#include "SampleFormat.h"
+
+// Layout of a shared-memory ring segment, version 1.
+//
+// The segment is the header followed by capacityBytes of sample data.
+// Positions are byte counts since the segment was created and only ever
+// grow, so the fill level is writePos - readPos and writePos / blockAlign is
+// the producer's sample position. Both move in whole frames. Other
+// processes attach to the same segment and follow the same rules: the
+// producer writes data, then publishes writePos (release); the consumer
+// reads writePos (acquire), the data, then publishes readPos.
+struct SharedRingHeader {
+    std::atomic<uint32_t> magic;        // kSharedRingMagic once the fields below are valid
+    uint32_t              version;
+    uint32_t              headerBytes;  // offset of the sample data
+    uint32_t              sampleRate;
+    uint16_t              channels;
+    uint16_t              bitsPerSample;    // container size: 16, 24 or 32
+    uint16_t              validBits;
+    uint16_t              isFloat;          // 1 = IEEE float samples
+    uint64_t              capacityBytes;    // whole frames
+    alignas(64) std::atomic<uint64_t> writePos;
+    alignas(64) std::atomic<uint64_t> readPos;
+};
+
+static constexpr uint32_t kSharedRingMagic = 0x43564241;   // "ABVC"
+static constexpr uint32_t kSharedRingVersion = 1;
+static constexpr uint32_t kSharedRingHeaderBytes = 192;
+
+// The layout is shared with other programs and must not move
+static_assert(sizeof(SharedRingHeader) <= kSharedRingHeaderBytes, "header outgrew its space");
+static_assert(offsetof(SharedRingHeader, capacityBytes) == 24 &&
+              offsetof(SharedRingHeader, writePos) == 64 &&
+              offsetof(SharedRingHeader, readPos) == 128, "shared header layout changed");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared positions must be lock-free");
+
+// A named lock-free SPSC ring in shared memory (the "virtual cable").
+//
+// One process writes, another reads; neither blocks. The segment is named
+// "Local\AudioBridge.<name>" on Windows and "/audiobridge.<name>" (POSIX
+// shared memory) elsewhere. Whichever side comes first creates it.
+class SharedRing {
+public:
+    SharedRing() = default;
+    ~SharedRing() { close(); }
+
+    // Attach to segment 'name', creating it for 'format' with room for
+    // capacityFrames if it does not exist. An existing segment must carry
+    // the same format unless adoptFormat is set, in which case format()
+    // returns the segment's.
+    HRESULT open(const std::string& name, const AudioFormat& format, uint32_t capacityFrames,
+                 bool adoptFormat);
+    void    close();
+    bool    isOpen() const { return m_header != nullptr; }
+
+    const AudioFormat& format() const { return m_format; }
+    uint64_t capacityBytes() const { return m_capacity; }
+
+    // Producer: contiguous free space at the write position (whole frames),
+    // and publishing what was written there
+    uint8_t* writeRegion(size_t& bytes) const;
+    void     commitWrite(size_t bytes);
+
+    // Consumer: contiguous data at the read position, and releasing it
+    const uint8_t* readRegion(size_t& bytes) const;
+    void           commitRead(size_t bytes);
+    // Consumer: skip whatever is queued, e.g. left over from an earlier run
+    void           discard();
+
+    // Bytes queued; safe from any thread
+    uint64_t fill() const;
+    // Frames the producer has written since the segment was created
+    uint64_t writeFrames() const;
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+private:
+    // Platform part: map the named segment, creating it at 'bytes'
+    HRESULT mapSegment(const std::string& name, uint64_t bytes, bool& created);
+    void    unmap();
+
+    SharedRingHeader* m_header = nullptr;
+    uint8_t*          m_data = nullptr;
+    uint64_t          m_capacity = 0;
+    size_t            m_mappedBytes = 0;
+    AudioFormat       m_format;
+#ifdef _WIN32
+    HANDLE            m_mapping = nullptr;
+#endif
+};
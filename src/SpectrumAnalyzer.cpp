@@ -0,0 +1,323 @@
+#include "SpectrumAnalyzer.h"
+#include "LevelMeter.h"
+#include "RealtimeThread.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// How often the analyzer looks for a complete segment
+static constexpr auto kPollInterval = std::chrono::milliseconds(5);
+// Frames converted per step on the analyzer thread
+static constexpr uint32_t kChunkFrames = 1024;
+// Decimation filter length per unit of decimation
+static constexpr uint32_t kFirTapsPerStep = 16;
+// The side ring holds at least this much audio, and at least 3 segments
+static constexpr uint32_t kMinRingMs = 250;
+
+static const double kPi = 3.14159265358979323846;
+
+static void buildWindow(SpectrumWindow type, std::vector<float>& w) {
+    const size_t n = w.size();
+    for (size_t i = 0; i < n; ++i) {
+        const double x = 2.0 * kPi * static_cast<double>(i) / static_cast<double>(n);
+        double v;
+        switch (type) {
+            case SpectrumWindow::BlackmanHarris:
+                v = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2 * x) - 0.01168 * std::cos(3 * x);
+                break;
+            case SpectrumWindow::FlatTop:
+                v = 0.21557895 - 0.41663158 * std::cos(x) + 0.277263158 * std::cos(2 * x)
+                  - 0.083578947 * std::cos(3 * x) + 0.006947368 * std::cos(4 * x);
+                break;
+            default:
+                v = 0.5 - 0.5 * std::cos(x);
+                break;
+        }
+        w[i] = static_cast<float>(v);
+    }
+}
+
+// Windowed-sinc low-pass at 0.45 of the decimated Nyquist band, unity gain
+static void buildDecimationFilter(uint32_t decimation, std::vector<float>& taps) {
+    const uint32_t n = kFirTapsPerStep * decimation + 1;
+    const double fc = 0.45 / decimation;
+    const double center = (n - 1) / 2.0;
+    taps.resize(n);
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const double t = i - center;
+        double h = t == 0.0 ? 2.0 * fc : std::sin(2.0 * kPi * fc * t) / (kPi * t);
+        const double x = 2.0 * kPi * i / (n - 1);
+        h *= 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2 * x);
+        taps[i] = static_cast<float>(h);
+        sum += h;
+    }
+    for (float& t : taps) t = static_cast<float>(t / sum);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    stop();
+}
+
+HRESULT SpectrumAnalyzer::start(const AudioFormat& format, const SpectrumOptions& options,
+                                AudioArena* arena) {
+    stop();
+    if (!format.isValid()) return E_INVALIDARG;
+    if (options.overlapPercent > 95 || options.updateHz < 1 || options.updateHz > 100 ||
+        options.averages < 1 || options.averages > 64 ||
+        options.decimation < 1 || options.decimation > 16)
+        return E_INVALIDARG;
+    if (!m_fft.init(options.fftSize)) return E_INVALIDARG;
+
+    m_format = format;
+    m_options = options;
+    m_blockAlign = format.blockAlign();
+
+    const uint32_t n = options.fftSize;
+    const uint32_t decimation = options.decimation;
+    m_hop = (std::max)(n * (100 - options.overlapPercent) / 100, 1u);
+
+    if (decimation > 1) {
+        buildDecimationFilter(decimation, m_firTaps);
+        m_firLine.assign(m_firTaps.size() * 2, 0.0f);
+    } else {
+        m_firTaps.clear();
+        m_firLine.clear();
+    }
+
+    // Only the end of each interval is analyzed, unless the segment needs
+    // all of it anyway
+    const uint64_t span = static_cast<uint64_t>(n) + static_cast<uint64_t>(options.averages - 1) * m_hop;
+    const uint64_t segment = span * decimation + m_firTaps.size();
+    m_intervalFrames = (std::max)(format.sampleRate / options.updateHz, 1u);
+    m_continuous = segment >= m_intervalFrames;
+    m_segmentFrames = m_continuous ? m_intervalFrames : static_cast<uint32_t>(segment);
+
+    const size_t segmentBytes = sizeof(SegmentHeader) + static_cast<size_t>(m_segmentFrames) * m_blockAlign;
+    const size_t minFrames = static_cast<size_t>(format.sampleRate) * kMinRingMs / 1000;
+    const size_t segments = (std::max)(static_cast<size_t>(3), (minFrames + m_segmentFrames - 1) / m_segmentFrames);
+    m_ring = std::make_unique<RingBuffer>(segments * segmentBytes + 1, arena);
+
+    m_raw.assign(static_cast<size_t>(kChunkFrames) * m_blockAlign, 0);
+    m_interleaved.assign(static_cast<size_t>(kChunkFrames) * format.channels, 0.0f);
+    m_history.assign(n, 0.0f);
+    m_window.resize(n);
+    buildWindow(options.window, m_window);
+    double windowSum = 0.0;
+    for (float w : m_window) windowSum += w;
+    m_scale = static_cast<float>(4.0 / (windowSum * windowSum));
+    m_fftIn.assign(n, 0.0f);
+    m_fftOut.assign(m_fft.bins(), std::complex<float>());
+    m_power.assign(m_fft.bins(), 0.0f);
+    m_averaged = 0;
+    m_lastSequence = 0;
+    resetHistory();
+    m_binHz = static_cast<float>(format.sampleRate) / decimation / n;
+
+    for (Slot& slot : m_slots) {
+        slot.sequence = 0;
+        slot.db.assign(m_fft.bins(), kMeterFloorDb);
+    }
+    m_back = 0;
+    m_middle.store(1);
+    m_front = 2;
+
+    m_phase = 0;
+    m_nextSequence = 1;
+    m_queueing = false;
+    m_published.store(0);
+    m_droppedSegments.store(0);
+    m_peakHz.store(0.0f);
+    m_peakDb.store(kMeterFloorDb);
+    m_running.store(true);
+    m_thread = std::thread(&SpectrumAnalyzer::analyzerLoop, this);
+    return S_OK;
+}
+
+void SpectrumAnalyzer::stop() {
+    if (m_thread.joinable()) {
+        m_running.store(false);
+        m_thread.join();
+    }
+    m_running.store(false);
+    m_ring.reset();
+}
+
+void SpectrumAnalyzer::tap(const uint8_t* data, uint32_t frames) {
+    const uint32_t skipFrames = m_intervalFrames - m_segmentFrames;
+    while (frames > 0) {
+        uint32_t n;
+        if (m_phase < skipFrames) {
+            n = (std::min)(frames, skipFrames - m_phase);
+        } else {
+            if (m_phase == skipFrames) {
+                // Space for the whole segment is claimed up front, so a
+                // segment is either queued complete or not at all
+                const size_t bytes = sizeof(SegmentHeader) + static_cast<size_t>(m_segmentFrames) * m_blockAlign;
+                m_queueing = m_ring->canWrite(bytes);
+                if (m_queueing) {
+                    SegmentHeader header{ m_nextSequence, m_segmentFrames };
+                    m_ring->write(&header, sizeof(header));
+                } else {
+                    m_droppedSegments.fetch_add(1, std::memory_order_relaxed);
+                }
+                ++m_nextSequence;
+            }
+            n = (std::min)(frames, m_intervalFrames - m_phase);
+            if (m_queueing) {
+                const size_t bytes = static_cast<size_t>(n) * m_blockAlign;
+                if (data) m_ring->write(data, bytes);
+                else      m_ring->writeSilence(bytes);
+            }
+        }
+
+        m_phase += n;
+        if (m_phase == m_intervalFrames) m_phase = 0;
+        if (data) data += static_cast<size_t>(n) * m_blockAlign;
+        frames -= n;
+    }
+}
+
+bool SpectrumAnalyzer::latest(SpectrumFrame& frame) const {
+    std::lock_guard<std::mutex> lock(m_readMutex);
+    if (m_middle.load(std::memory_order_acquire) & kFresh)
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & 3;
+
+    const Slot& slot = m_slots[m_front];
+    if (slot.sequence == 0) return false;
+    frame.sequence = slot.sequence;
+    frame.binHz = m_binHz;
+    frame.db = slot.db;
+    return true;
+}
+
+void SpectrumAnalyzer::analyzerLoop() {
+    lowerThreadPriority();
+    const size_t segmentBytes = sizeof(SegmentHeader) + static_cast<size_t>(m_segmentFrames) * m_blockAlign;
+
+    while (m_running.load()) {
+        // The tap has claimed the space for the whole segment; wait until
+        // all of it has arrived
+        if (m_ring->availableToRead() < segmentBytes) {
+            std::this_thread::sleep_for(kPollInterval);
+            continue;
+        }
+        SegmentHeader header;
+        m_ring->read(&header, sizeof(header));
+        processSegment(header);
+    }
+}
+
+void SpectrumAnalyzer::processSegment(const SegmentHeader& header) {
+    if (!m_continuous || header.sequence != m_lastSequence + 1) resetHistory();
+    m_lastSequence = header.sequence;
+
+    const uint32_t channels = m_format.channels;
+    const float mix = 1.0f / static_cast<float>(channels);
+    uint32_t remaining = header.frames;
+    while (remaining > 0) {
+        const uint32_t n = (std::min)(remaining, kChunkFrames);
+        m_ring->read(m_raw.data(), static_cast<size_t>(n) * m_blockAlign);
+        samplesToFloat(m_format.type, m_raw.data(), m_interleaved.data(), static_cast<size_t>(n) * channels);
+
+        const float* p = m_interleaved.data();
+        for (uint32_t f = 0; f < n; ++f, p += channels) {
+            float sum = 0.0f;
+            for (uint32_t c = 0; c < channels; ++c) sum += p[c];
+            pushSample(sum * mix);
+        }
+        remaining -= n;
+    }
+
+    if (m_averaged > 0) publish();
+}
+
+void SpectrumAnalyzer::resetHistory() {
+    std::fill(m_firLine.begin(), m_firLine.end(), 0.0f);
+    m_firPos = 0;
+    m_firFill = 0;
+    m_decimPhase = 0;
+    m_historyPos = 0;
+    m_historyFill = 0;
+    // The first FFT runs as soon as the history is full
+    m_sinceFft = m_hop;
+}
+
+void SpectrumAnalyzer::pushSample(float x) {
+    if (m_firTaps.empty()) {
+        addToHistory(x);
+        return;
+    }
+
+    const uint32_t taps = static_cast<uint32_t>(m_firTaps.size());
+    m_firLine[m_firPos] = x;
+    m_firLine[m_firPos + taps] = x;
+    if (++m_firPos == taps) m_firPos = 0;
+    if (m_firFill < taps) ++m_firFill;
+
+    if (++m_decimPhase < m_options.decimation) return;
+    m_decimPhase = 0;
+    // Until the filter has a full delay line its output is a start-up transient
+    if (m_firFill < taps) return;
+
+    // The last 'taps' inputs, oldest first; the filter is symmetric
+    const float* line = m_firLine.data() + m_firPos;
+    float acc = 0.0f;
+    for (uint32_t t = 0; t < taps; ++t) acc += line[t] * m_firTaps[t];
+    addToHistory(acc);
+}
+
+void SpectrumAnalyzer::addToHistory(float x) {
+    const uint32_t n = m_options.fftSize;
+    m_history[m_historyPos] = x;
+    m_historyPos = (m_historyPos + 1) & (n - 1);
+    if (m_historyFill < n) ++m_historyFill;
+    ++m_sinceFft;
+    if (m_historyFill == n && m_sinceFft >= m_hop) runFft();
+}
+
+void SpectrumAnalyzer::runFft() {
+    const uint32_t n = m_options.fftSize;
+    // m_historyPos is the oldest sample
+    for (uint32_t i = 0; i < n; ++i)
+        m_fftIn[i] = m_history[(m_historyPos + i) & (n - 1)] * m_window[i];
+    m_fft.forward(m_fftIn.data(), m_fftOut.data());
+
+    const size_t bins = m_fftOut.size();
+    for (size_t k = 0; k < bins; ++k) {
+        const float re = m_fftOut[k].real(), im = m_fftOut[k].imag();
+        m_power[k] += re * re + im * im;
+    }
+    ++m_averaged;
+    m_sinceFft = 0;
+}
+
+void SpectrumAnalyzer::publish() {
+    Slot& slot = m_slots[m_back];
+    const float scale = m_scale / static_cast<float>(m_averaged);
+    const size_t bins = m_power.size();
+    size_t peakBin = 1;
+    for (size_t k = 0; k < bins; ++k) {
+        const float p = m_power[k] * scale;
+        slot.db[k] = p > 0.0f ? (std::max)(10.0f * std::log10(p), kMeterFloorDb) : kMeterFloorDb;
+        if (k > 0 && slot.db[k] > slot.db[peakBin]) peakBin = k;
+        m_power[k] = 0.0f;
+    }
+    m_averaged = 0;
+
+    // Parabolic interpolation between the neighbouring bins
+    float offset = 0.0f;
+    if (peakBin + 1 < bins) {
+        const float a = slot.db[peakBin - 1], b = slot.db[peakBin], c = slot.db[peakBin + 1];
+        const float denom = a - 2.0f * b + c;
+        if (denom < 0.0f) offset = 0.5f * (a - c) / denom;
+    }
+
+    const UINT64 sequence = m_published.load(std::memory_order_relaxed) + 1;
+    slot.sequence = sequence;
+    m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & 3;
+
+    m_peakHz.store((static_cast<float>(peakBin) + offset) * m_binHz, std::memory_order_relaxed);
+    m_peakDb.store(slot.db[peakBin], std::memory_order_relaxed);
+    m_published.store(sequence, std::memory_order_relaxed);
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Platform.h"
+#include "SampleFormat.h"
+#include "RingBuffer.h"
+#include "RealFft.h"
+
+enum class SpectrumWindow {
+    Hann,
+    BlackmanHarris,     // 4-term, low leakage for weak carriers next to strong ones
+    FlatTop             // accurate levels, wide bins
+};
+
+struct SpectrumOptions {
+    UINT32         fftSize        = 4096;   // power of two, kMinFftSize..kMaxFftSize
+    UINT32         overlapPercent = 50;     // between successive FFTs, 0..95
+    UINT32         updateHz       = 10;     // published frames per second, 1..100
+    UINT32         averages       = 4;      // FFTs averaged into one frame, 1..64
+    UINT32         decimation     = 1;      // low-pass and keep every n-th sample, 1..16
+    SpectrumWindow window         = SpectrumWindow::Hann;
+};
+
+// One published analyzer frame.
+struct SpectrumFrame {
+    UINT64             sequence = 0;    // frames published before this one + 1
+    float              binHz = 0.0f;    // bin spacing; bin k is at k * binHz
+    std::vector<float> db;              // fftSize/2 + 1 bins, dBFS (full-scale sine = 0)
+};
+
+// Spectrum/waterfall analyzer tap.
+//
+// The audio thread only copies: each update interval, the frames the
+// analyzer will actually look at (one segment of averages × hop plus the
+// decimation filter's warm-up) are queued to a side ring behind a small
+// header, and the rest of the interval is skipped without being touched.
+// When the analyzer falls behind, whole segments are dropped and counted.
+//
+// A low-priority analyzer thread mixes each segment to mono, decimates it,
+// windows overlapping blocks, runs a real FFT and averages their power. The
+// finished frame is published through a triple buffer, so readers (the UI,
+// the headless stats) never block the analyzer and always get a whole frame.
+class SpectrumAnalyzer {
+public:
+    SpectrumAnalyzer() = default;
+    ~SpectrumAnalyzer();
+
+    // Sizes everything and starts the analyzer thread. The side ring comes
+    // from 'arena', since the audio thread writes to it.
+    HRESULT start(const AudioFormat& format, const SpectrumOptions& options, AudioArena* arena);
+    void    stop();
+
+    // Audio thread: offer one block
+    void push(const uint8_t* data, uint32_t frames) { tap(data, frames); }
+    void pushSilence(uint32_t frames)               { tap(nullptr, frames); }
+
+    // Any thread: copy of the most recent frame; false if there is none yet
+    bool latest(SpectrumFrame& frame) const;
+
+    bool   isRunning()       const { return m_running.load(std::memory_order_relaxed); }
+    UINT64 frames()          const { return m_published.load(std::memory_order_relaxed); }
+    UINT64 droppedSegments() const { return m_droppedSegments.load(std::memory_order_relaxed); }
+    float  peakHz()          const { return m_peakHz.load(std::memory_order_relaxed); }
+    float  peakDb()          const { return m_peakDb.load(std::memory_order_relaxed); }
+
+    SpectrumAnalyzer(const SpectrumAnalyzer&) = delete;
+    SpectrumAnalyzer& operator=(const SpectrumAnalyzer&) = delete;
+
+private:
+    struct SegmentHeader {
+        uint32_t sequence;
+        uint32_t frames;
+    };
+
+    struct Slot {
+        UINT64             sequence = 0;
+        std::vector<float> db;
+    };
+
+    void tap(const uint8_t* data, uint32_t frames);
+
+    void analyzerLoop();
+    void processSegment(const SegmentHeader& header);
+    void resetHistory();
+    void pushSample(float x);        // mono input rate
+    void addToHistory(float x);      // decimated rate
+    void runFft();
+    void publish();
+
+    AudioFormat                 m_format;
+    SpectrumOptions             m_options;
+    size_t                      m_blockAlign = 0;
+    std::unique_ptr<RingBuffer> m_ring;
+
+    // Tap schedule, audio thread only
+    uint32_t m_intervalFrames = 0;   // input frames per published frame
+    uint32_t m_segmentFrames = 0;    // analyzed frames at the end of each interval
+    uint32_t m_phase = 0;            // position in the current interval
+    uint32_t m_nextSequence = 0;
+    bool     m_queueing = false;     // the current segment fits and is being queued
+
+    // Analyzer thread only
+    RealFft                          m_fft;
+    uint32_t                         m_hop = 0;
+    bool                             m_continuous = false;   // segments follow each other
+    uint32_t                         m_lastSequence = 0;
+    std::vector<uint8_t>             m_raw;
+    std::vector<float>               m_interleaved;
+    std::vector<float>               m_firTaps;
+    std::vector<float>               m_firLine;              // doubled delay line
+    uint32_t                         m_firPos = 0;
+    uint32_t                         m_firFill = 0;
+    uint32_t                         m_decimPhase = 0;
+    std::vector<float>               m_history;              // fftSize decimated samples
+    uint32_t                         m_historyPos = 0;
+    uint32_t                         m_historyFill = 0;
+    uint32_t                         m_sinceFft = 0;
+    std::vector<float>               m_window;
+    float                            m_scale = 1.0f;         // power → full-scale sine = 1
+    std::vector<float>               m_fftIn;
+    std::vector<std::complex<float>> m_fftOut;
+    std::vector<float>               m_power;
+    uint32_t                         m_averaged = 0;
+
+    // Triple buffer: the analyzer fills m_slots[m_back], then swaps it with
+    // the middle slot; a reader swaps the middle slot with its front slot
+    // when the fresh bit is set
+    static constexpr uint32_t kFresh = 4;
+    Slot                          m_slots[3];
+    uint32_t                      m_back = 0;
+    mutable std::atomic<uint32_t> m_middle{1};
+    mutable uint32_t              m_front = 2;
+    mutable std::mutex            m_readMutex;   // readers only; the analyzer never takes it
+
+    std::thread         m_thread;
+    std::atomic<bool>   m_running{false};
+    std::atomic<UINT64> m_published{0};
+    std::atomic<UINT64> m_droppedSegments{0};
+    std::atomic<float>  m_peakHz{0.0f};
+    std::atomic<float>  m_peakDb{0.0f};
+    float               m_binHz = 0.0f;
+};
@@ -0,0 +1,82 @@
+#include "StallWatchdog.h"
+#include <algorithm>
+
+static double elapsedMs(INT64 fromNs, INT64 toNs) {
+    return static_cast<double>(toNs - fromNs) / 1e6;
+}
+
+static INT64 afterMs(INT64 nowNs, double ms) {
+    return nowNs + static_cast<INT64>(ms * 1e6);
+}
+
+void StallWatchdog::reset(double periodMs, INT64 nowNs) {
+    m_stats = WatchdogStats();
+    m_stallAfterMs = (periodMs > 0.0) ? (std::max)(kStallPeriods * periodMs, kStallMinMs) : 0.0;
+    m_periods = 0;
+    m_progressNs = nowNs;
+    m_stallNs = 0;
+    m_nextAttemptNs = 0;
+    m_attempts = 0;
+    m_awaiting = false;
+}
+
+StallWatchdog::Action StallWatchdog::check(INT64 nowNs, UINT64 periods) {
+    if (m_stallAfterMs <= 0.0 || m_stats.gaveUp) return Action::None;
+
+    if (periods != m_periods) {
+        m_periods = periods;
+        m_progressNs = nowNs;
+        if (m_stats.stalled) {
+            // Running again, after a reopen or on its own
+            const double took = elapsedMs(m_stallNs, nowNs);
+            m_stats.stalled = false;
+            ++m_stats.recoveries;
+            m_stats.lastRecoveryMs = took;
+            m_stats.maxRecoveryMs = (std::max)(m_stats.maxRecoveryMs, took);
+            m_attempts = 0;
+            m_awaiting = false;
+        }
+        return Action::None;
+    }
+
+    if (!m_stats.stalled) {
+        if (elapsedMs(m_progressNs, nowNs) < m_stallAfterMs) return Action::None;
+        m_stats.stalled = true;
+        ++m_stats.stalls;
+        m_stallNs = nowNs;
+        m_nextAttemptNs = nowNs;
+        m_attempts = 0;
+        m_awaiting = false;
+    }
+
+    if (nowNs < m_nextAttemptNs) return Action::None;
+    if (m_awaiting) {
+        // Reopened, but no period came within the stall time
+        ++m_stats.failedAttempts;
+        m_awaiting = false;
+    }
+    if (m_attempts >= kMaxAttempts) {
+        m_stats.gaveUp = true;
+        return Action::GiveUp;
+    }
+    return Action::Recover;
+}
+
+void StallWatchdog::recovered(INT64 nowNs, HRESULT hr) {
+    ++m_attempts;
+    if (SUCCEEDED(hr)) {
+        // Give the reopened endpoint a full stall time to deliver a period
+        m_awaiting = true;
+        m_nextAttemptNs = afterMs(nowNs, (std::max)(retryDelayMs(), m_stallAfterMs));
+    } else {
+        ++m_stats.failedAttempts;
+        m_nextAttemptNs = afterMs(nowNs, retryDelayMs());
+    }
+}
+
+double StallWatchdog::retryDelayMs() const {
+    // 100, 200, 400 ... ms after the 1st, 2nd, 3rd attempt, capped
+    double delay = kRetryFirstMs;
+    for (UINT32 i = 1; i < m_attempts && delay < kRetryMaxMs; ++i) delay *= 2.0;
+    return (std::min)(delay, kRetryMaxMs);
+}
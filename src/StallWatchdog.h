@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Platform.h"
+
+// Counters of one supervised endpoint
+struct WatchdogStats {
+    bool   stalled = false;         // periods stopped; recovery in progress
+    bool   gaveUp = false;          // every reopen attempt failed
+    UINT64 stalls = 0;              // times the periods stopped
+    UINT64 recoveries = 0;          // times they ran again afterwards
+    UINT64 failedAttempts = 0;      // reopens that failed or did not bring the periods back
+    double lastRecoveryMs = 0.0;    // stall detected -> periods running again
+    double maxRecoveryMs = 0.0;
+};
+
+// Stall detection and reopen scheduling for one endpoint. The owner calls
+// check() on a short tick with the endpoint's period count; the count has
+// to advance at least every few device periods. Once it stops, check()
+// asks for a reopen right away, then again with doubling delays up to a
+// cap, and gives up after a bounded number of attempts.
+class StallWatchdog {
+public:
+    enum class Action {
+        None,
+        Recover,    // reopen the endpoint now and report the result to recovered()
+        GiveUp      // attempts exhausted; returned once
+    };
+
+    // Not stalled after this many periods without progress (and kStallMinMs)
+    static constexpr double kStallPeriods = 4.0;
+    // Floor for short periods, so scheduling jitter is not taken for a stall
+    static constexpr double kStallMinMs = 100.0;
+    static constexpr double kRetryFirstMs = 100.0;
+    static constexpr double kRetryMaxMs = 5000.0;
+    static constexpr UINT32 kMaxAttempts = 8;
+
+    // Starts supervising an endpoint with the given period; 0 = never stalls
+    void   reset(double periodMs, INT64 nowNs);
+    Action check(INT64 nowNs, UINT64 periods);
+    void   recovered(INT64 nowNs, HRESULT hr);
+
+    const WatchdogStats& stats() const { return m_stats; }
+    double stallAfterMs() const { return m_stallAfterMs; }
+
+private:
+    double retryDelayMs() const;
+
+    WatchdogStats m_stats;
+    double m_stallAfterMs = 0.0;
+    UINT64 m_periods = 0;
+    INT64  m_progressNs = 0;     // last time the count advanced
+    INT64  m_stallNs = 0;        // when the current stall was detected
+    INT64  m_nextAttemptNs = 0;
+    UINT32 m_attempts = 0;       // reopens in the current stall
+    bool   m_awaiting = false;   // the last reopen succeeded; waiting for periods
+};
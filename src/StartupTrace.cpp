@@ -0,0 +1,117 @@
+#include "StartupTrace.h"
+#include <chrono>
+#include <cstdio>
+
+// Trace open on this thread, the innermost open phase and its depth
+static thread_local StartupTrace* t_trace = nullptr;
+static thread_local int           t_phase = -1;
+static thread_local UINT32        t_depth = 0;
+
+INT64 startupClockNs() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    const INT64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    return ns != 0 ? ns : 1;
+}
+
+static double nsToMs(INT64 ns) {
+    return static_cast<double>(ns) / 1e6;
+}
+
+void StartupTrace::begin() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_report = StartupReport();
+        m_beganNs = startupClockNs();
+    }
+    t_trace = this;
+    t_phase = -1;
+    t_depth = 0;
+}
+
+void StartupTrace::end() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_report.totalMs = nsToMs(startupClockNs() - m_beganNs);
+    }
+    if (t_trace == this) t_trace = nullptr;
+}
+
+StartupReport StartupTrace::report(INT64 firstRenderNs) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    StartupReport copy = m_report;
+    if (firstRenderNs != 0 && m_beganNs != 0 && firstRenderNs >= m_beganNs)
+        copy.firstRenderMs = nsToMs(firstRenderNs - m_beganNs);
+    return copy;
+}
+
+StartupTrace::Branch::Branch(StartupTrace& trace) {
+    t_trace = &trace;
+    t_phase = -1;
+    t_depth = 0;
+}
+
+StartupTrace::Branch::~Branch() {
+    t_trace = nullptr;
+}
+
+StartupTimer::StartupTimer(const char* name) {
+    if (t_trace) open(name);
+}
+
+StartupTimer::StartupTimer(const std::string& name) {
+    if (t_trace) open(name);
+}
+
+void StartupTimer::open(const std::string& name) {
+    m_trace = t_trace;
+    m_parent = t_phase;
+    m_startNs = startupClockNs();
+
+    StartupPhase phase;
+    phase.name = name;
+    phase.depth = t_depth++;
+    phase.parent = m_parent;
+
+    std::lock_guard<std::mutex> lock(m_trace->m_mutex);
+    phase.startMs = nsToMs(m_startNs - m_trace->m_beganNs);
+    m_index = static_cast<int>(m_trace->m_report.phases.size());
+    m_trace->m_report.phases.push_back(phase);
+    t_phase = m_index;
+}
+
+StartupTimer::~StartupTimer() {
+    if (!m_trace) return;
+    t_phase = m_parent;
+    --t_depth;
+    std::lock_guard<std::mutex> lock(m_trace->m_mutex);
+    m_trace->m_report.phases[m_index].durationMs = nsToMs(startupClockNs() - m_startNs);
+}
+
+static std::string phaseKey(const std::string& name) {
+    std::string key = name;
+    for (char& c : key)
+        if (c == ' ' || c == '=') c = '_';
+    return key;
+}
+
+std::string describeStartup(const StartupReport& report) {
+    char num[48];
+    std::snprintf(num, sizeof(num), "total=%.1fms", report.totalMs);
+    std::string text = num;
+    if (report.firstRenderMs >= 0.0) {
+        std::snprintf(num, sizeof(num), " first_render=%.1fms", report.firstRenderMs);
+        text += num;
+    }
+
+    // Nested phases are named after their parents: "capture_init.activate"
+    std::vector<std::string> keys;
+    for (const StartupPhase& phase : report.phases) {
+        std::string key = phaseKey(phase.name);
+        if (phase.parent >= 0 && phase.parent < static_cast<int>(keys.size()))
+            key = keys[phase.parent] + '.' + key;
+        std::snprintf(num, sizeof(num), "=%.1fms", phase.durationMs);
+        text += ' ' + key + num;
+        keys.push_back(key);
+    }
+    return text;
+}
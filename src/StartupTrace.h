@@ -0,0 +1,92 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Platform.h"
+
+// Where the time goes while a route starts: AudioRouter::start() opens a
+// trace, and StartupTimer scopes anywhere below it on the same thread (the
+// endpoint init paths, format negotiation) add timed phases to it. Outside a
+// trace the timers do nothing. Other threads working for the same start
+// join the trace with a Branch.
+
+struct StartupPhase {
+    std::string name;
+    UINT32      depth = 0;        // nesting below the route start, 0 = top level
+    int         parent = -1;      // index of the enclosing phase, -1 = top level
+    double      startMs = 0.0;    // since the start of the trace
+    double      durationMs = 0.0;
+};
+
+struct StartupReport {
+    std::vector<StartupPhase> phases;   // in the order they began (interleaved across threads)
+    double totalMs = 0.0;               // the whole start() call, 0 while it runs
+    double firstRenderMs = -1.0;        // first render period since the start, -1 = not yet
+};
+
+// Monotonic clock shared by the trace and the first-period stamp, in ns (never 0)
+INT64 startupClockNs();
+
+class StartupTrace {
+public:
+    // Clears the previous report and collects phases timed on this thread
+    void begin();
+    // Stops collecting and records the total
+    void end();
+
+    INT64 beganNs() const { return m_beganNs; }
+    // Copy of the phases, with the first render period filled in from the
+    // endpoint's stamp (0 = none yet)
+    StartupReport report(INT64 firstRenderNs) const;
+
+    // begin() ... end() for one scope
+    class Scope {
+    public:
+        explicit Scope(StartupTrace& trace) : m_trace(trace) { m_trace.begin(); }
+        ~Scope() { m_trace.end(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        StartupTrace& m_trace;
+    };
+
+    // Timers on the constructing thread record into 'trace' as top-level
+    // phases until the branch ends; must end before the trace does
+    class Branch {
+    public:
+        explicit Branch(StartupTrace& trace);
+        ~Branch();
+        Branch(const Branch&) = delete;
+        Branch& operator=(const Branch&) = delete;
+    };
+
+private:
+    friend class StartupTimer;
+
+    mutable std::mutex m_mutex;   // timers on several threads
+    StartupReport      m_report;
+    INT64              m_beganNs = 0;
+};
+
+// Times the enclosing scope as one phase of the current thread's trace
+class StartupTimer {
+public:
+    explicit StartupTimer(const char* name);
+    explicit StartupTimer(const std::string& name);
+    ~StartupTimer();
+
+    StartupTimer(const StartupTimer&) = delete;
+    StartupTimer& operator=(const StartupTimer&) = delete;
+
+private:
+    void open(const std::string& name);
+
+    StartupTrace* m_trace = nullptr;
+    int           m_index = -1;
+    int           m_parent = -1;
+    INT64         m_startNs = 0;
+};
+
+// "total=412.0ms first_render=431.5ms capture_init=380.2ms capture_init.activate=2.1ms ..."
+std::string describeStartup(const StartupReport& report);
@@ -0,0 +1,128 @@
+#include "UdpSocket.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+
+using SocketLength = int;
+static int  closeSocket(SOCKET s) { return closesocket(s); }
+static bool validSocket(SOCKET s) { return s != INVALID_SOCKET; }
+static int  pollSocket(WSAPOLLFD* fds, ULONG count, int timeoutMs) { return WSAPoll(fds, count, timeoutMs); }
+using PollFd = WSAPOLLFD;
+
+// Winsock needs one WSAStartup per process before any socket call
+static bool ensureWinsock() {
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+#else
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+static constexpr int INVALID_SOCKET = -1;
+using SocketLength = socklen_t;
+static int  closeSocket(int s) { return ::close(s); }
+static bool validSocket(int s) { return s >= 0; }
+static int  pollSocket(pollfd* fds, nfds_t count, int timeoutMs) { return ::poll(fds, count, timeoutMs); }
+using PollFd = pollfd;
+static bool ensureWinsock() { return true; }
+#endif
+
+// Generous receive buffer, so a stalled receive thread loses nothing
+static constexpr int kReceiveBufferBytes = 1 << 20;
+
+// "host:port" or "[v6host]:port"
+static bool splitAddress(const std::string& address, std::string& host, std::string& port) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon + 1 >= address.size()) return false;
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+    return true;
+}
+
+HRESULT UdpSocket::open(const std::string& address, bool passive) {
+    close();
+    if (!ensureWinsock()) return E_FAIL;
+
+    std::string host, port;
+    if (!splitAddress(address, host, port)) return E_INVALIDARG;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    if (passive) hints.ai_flags = AI_PASSIVE;
+
+    addrinfo* list = nullptr;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &list) != 0 || !list)
+        return E_INVALIDARG;
+
+    HRESULT hr = E_FAIL;
+    for (addrinfo* ai = list; ai; ai = ai->ai_next) {
+        auto s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (!validSocket(s)) continue;
+
+        int ok;
+        if (passive) {
+            int on = 1;
+            setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+            int size = kReceiveBufferBytes;
+            setsockopt(s, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&size), sizeof(size));
+            ok = ::bind(s, ai->ai_addr, static_cast<SocketLength>(ai->ai_addrlen));
+        } else {
+            ok = ::connect(s, ai->ai_addr, static_cast<SocketLength>(ai->ai_addrlen));
+        }
+        if (ok == 0) {
+            m_socket = s;
+            hr = S_OK;
+            break;
+        }
+        closeSocket(s);
+    }
+    freeaddrinfo(list);
+    return hr;
+}
+
+HRESULT UdpSocket::bind(const std::string& address) {
+    return open(address, true);
+}
+
+HRESULT UdpSocket::connect(const std::string& address) {
+    return open(address, false);
+}
+
+void UdpSocket::close() {
+    if (validSocket(m_socket)) {
+        closeSocket(m_socket);
+        m_socket = INVALID_SOCKET;
+    }
+}
+
+bool UdpSocket::isOpen() const {
+    return validSocket(m_socket);
+}
+
+int UdpSocket::send(const void* data, size_t bytes) {
+    if (!validSocket(m_socket)) return -1;
+    return static_cast<int>(::send(m_socket, static_cast<const char*>(data), static_cast<int>(bytes), 0));
+}
+
+int UdpSocket::receive(void* data, size_t bytes, UINT32 timeoutMs) {
+    if (!validSocket(m_socket)) return -1;
+
+    PollFd fd = {};
+    fd.fd = m_socket;
+    fd.events = POLLIN;
+    int ready = pollSocket(&fd, 1, static_cast<int>(timeoutMs));
+    if (ready <= 0) return ready;   // timeout (0) or error (-1)
+
+    return static_cast<int>(::recv(m_socket, static_cast<char*>(data), static_cast<int>(bytes), 0));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "Platform.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#endif
+
+// Minimal blocking UDP socket for the network backends.
+//
+// Addresses are "host:port", with IPv6 hosts in brackets ("[::1]:5004").
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    ~UdpSocket() { close(); }
+
+    // Receiving socket bound to a local address ("0.0.0.0:5004" for any)
+    HRESULT bind(const std::string& address);
+    // Sending socket with a fixed destination
+    HRESULT connect(const std::string& address);
+    void    close();
+    bool    isOpen() const;
+
+    // Bytes sent, or -1 on error
+    int send(const void* data, size_t bytes);
+    // Bytes received, 0 if nothing arrived within the timeout, -1 on error
+    int receive(void* data, size_t bytes, UINT32 timeoutMs);
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+private:
+    HRESULT open(const std::string& address, bool passive);
+
+#ifdef _WIN32
+    SOCKET m_socket = INVALID_SOCKET;
+#else
+    int    m_socket = -1;
+#endif
+};
@@ -1,6 +1,9 @@
 #include "WasapiCapture.h"
 #include "DeviceEnumerator.h"
-#include <avrt.h>
+#include "FormatCache.h"
+#include "WasapiDeviceCaps.h"
+#include "RealtimeCheck.h"
+#include "StartupTrace.h"
 #include <audioclient.h>
 
 WasapiCapture::WasapiCapture() {}
@@ -9,13 +12,37 @@ WasapiCapture::~WasapiCapture() {
     stop();
 }
 
-HRESULT WasapiCapture::init(const std::wstring& deviceId, bool exclusive, RingBuffer* ringBuffer) {
+HRESULT WasapiCapture::init(const std::wstring& deviceId, bool exclusive, RingBuffer* ringBuffer,
+                             const AudioFormat* preferredFormat) {
     m_exclusive = exclusive;
     m_ringBuffer = ringBuffer;
+    m_deviceId = wideToUtf8(deviceId);
 
-    RETURN_IF_FAILED(DeviceEnumerator::getDeviceById(deviceId, eCapture, m_device));
-    RETURN_IF_FAILED(m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
-                                         nullptr, reinterpret_cast<void**>(m_audioClient.GetAddressOf())));
+    if (preferredFormat) {
+        m_hasPreferredFormat = true;
+        m_preferredFormat = *preferredFormat;
+    }
+
+    RETURN_IF_FAILED(openDevice());
+    m_format = audioFormatFromWave(&m_waveFormat.Format);
+    initPipeline();
+    return S_OK;
+}
+
+HRESULT WasapiCapture::openDevice() {
+    // Left over from an open that was never started
+    if (m_eventHandle) { CloseHandle(m_eventHandle); m_eventHandle = nullptr; }
+    if (m_stopEvent)   { CloseHandle(m_stopEvent);   m_stopEvent = nullptr; }
+    m_captureClient.Reset();
+    m_audioClient.Reset();
+    m_device.Reset();
+
+    {
+        StartupTimer timer("activate");
+        RETURN_IF_FAILED(DeviceEnumerator::getDeviceById(utf8ToWide(m_deviceId), eCapture, m_device));
+        RETURN_IF_FAILED(m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
+                                             nullptr, reinterpret_cast<void**>(m_audioClient.GetAddressOf())));
+    }
 
     m_eventHandle = CreateEventW(nullptr, FALSE, FALSE, nullptr);
     if (!m_eventHandle) return HRESULT_FROM_WIN32(GetLastError());
@@ -23,11 +50,23 @@ HRESULT WasapiCapture::init(const std::wstring& deviceId, bool exclusive, RingBu
     m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
     if (!m_stopEvent) return HRESULT_FROM_WIN32(GetLastError());
 
-    if (exclusive) {
-        return initExclusive();
-    } else {
-        return initShared();
+    HRESULT hr = S_OK;
+    {
+        StartupTimer timer(m_exclusive ? "negotiate" : "initialize");
+        hr = m_exclusive ? initExclusive() : initShared();
     }
+    return hr;
+}
+
+HRESULT WasapiCapture::recover() {
+    stop();
+    // The ring, resampler and meters are set up for this format: reopen
+    // with it first, and fail if the device now insists on another one
+    m_hasPreferredFormat = true;
+    m_preferredFormat = m_format;
+    RETURN_IF_FAILED(openDevice());
+    if (audioFormatFromWave(&m_waveFormat.Format) != m_format) return AUDCLNT_E_UNSUPPORTED_FORMAT;
+    return start();
 }
 
 HRESULT WasapiCapture::initShared() {
@@ -46,17 +85,17 @@ HRESULT WasapiCapture::initShared() {
 
     // Store format
     if (mixFormat->cbSize >= 22 && mixFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
-        memcpy(&m_format, mixFormat, sizeof(WAVEFORMATEXTENSIBLE));
+        memcpy(&m_waveFormat, mixFormat, sizeof(WAVEFORMATEXTENSIBLE));
     } else {
-        m_format.Format = *mixFormat;
-        m_format.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
-        m_format.Format.cbSize = 22;
-        m_format.Samples.wValidBitsPerSample = mixFormat->wBitsPerSample;
+        m_waveFormat.Format = *mixFormat;
+        m_waveFormat.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+        m_waveFormat.Format.cbSize = 22;
+        m_waveFormat.Samples.wValidBitsPerSample = mixFormat->wBitsPerSample;
         if (mixFormat->nChannels == 1)
-            m_format.dwChannelMask = SPEAKER_FRONT_CENTER;
+            m_waveFormat.dwChannelMask = SPEAKER_FRONT_CENTER;
         else if (mixFormat->nChannels == 2)
-            m_format.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
-        m_format.SubFormat = (mixFormat->wBitsPerSample == 32)
+            m_waveFormat.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+        m_waveFormat.SubFormat = (mixFormat->wBitsPerSample == 32)
             ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
     }
 
@@ -76,83 +115,13 @@ HRESULT WasapiCapture::initExclusive() {
 }
 
 HRESULT WasapiCapture::negotiateExclusiveFormat() {
-    // Try formats in priority order
-    struct FormatAttempt { WORD ch; DWORD rate; WORD bits; bool isFloat; };
-    FormatAttempt attempts[] = {
-        {2, 48000, 32, true},   // 32-bit float 48kHz stereo
-        {2, 48000, 24, false},  // 24-bit PCM 48kHz
-        {2, 48000, 16, false},  // 16-bit PCM 48kHz
-        {2, 44100, 32, true},   // 32-bit float 44.1kHz
-        {2, 44100, 24, false},  // 24-bit PCM 44.1kHz
-        {2, 44100, 16, false},  // 16-bit PCM 44.1kHz
-        {1, 48000, 16, false},  // mono fallbacks
-        {1, 44100, 16, false},
-    };
-
-    for (auto& a : attempts) {
-        HRESULT hr = tryExclusiveFormat(a.ch, a.rate, a.bits, a.isFloat);
-        if (SUCCEEDED(hr)) return S_OK;
-    }
-
-    return AUDCLNT_E_UNSUPPORTED_FORMAT;
-}
-
-HRESULT WasapiCapture::tryExclusiveFormat(WORD channels, DWORD sampleRate,
-                                            WORD bitsPerSample, bool isFloat) {
-    WAVEFORMATEXTENSIBLE wfx = {};
-    wfx.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
-    wfx.Format.nChannels = channels;
-    wfx.Format.nSamplesPerSec = sampleRate;
-    wfx.Format.wBitsPerSample = (bitsPerSample == 24) ? 32 : bitsPerSample; // container size
-    wfx.Format.nBlockAlign = wfx.Format.nChannels * wfx.Format.wBitsPerSample / 8;
-    wfx.Format.nAvgBytesPerSec = wfx.Format.nSamplesPerSec * wfx.Format.nBlockAlign;
-    wfx.Format.cbSize = 22;
-    wfx.Samples.wValidBitsPerSample = bitsPerSample;
-    wfx.SubFormat = isFloat ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
-
-    if (channels == 1) wfx.dwChannelMask = SPEAKER_FRONT_CENTER;
-    else if (channels == 2) wfx.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
-
-    // Check if format is supported
-    HRESULT hr = m_audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE,
-                                                   &wfx.Format, nullptr);
-    if (hr != S_OK) return AUDCLNT_E_UNSUPPORTED_FORMAT;
-
-    REFERENCE_TIME defaultPeriod, minPeriod;
-    RETURN_IF_FAILED(m_audioClient->GetDevicePeriod(&defaultPeriod, &minPeriod));
-
-    // Use half of defaultPeriod for a good latency/reliability balance.
-    // minPeriod alone is too aggressive and causes underruns on most hardware.
-    REFERENCE_TIME requestedDuration = (defaultPeriod / 2 > minPeriod)
-                                        ? defaultPeriod / 2 : minPeriod;
-
-    hr = m_audioClient->Initialize(
-        AUDCLNT_SHAREMODE_EXCLUSIVE,
-        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-        requestedDuration, requestedDuration, &wfx.Format, nullptr);
-
-    // Handle buffer alignment dance
-    if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
-        UINT32 alignedFrames = 0;
-        RETURN_IF_FAILED(m_audioClient->GetBufferSize(&alignedFrames));
-
-        // Release and recreate audio client
-        m_audioClient.Reset();
-        RETURN_IF_FAILED(m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
-                                             nullptr, reinterpret_cast<void**>(m_audioClient.GetAddressOf())));
-
-        requestedDuration = static_cast<REFERENCE_TIME>(
-            10000000.0 * alignedFrames / wfx.Format.nSamplesPerSec + 0.5);
-
-        hr = m_audioClient->Initialize(
-            AUDCLNT_SHAREMODE_EXCLUSIVE,
-            AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-            requestedDuration, requestedDuration, &wfx.Format, nullptr);
-    }
-
-    if (FAILED(hr)) return hr;
-
-    m_format = wfx;
+    // A planned format goes first, then the standard priority list
+    const AudioFormat* preferred = m_hasPreferredFormat ? &m_preferredFormat : nullptr;
+    WasapiDeviceCaps caps(m_device.Get(), m_audioClient);
+    NegotiatedFormat result;
+    RETURN_IF_FAILED(negotiateCached(caps, exclusiveCandidates(preferred), m_formatCachePath,
+                                     formatCacheKey("capture", m_deviceId, preferred), result, &m_negotiation));
+    m_waveFormat = waveFormatFromAudio(result.format);
     return S_OK;
 }
 
@@ -161,6 +130,8 @@ HRESULT WasapiCapture::start() {
 
     m_running.store(true, std::memory_order_release);
     ResetEvent(m_stopEvent);
+    m_threadReport.clear();
+    resetClock();
 
     m_threadHandle = CreateThread(nullptr, 0, captureThread, this, 0, nullptr);
     if (!m_threadHandle) {
@@ -205,16 +176,14 @@ DWORD WINAPI WasapiCapture::captureThread(LPVOID param) {
 }
 
 void WasapiCapture::captureLoop() {
-    // Boost thread priority for pro audio
-    DWORD taskIndex = 0;
-    HANDLE mmcssHandle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+    // MMCSS "Pro Audio", core pinning and denormal flushing per route policy
+    RealtimeThreadScope rt(m_rtPolicy, ThreadRole::Device);
+    m_threadReport.publish(rt.report());
 
+    // On failure the thread just ends and the packet count stops: the
+    // route's watchdog notices and reopens the device
     HRESULT hr = m_audioClient->Start();
-    if (FAILED(hr)) {
-        m_running.store(false);
-        if (mmcssHandle) AvRevertMmThreadCharacteristics(mmcssHandle);
-        return;
-    }
+    if (FAILED(hr)) return;
 
     HANDLE waitHandles[2] = { m_stopEvent, m_eventHandle };
 
@@ -225,34 +194,44 @@ void WasapiCapture::captureLoop() {
             // Stop event signaled
             break;
         }
-        if (waitResult != WAIT_OBJECT_0 + 1 && waitResult != WAIT_TIMEOUT) {
+        if (waitResult == WAIT_TIMEOUT) {
+            // No event from the device; the watchdog decides what that means
+            continue;
+        }
+        if (waitResult != WAIT_OBJECT_0 + 1) {
             break;
         }
 
         // Read available capture packets
+        RealtimeSection section("capture");
         UINT32 packetLength = 0;
-        while (SUCCEEDED(m_captureClient->GetNextPacketSize(&packetLength)) && packetLength > 0) {
+        while (SUCCEEDED(hr = m_captureClient->GetNextPacketSize(&packetLength)) && packetLength > 0) {
             BYTE* data = nullptr;
             UINT32 framesAvailable = 0;
             DWORD flags = 0;
+            UINT64 devicePosition = 0, qpcPosition = 0;
 
-            hr = m_captureClient->GetBuffer(&data, &framesAvailable, &flags, nullptr, nullptr);
+            hr = m_captureClient->GetBuffer(&data, &framesAvailable, &flags, &devicePosition, &qpcPosition);
             if (FAILED(hr)) break;
 
-            size_t byteCount = static_cast<size_t>(framesAvailable) * m_format.Format.nBlockAlign;
+            // First frame of the packet and when the device captured it,
+            // in 100 ns QPC units (the steady clock's base)
+            if (!(flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR))
+                observeClock(devicePosition, static_cast<INT64>(qpcPosition) * 100);
 
+            // The gate forwards audio, or queues silence markers that
+            // downstream stages skip while the input is idle
             if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
-                // Write silence to the ring buffer
-                std::vector<uint8_t> silence(byteCount, 0);
-                m_ringBuffer->write(silence.data(), byteCount);
+                deliverSilence(framesAvailable);
             } else {
-                m_ringBuffer->write(data, byteCount);
+                deliver(data, framesAvailable);
             }
 
             m_captureClient->ReleaseBuffer(framesAvailable);
         }
+        // Device invalidated (unplugged, format change, driver reset)
+        if (FAILED(hr)) break;
     }
 
     m_audioClient->Stop();
-    if (mmcssHandle) AvRevertMmThreadCharacteristics(mmcssHandle);
 }
@@ -6,30 +6,35 @@
 #include <atomic>
 #include <string>
 #include "ComHelper.h"
-#include "RingBuffer.h"
+#include "AudioEndpoint.h"
+#include "FormatNegotiator.h"
 
-class WasapiCapture {
+class WasapiCapture : public CaptureEndpoint {
 public:
     WasapiCapture();
-    ~WasapiCapture();
+    ~WasapiCapture() override;
 
-    HRESULT init(const std::wstring& deviceId, bool exclusive, RingBuffer* ringBuffer);
-    HRESULT start();
-    void    stop();
+    HRESULT init(const std::wstring& deviceId, bool exclusive, RingBuffer* ringBuffer,
+                 const AudioFormat* preferredFormat = nullptr);
+    HRESULT start() override;
+    void    stop() override;
+    HRESULT recover() override;
 
-    const WAVEFORMATEXTENSIBLE& format() const { return m_format; }
-    UINT32 bufferFrames() const { return m_bufferFrames; }
-    bool   isRunning()    const { return m_running.load(std::memory_order_relaxed); }
+    // Exclusive mode: remember negotiated formats in this file (empty = off); set before init()
+    void setFormatCache(const std::string& path) { m_formatCachePath = path; }
+
+    const WAVEFORMATEXTENSIBLE& waveFormat() const { return m_waveFormat; }
+    const NegotiationReport&    negotiation() const { return m_negotiation; }
 
 private:
     static DWORD WINAPI captureThread(LPVOID param);
     void captureLoop();
 
+    // Activate the device and initialize the client, in m_format's place
+    HRESULT openDevice();
     HRESULT initShared();
     HRESULT initExclusive();
     HRESULT negotiateExclusiveFormat();
-    HRESULT tryExclusiveFormat(WORD channels, DWORD sampleRate,
-                                WORD bitsPerSample, bool isFloat);
 
     ComPtr<IMMDevice>           m_device;
     ComPtr<IAudioClient>        m_audioClient;
@@ -38,10 +43,11 @@ private:
     HANDLE                      m_threadHandle = nullptr;
     HANDLE                      m_stopEvent = nullptr;
 
-    WAVEFORMATEXTENSIBLE m_format = {};
-    UINT32               m_bufferFrames = 0;
+    WAVEFORMATEXTENSIBLE m_waveFormat = {};
     bool                 m_exclusive = false;
-    std::atomic<bool>    m_running{false};
-
-    RingBuffer*          m_ringBuffer = nullptr;
+    std::string          m_deviceId;
+    std::string          m_formatCachePath;
+    NegotiationReport    m_negotiation;
+    bool                 m_hasPreferredFormat = false;
+    AudioFormat          m_preferredFormat;
 };
@@ -0,0 +1,31 @@
+#include "WasapiDeviceCaps.h"
+
+bool WasapiDeviceCaps::isSupported(const AudioFormat& format) {
+    WAVEFORMATEXTENSIBLE wfx = waveFormatFromAudio(format);
+    return m_client->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &wfx.Format, nullptr) == S_OK;
+}
+
+HRESULT WasapiDeviceCaps::devicePeriod(HnsTime& defaultPeriod, HnsTime& minPeriod) {
+    REFERENCE_TIME def = 0, min = 0;
+    RETURN_IF_FAILED(m_client->GetDevicePeriod(&def, &min));
+    defaultPeriod = def;
+    minPeriod = min;
+    return S_OK;
+}
+
+HRESULT WasapiDeviceCaps::open(const AudioFormat& format, HnsTime period, UINT32& alignedFrames) {
+    WAVEFORMATEXTENSIBLE wfx = waveFormatFromAudio(format);
+    HRESULT hr = m_client->Initialize(
+        AUDCLNT_SHAREMODE_EXCLUSIVE,
+        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+        period, period, &wfx.Format, nullptr);
+    if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+        RETURN_IF_FAILED(m_client->GetBufferSize(&alignedFrames));
+    return hr;
+}
+
+HRESULT WasapiDeviceCaps::reactivate() {
+    m_client.Reset();
+    return m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
+                              nullptr, reinterpret_cast<void**>(m_client.GetAddressOf()));
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <windows.h>
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+#include "ComHelper.h"
+#include "FormatNegotiator.h"
+
+// DeviceCaps over an exclusive-mode IAudioClient. reactivate() replaces
+// the client in place, so the endpoint keeps using whichever one opened.
+class WasapiDeviceCaps : public DeviceCaps {
+public:
+    WasapiDeviceCaps(IMMDevice* device, ComPtr<IAudioClient>& client)
+        : m_device(device), m_client(client) {}
+
+    bool    isSupported(const AudioFormat& format) override;
+    HRESULT devicePeriod(HnsTime& defaultPeriod, HnsTime& minPeriod) override;
+    HRESULT open(const AudioFormat& format, HnsTime period, UINT32& alignedFrames) override;
+    HRESULT reactivate() override;
+
+private:
+    IMMDevice*            m_device;
+    ComPtr<IAudioClient>& m_client;
+};
@@ -1,6 +1,9 @@
 #include "WasapiRender.h"
 #include "DeviceEnumerator.h"
-#include <avrt.h>
+#include "FormatCache.h"
+#include "WasapiDeviceCaps.h"
+#include "RealtimeCheck.h"
+#include "StartupTrace.h"
 #include <audioclient.h>
 
 WasapiRender::WasapiRender() {}
@@ -10,18 +13,37 @@ WasapiRender::~WasapiRender() {
 }
 
 HRESULT WasapiRender::init(const std::wstring& deviceId, bool exclusive, RingBuffer* ringBuffer,
-                            const WAVEFORMATEXTENSIBLE* preferredFormat) {
+                            const AudioFormat* preferredFormat) {
     m_exclusive = exclusive;
     m_ringBuffer = ringBuffer;
+    m_deviceId = wideToUtf8(deviceId);
 
     if (preferredFormat) {
         m_hasPreferredFormat = true;
         m_preferredFormat = *preferredFormat;
     }
 
-    RETURN_IF_FAILED(DeviceEnumerator::getDeviceById(deviceId, eRender, m_device));
-    RETURN_IF_FAILED(m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
-                                         nullptr, reinterpret_cast<void**>(m_audioClient.GetAddressOf())));
+    RETURN_IF_FAILED(openDevice());
+    m_format = audioFormatFromWave(&m_waveFormat.Format);
+    initPipeline();
+    return S_OK;
+}
+
+HRESULT WasapiRender::openDevice() {
+    // Left over from an open that was never started
+    if (m_eventHandle) { CloseHandle(m_eventHandle); m_eventHandle = nullptr; }
+    if (m_stopEvent)   { CloseHandle(m_stopEvent);   m_stopEvent = nullptr; }
+    m_audioClock.Reset();
+    m_renderClient.Reset();
+    m_audioClient.Reset();
+    m_device.Reset();
+
+    {
+        StartupTimer timer("activate");
+        RETURN_IF_FAILED(DeviceEnumerator::getDeviceById(utf8ToWide(m_deviceId), eRender, m_device));
+        RETURN_IF_FAILED(m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
+                                             nullptr, reinterpret_cast<void**>(m_audioClient.GetAddressOf())));
+    }
 
     m_eventHandle = CreateEventW(nullptr, FALSE, FALSE, nullptr);
     if (!m_eventHandle) return HRESULT_FROM_WIN32(GetLastError());
@@ -29,11 +51,23 @@ HRESULT WasapiRender::init(const std::wstring& deviceId, bool exclusive, RingBuf
     m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
     if (!m_stopEvent) return HRESULT_FROM_WIN32(GetLastError());
 
-    if (exclusive) {
-        return initExclusive();
-    } else {
-        return initShared();
+    HRESULT hr = S_OK;
+    {
+        StartupTimer timer(m_exclusive ? "negotiate" : "initialize");
+        hr = m_exclusive ? initExclusive() : initShared();
     }
+    return hr;
+}
+
+HRESULT WasapiRender::recover() {
+    stop();
+    // The ring, resampler and meters are set up for this format: reopen
+    // with it first, and fail if the device now insists on another one
+    m_hasPreferredFormat = true;
+    m_preferredFormat = m_format;
+    RETURN_IF_FAILED(openDevice());
+    if (audioFormatFromWave(&m_waveFormat.Format) != m_format) return AUDCLNT_E_UNSUPPORTED_FORMAT;
+    return start();
 }
 
 HRESULT WasapiRender::initShared() {
@@ -51,121 +85,51 @@ HRESULT WasapiRender::initShared() {
     RETURN_IF_FAILED(hr);
 
     if (mixFormat->cbSize >= 22 && mixFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
-        memcpy(&m_format, mixFormat, sizeof(WAVEFORMATEXTENSIBLE));
+        memcpy(&m_waveFormat, mixFormat, sizeof(WAVEFORMATEXTENSIBLE));
     } else {
-        m_format.Format = *mixFormat;
-        m_format.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
-        m_format.Format.cbSize = 22;
-        m_format.Samples.wValidBitsPerSample = mixFormat->wBitsPerSample;
+        m_waveFormat.Format = *mixFormat;
+        m_waveFormat.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+        m_waveFormat.Format.cbSize = 22;
+        m_waveFormat.Samples.wValidBitsPerSample = mixFormat->wBitsPerSample;
         if (mixFormat->nChannels == 1)
-            m_format.dwChannelMask = SPEAKER_FRONT_CENTER;
+            m_waveFormat.dwChannelMask = SPEAKER_FRONT_CENTER;
         else if (mixFormat->nChannels == 2)
-            m_format.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
-        m_format.SubFormat = (mixFormat->wBitsPerSample == 32)
+            m_waveFormat.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+        m_waveFormat.SubFormat = (mixFormat->wBitsPerSample == 32)
             ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
     }
 
     RETURN_IF_FAILED(m_audioClient->SetEventHandle(m_eventHandle));
     RETURN_IF_FAILED(m_audioClient->GetBufferSize(&m_bufferFrames));
     RETURN_IF_FAILED(m_audioClient->GetService(IID_PPV_ARGS(&m_renderClient)));
+    RETURN_IF_FAILED(openClock());
 
     return S_OK;
 }
 
+HRESULT WasapiRender::openClock() {
+    RETURN_IF_FAILED(m_audioClient->GetService(IID_PPV_ARGS(&m_audioClock)));
+    return m_audioClock->GetFrequency(&m_clockFrequency);
+}
+
 HRESULT WasapiRender::initExclusive() {
     RETURN_IF_FAILED(negotiateExclusiveFormat());
     RETURN_IF_FAILED(m_audioClient->SetEventHandle(m_eventHandle));
     RETURN_IF_FAILED(m_audioClient->GetBufferSize(&m_bufferFrames));
     RETURN_IF_FAILED(m_audioClient->GetService(IID_PPV_ARGS(&m_renderClient)));
+    RETURN_IF_FAILED(openClock());
     return S_OK;
 }
 
 HRESULT WasapiRender::negotiateExclusiveFormat() {
-    // Try preferred format first (capture device's format) for zero-conversion path
-    if (m_hasPreferredFormat) {
-        bool isFloat = IsEqualGUID(m_preferredFormat.SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
-        HRESULT hr = tryExclusiveFormat(
-            m_preferredFormat.Format.nChannels,
-            m_preferredFormat.Format.nSamplesPerSec,
-            m_preferredFormat.Samples.wValidBitsPerSample,
-            isFloat);
-        if (SUCCEEDED(hr)) return S_OK;
-    }
-
-    // Fall back to standard priority list
-    struct FormatAttempt { WORD ch; DWORD rate; WORD bits; bool isFloat; };
-    FormatAttempt attempts[] = {
-        {2, 48000, 32, true},
-        {2, 48000, 24, false},
-        {2, 48000, 16, false},
-        {2, 44100, 32, true},
-        {2, 44100, 24, false},
-        {2, 44100, 16, false},
-        {1, 48000, 16, false},
-        {1, 44100, 16, false},
-    };
-
-    for (auto& a : attempts) {
-        HRESULT hr = tryExclusiveFormat(a.ch, a.rate, a.bits, a.isFloat);
-        if (SUCCEEDED(hr)) return S_OK;
-    }
-
-    return AUDCLNT_E_UNSUPPORTED_FORMAT;
-}
-
-HRESULT WasapiRender::tryExclusiveFormat(WORD channels, DWORD sampleRate,
-                                           WORD bitsPerSample, bool isFloat) {
-    WAVEFORMATEXTENSIBLE wfx = {};
-    wfx.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
-    wfx.Format.nChannels = channels;
-    wfx.Format.nSamplesPerSec = sampleRate;
-    wfx.Format.wBitsPerSample = (bitsPerSample == 24) ? 32 : bitsPerSample;
-    wfx.Format.nBlockAlign = wfx.Format.nChannels * wfx.Format.wBitsPerSample / 8;
-    wfx.Format.nAvgBytesPerSec = wfx.Format.nSamplesPerSec * wfx.Format.nBlockAlign;
-    wfx.Format.cbSize = 22;
-    wfx.Samples.wValidBitsPerSample = bitsPerSample;
-    wfx.SubFormat = isFloat ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
-
-    if (channels == 1) wfx.dwChannelMask = SPEAKER_FRONT_CENTER;
-    else if (channels == 2) wfx.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
-
-    HRESULT hr = m_audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE,
-                                                   &wfx.Format, nullptr);
-    if (hr != S_OK) return AUDCLNT_E_UNSUPPORTED_FORMAT;
-
-    REFERENCE_TIME defaultPeriod, minPeriod;
-    RETURN_IF_FAILED(m_audioClient->GetDevicePeriod(&defaultPeriod, &minPeriod));
-
-    // Use half of defaultPeriod for a good latency/reliability balance.
-    // minPeriod alone is too aggressive and causes underruns on most hardware.
-    REFERENCE_TIME requestedDuration = (defaultPeriod / 2 > minPeriod)
-                                        ? defaultPeriod / 2 : minPeriod;
-
-    hr = m_audioClient->Initialize(
-        AUDCLNT_SHAREMODE_EXCLUSIVE,
-        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-        requestedDuration, requestedDuration, &wfx.Format, nullptr);
-
-    if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
-        UINT32 alignedFrames = 0;
-        RETURN_IF_FAILED(m_audioClient->GetBufferSize(&alignedFrames));
-
-        m_audioClient.Reset();
-        RETURN_IF_FAILED(m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
-                                             nullptr, reinterpret_cast<void**>(m_audioClient.GetAddressOf())));
-
-        requestedDuration = static_cast<REFERENCE_TIME>(
-            10000000.0 * alignedFrames / wfx.Format.nSamplesPerSec + 0.5);
-
-        hr = m_audioClient->Initialize(
-            AUDCLNT_SHAREMODE_EXCLUSIVE,
-            AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-            requestedDuration, requestedDuration, &wfx.Format, nullptr);
-    }
-
-    if (FAILED(hr)) return hr;
-
-    m_format = wfx;
+    // The preferred format (capture device's format) goes first for a
+    // zero-conversion path, then the standard priority list
+    const AudioFormat* preferred = m_hasPreferredFormat ? &m_preferredFormat : nullptr;
+    WasapiDeviceCaps caps(m_device.Get(), m_audioClient);
+    NegotiatedFormat result;
+    RETURN_IF_FAILED(negotiateCached(caps, exclusiveCandidates(preferred), m_formatCachePath,
+                                     formatCacheKey("render", m_deviceId, preferred), result, &m_negotiation));
+    m_waveFormat = waveFormatFromAudio(result.format);
     return S_OK;
 }
 
@@ -173,8 +137,10 @@ HRESULT WasapiRender::start() {
     if (m_running.load()) return S_FALSE;
 
     m_running.store(true, std::memory_order_release);
-    m_underruns.store(0, std::memory_order_relaxed);
+    resetPipeline();
+    resetClock();
     ResetEvent(m_stopEvent);
+    m_threadReport.clear();
 
     m_threadHandle = CreateThread(nullptr, 0, renderThread, this, 0, nullptr);
     if (!m_threadHandle) {
@@ -219,25 +185,23 @@ DWORD WINAPI WasapiRender::renderThread(LPVOID param) {
 }
 
 void WasapiRender::renderLoop() {
-    DWORD taskIndex = 0;
-    HANDLE mmcssHandle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+    RealtimeThreadScope rt(m_rtPolicy, ThreadRole::Device);
+    m_threadReport.publish(rt.report());
 
     // Pre-roll: fill buffer with silence before starting
     {
         BYTE* data = nullptr;
         HRESULT hr = m_renderClient->GetBuffer(m_bufferFrames, &data);
         if (SUCCEEDED(hr)) {
-            memset(data, 0, static_cast<size_t>(m_bufferFrames) * m_format.Format.nBlockAlign);
+            memset(data, 0, static_cast<size_t>(m_bufferFrames) * m_waveFormat.Format.nBlockAlign);
             m_renderClient->ReleaseBuffer(m_bufferFrames, AUDCLNT_BUFFERFLAGS_SILENT);
         }
     }
 
+    // On failure the thread just ends and the period count stops: the
+    // route's watchdog notices and reopens the device
     HRESULT hr = m_audioClient->Start();
-    if (FAILED(hr)) {
-        m_running.store(false);
-        if (mmcssHandle) AvRevertMmThreadCharacteristics(mmcssHandle);
-        return;
-    }
+    if (FAILED(hr)) return;
 
     HANDLE waitHandles[2] = { m_stopEvent, m_eventHandle };
 
@@ -247,10 +211,15 @@ void WasapiRender::renderLoop() {
         if (waitResult == WAIT_OBJECT_0) {
             break;
         }
-        if (waitResult != WAIT_OBJECT_0 + 1 && waitResult != WAIT_TIMEOUT) {
+        if (waitResult == WAIT_TIMEOUT) {
+            // No event from the device; the watchdog decides what that means
+            continue;
+        }
+        if (waitResult != WAIT_OBJECT_0 + 1) {
             break;
         }
 
+        RealtimeSection section("render");
         UINT32 padding = 0;
         if (m_exclusive) {
             // In exclusive mode, buffer is always fully available after event
@@ -265,25 +234,20 @@ void WasapiRender::renderLoop() {
 
         BYTE* data = nullptr;
         hr = m_renderClient->GetBuffer(framesAvailable, &data);
-        if (FAILED(hr)) continue;
-
-        size_t bytesNeeded = static_cast<size_t>(framesAvailable) * m_format.Format.nBlockAlign;
-        size_t bytesRead = m_ringBuffer->read(data, bytesNeeded);
-
-        if (bytesRead < bytesNeeded) {
-            // Underrun: fill remainder with silence
-            memset(data + bytesRead, 0, bytesNeeded - bytesRead);
-            m_underruns.fetch_add(1, std::memory_order_relaxed);
-            if (bytesRead == 0) {
-                m_renderClient->ReleaseBuffer(framesAvailable, AUDCLNT_BUFFERFLAGS_SILENT);
-            } else {
-                m_renderClient->ReleaseBuffer(framesAvailable, 0);
-            }
-        } else {
-            m_renderClient->ReleaseBuffer(framesAvailable, 0);
+        // Device invalidated (unplugged, format change, driver reset)
+        if (FAILED(hr)) break;
+
+        bool silent = pull(data, framesAvailable);
+        m_renderClient->ReleaseBuffer(framesAvailable, silent ? AUDCLNT_BUFFERFLAGS_SILENT : 0);
+
+        // Play position and when the device reached it, in 100 ns QPC units
+        // (the steady clock's base); the position counts in clock units
+        UINT64 position = 0, qpcPosition = 0;
+        if (m_clockFrequency > 0 && SUCCEEDED(m_audioClock->GetPosition(&position, &qpcPosition))) {
+            const double frames = static_cast<double>(position) * m_format.sampleRate / m_clockFrequency;
+            observeClock(static_cast<UINT64>(frames), static_cast<INT64>(qpcPosition) * 100);
         }
     }
 
     m_audioClient->Stop();
-    if (mmcssHandle) AvRevertMmThreadCharacteristics(mmcssHandle);
 }
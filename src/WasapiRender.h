@@ -6,48 +6,51 @@
 #include <atomic>
 #include <string>
 #include "ComHelper.h"
-#include "RingBuffer.h"
+#include "AudioEndpoint.h"
+#include "FormatNegotiator.h"
 
-class WasapiRender {
+class WasapiRender : public RenderEndpoint {
 public:
     WasapiRender();
-    ~WasapiRender();
+    ~WasapiRender() override;
 
     HRESULT init(const std::wstring& deviceId, bool exclusive, RingBuffer* ringBuffer,
-                 const WAVEFORMATEXTENSIBLE* preferredFormat = nullptr);
-    HRESULT start();
-    void    stop();
-    void    setRingBuffer(RingBuffer* rb) { m_ringBuffer = rb; }
+                 const AudioFormat* preferredFormat = nullptr);
+    HRESULT start() override;
+    void    stop() override;
+    HRESULT recover() override;
 
-    const WAVEFORMATEXTENSIBLE& format() const { return m_format; }
-    UINT32 bufferFrames()  const { return m_bufferFrames; }
-    bool   isRunning()     const { return m_running.load(std::memory_order_relaxed); }
-    UINT64 underrunCount() const { return m_underruns.load(std::memory_order_relaxed); }
+    // Exclusive mode: remember negotiated formats in this file (empty = off); set before init()
+    void setFormatCache(const std::string& path) { m_formatCachePath = path; }
+
+    const WAVEFORMATEXTENSIBLE& waveFormat() const { return m_waveFormat; }
+    const NegotiationReport&    negotiation() const { return m_negotiation; }
 
 private:
     static DWORD WINAPI renderThread(LPVOID param);
     void renderLoop();
 
+    // Activate the device and initialize the client, in m_format's place
+    HRESULT openDevice();
     HRESULT initShared();
     HRESULT initExclusive();
     HRESULT negotiateExclusiveFormat();
-    HRESULT tryExclusiveFormat(WORD channels, DWORD sampleRate,
-                                WORD bitsPerSample, bool isFloat);
+    HRESULT openClock();
 
     ComPtr<IMMDevice>          m_device;
     ComPtr<IAudioClient>       m_audioClient;
     ComPtr<IAudioRenderClient> m_renderClient;
+    ComPtr<IAudioClock>        m_audioClock;
+    UINT64                     m_clockFrequency = 0;   // position units per second
     HANDLE                     m_eventHandle = nullptr;
     HANDLE                     m_threadHandle = nullptr;
     HANDLE                     m_stopEvent = nullptr;
 
-    WAVEFORMATEXTENSIBLE m_format = {};
-    UINT32               m_bufferFrames = 0;
+    WAVEFORMATEXTENSIBLE m_waveFormat = {};
     bool                 m_exclusive = false;
+    std::string          m_deviceId;
+    std::string          m_formatCachePath;
+    NegotiationReport    m_negotiation;
     bool                 m_hasPreferredFormat = false;
-    WAVEFORMATEXTENSIBLE m_preferredFormat = {};
-    std::atomic<bool>    m_running{false};
-    std::atomic<UINT64>  m_underruns{0};
-
-    RingBuffer*          m_ringBuffer = nullptr;
+    AudioFormat          m_preferredFormat;
 };
@@ -0,0 +1,136 @@
+#include "WavFile.h"
+#include <cstring>
+#include <vector>
+
+static uint16_t rd16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+static uint32_t rd32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+static uint64_t rd64(const uint8_t* p) {
+    return static_cast<uint64_t>(rd32(p)) | (static_cast<uint64_t>(rd32(p + 4)) << 32);
+}
+static void wr16(uint8_t* p, uint16_t v) { p[0] = v & 0xff; p[1] = v >> 8; }
+static void wr32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = v >> 24;
+}
+static void wr64(uint8_t* p, uint64_t v) {
+    wr32(p, static_cast<uint32_t>(v));
+    wr32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+bool parseWavHeader(const uint8_t* data, size_t size, WavInfo& info) {
+    if (size < 12 || std::memcmp(data + 8, "WAVE", 4) != 0) return false;
+    bool rf64 = std::memcmp(data, "RF64", 4) == 0;
+    if (!rf64 && std::memcmp(data, "RIFF", 4) != 0) return false;
+
+    bool haveFmt = false;
+    uint64_t ds64DataBytes = 0;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t* chunk = data + pos;
+        uint32_t chunkSize = rd32(chunk + 4);
+
+        if (std::memcmp(chunk, "ds64", 4) == 0) {
+            // 64-bit sizes of an RF64 file: RIFF size, then data size
+            if (chunkSize < 24 || pos + 8 + 24 > size) return false;
+            ds64DataBytes = rd64(chunk + 16);
+        } else if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || pos + 8 + 16 > size) return false;
+            const uint8_t* fmt = chunk + 8;
+            uint16_t tag      = rd16(fmt);
+            uint16_t channels = rd16(fmt + 2);
+            uint32_t rate     = rd32(fmt + 4);
+            uint16_t bits     = rd16(fmt + 14);
+            uint16_t valid    = bits;
+
+            // WAVE_FORMAT_EXTENSIBLE: the sub-format GUID starts with the real tag
+            if (tag == 0xFFFE && chunkSize >= 40 && pos + 8 + 40 <= size) {
+                valid = rd16(fmt + 18);
+                tag = rd16(fmt + 24);
+            }
+
+            SampleType type = SampleType::Unknown;
+            if (tag == 3 && bits == 32)  type = SampleType::Float32;
+            else if (tag == 1 && bits == 16) type = SampleType::Int16;
+            else if (tag == 1 && bits == 24) type = SampleType::Int24;
+            else if (tag == 1 && bits == 32) type = SampleType::Int32;
+            if (type == SampleType::Unknown || channels == 0 || rate == 0) return false;
+
+            info.format = makeAudioFormat(rate, channels, type);
+            if (valid > 0 && valid <= bits) info.format.validBits = valid;
+            haveFmt = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFmt) return false;
+            info.dataOffset = pos + 8;
+            info.dataBytes = (rf64 && chunkSize == 0xFFFFFFFFu) ? ds64DataBytes : chunkSize;
+            return true;
+        }
+
+        pos += 8 + static_cast<size_t>(chunkSize) + (chunkSize & 1);
+    }
+    return false;
+}
+
+void buildWav64Header(uint8_t* h, const AudioFormat& format, uint64_t dataBytes) {
+    std::memset(h, 0, kWav64HeaderBytes);
+    const uint64_t riffBytes = kWav64HeaderBytes - 8 + dataBytes;
+    const bool rf64 = riffBytes > 0xFFFFFFFFull;
+
+    std::memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+    wr32(h + 4, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(riffBytes));
+    std::memcpy(h + 8, "WAVE", 4);
+
+    // 28 bytes reserved up front, so switching to RF64 never moves the data
+    std::memcpy(h + 12, rf64 ? "ds64" : "JUNK", 4);
+    wr32(h + 16, 28);
+    if (rf64) {
+        wr64(h + 20, riffBytes);
+        wr64(h + 28, dataBytes);
+        wr64(h + 36, dataBytes / format.blockAlign());
+        wr32(h + 44, 0);    // no table entries
+    }
+
+    std::memcpy(h + 48, "fmt ", 4);
+    wr32(h + 52, 16);
+    wr16(h + 56, format.type == SampleType::Float32 ? 3 : 1);
+    wr16(h + 58, format.channels);
+    wr32(h + 60, format.sampleRate);
+    wr32(h + 64, format.sampleRate * format.blockAlign());
+    wr16(h + 68, static_cast<uint16_t>(format.blockAlign()));
+    wr16(h + 70, format.bitsPerSample);
+    std::memcpy(h + 72, "data", 4);
+    wr32(h + 76, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(dataBytes));
+}
+
+bool writeWav64Header(FILE* f, const AudioFormat& format, uint64_t dataBytes) {
+    uint8_t h[kWav64HeaderBytes];
+    buildWav64Header(h, format, dataBytes);
+    return std::fwrite(h, 1, sizeof(h), f) == sizeof(h);
+}
+
+#ifdef _WIN32
+#include "Platform.h"
+
+FILE* openFileUtf8(const char* path, const char* mode) {
+    FILE* f = nullptr;
+    _wfopen_s(&f, utf8ToWide(path).c_str(), utf8ToWide(mode).c_str());
+    return f;
+}
+#else
+FILE* openFileUtf8(const char* path, const char* mode) {
+    return std::fopen(path, mode);
+}
+#endif
+
+// Headers with metadata chunks in front of the data are still well below this
+static constexpr size_t kHeaderProbeBytes = 64 * 1024;
+
+bool readWavHeader(const char* path, WavInfo& info) {
+    FILE* f = openFileUtf8(path, "rb");
+    if (!f) return false;
+    std::vector<uint8_t> head(kHeaderProbeBytes);
+    const size_t got = std::fread(head.data(), 1, head.size(), f);
+    std::fclose(f);
+    return parseWavHeader(head.data(), got, info);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include "SampleFormat.h"
+
+// Location and format of the sample data inside a WAV file.
+struct WavInfo {
+    AudioFormat format;
+    uint64_t    dataOffset = 0;   // byte offset of the first sample
+    uint64_t    dataBytes  = 0;   // length of the sample data
+};
+
+// Parse a RIFF/WAVE or RF64 header from the start of a file.
+// 'size' is the number of bytes available at 'data'.
+bool parseWavHeader(const uint8_t* data, size_t size, WavInfo& info);
+
+// Read and parse the header of a file without mapping it; false if it is
+// not a WAV file or its header is unusually long
+bool readWavHeader(const char* path, WavInfo& info);
+
+// Header written by writeWav64Header(): the canonical 44 bytes plus a JUNK
+// chunk that becomes the ds64 chunk once the data outgrows 4 GB (RF64,
+// EBU Tech 3306). Sample data starts at this offset.
+static constexpr size_t kWav64HeaderBytes = 80;
+
+// Write a header that can be rewritten in place as the recording grows:
+// plain WAV while the data fits the 32-bit sizes, RF64 beyond that.
+bool writeWav64Header(FILE* f, const AudioFormat& format, uint64_t dataBytes);
+// Same header into memory, e.g. the start of a mapped file
+void buildWav64Header(uint8_t* out, const AudioFormat& format, uint64_t dataBytes);
+
+// fopen() for UTF-8 paths on every platform.
+FILE* openFileUtf8(const char* path, const char* mode);
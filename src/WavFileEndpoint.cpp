@@ -0,0 +1,147 @@
+#include "WavFileEndpoint.h"
+#include <algorithm>
+#include <cstring>
+
+// Read-ahead in front of the capture position, in seconds of audio
+static constexpr uint32_t kPrefetchSeconds = 4;
+// The render file grows by this much whenever the mapping is full
+static constexpr uint64_t kGrowBytes = 64ull * 1024 * 1024;
+
+// ── Capture ───────────────────────────────────────────────────────
+
+WavFileCapture::~WavFileCapture() {
+    stop();
+}
+
+HRESULT WavFileCapture::init(const std::string& path, bool loop, RingBuffer* ringBuffer) {
+    RETURN_IF_FAILED(m_file.openRead(path));
+    if (!m_file.data() || !parseWavHeader(m_file.data(), static_cast<size_t>(m_file.size()), m_info))
+        return E_INVALIDARG;
+
+    // A truncated file plays what is there; partial frames are ignored
+    const uint64_t blockAlign = m_info.format.blockAlign();
+    if (m_info.dataOffset > m_file.size()) return E_INVALIDARG;
+    m_info.dataBytes = (std::min)(m_info.dataBytes, m_file.size() - m_info.dataOffset);
+    m_info.dataBytes -= m_info.dataBytes % blockAlign;
+
+    m_format = m_info.format;
+    m_position = 0;
+    m_loop = loop;
+    m_ringBuffer = ringBuffer;
+    m_prefetchBytes = static_cast<uint64_t>(m_format.sampleRate) * blockAlign * kPrefetchSeconds;
+    m_prefetched = 0;
+    prefetchAhead();
+
+    initPeriod();
+    initPipeline();
+    return S_OK;
+}
+
+void WavFileCapture::prefetchAhead() {
+    // Renewed once the position is halfway into the last request
+    if (m_position + m_prefetchBytes / 2 < m_prefetched) return;
+    m_file.prefetch(m_info.dataOffset + m_position, m_prefetchBytes);
+    m_prefetched = m_position + m_prefetchBytes;
+}
+
+const uint8_t* WavFileCapture::produce(uint32_t frames) {
+    const size_t want = static_cast<size_t>(frames) * m_format.blockAlign();
+    const uint8_t* data = m_file.data() + m_info.dataOffset;
+    const uint64_t end = m_info.dataBytes;
+
+    if (m_position >= end) {
+        if (!m_loop || end == 0) {
+            endOfStream();
+            return nullptr;
+        }
+        m_position = 0;
+        m_prefetched = 0;
+    }
+    prefetchAhead();
+
+    // Common case: the whole packet straight from the mapping
+    if (m_position + want <= end) {
+        const uint8_t* packet = data + m_position;
+        m_position += want;
+        return packet;
+    }
+
+    // The packet crosses the end of the data: wrap around or pad with silence
+    uint8_t* out = periodBuffer();
+    size_t done = 0;
+    while (done < want) {
+        if (m_position >= end) {
+            if (!m_loop) break;
+            m_position = 0;
+            m_prefetched = 0;
+        }
+        size_t n = static_cast<size_t>((std::min)(static_cast<uint64_t>(want - done), end - m_position));
+        std::memcpy(out + done, data + m_position, n);
+        done += n;
+        m_position += n;
+    }
+    if (done < want) std::memset(out + done, 0, want - done);
+    return out;
+}
+
+// ── Render ────────────────────────────────────────────────────────
+
+WavFileRender::~WavFileRender() {
+    stop();
+}
+
+HRESULT WavFileRender::init(const std::string& path, const AudioFormat& format,
+                            RingBuffer* ringBuffer, const AudioFormat* preferredFormat) {
+    if (format.isValid())
+        m_format = format;
+    else if (preferredFormat && preferredFormat->isValid())
+        m_format = *preferredFormat;
+    else
+        return E_INVALIDARG;
+
+    RETURN_IF_FAILED(m_file.create(path, kWav64HeaderBytes + kGrowBytes));
+    buildWav64Header(m_file.data(), m_format, 0);
+
+    m_written = 0;
+    m_full = false;
+    m_ringBuffer = ringBuffer;
+    initPeriod();
+    initPipeline();
+    return S_OK;
+}
+
+void WavFileRender::stop() {
+    PacedRender::stop();
+
+    if (m_file.data()) {
+        // Final sizes, then cut off the unused growth
+        buildWav64Header(m_file.data(), m_format, m_written);
+        m_file.resize(kWav64HeaderBytes + m_written);
+        m_file.close();
+    }
+}
+
+uint8_t* WavFileRender::periodTarget(uint32_t frames) {
+    const uint64_t bytes = static_cast<uint64_t>(frames) * m_format.blockAlign();
+    const uint64_t needed = kWav64HeaderBytes + m_written + bytes;
+
+    if (!m_full && needed > m_file.size()) {
+        // Rare (every 64 MB); remapping is the only blocking work here
+        if (FAILED(m_file.resize(m_file.size() + kGrowBytes))) {
+            m_full = true;
+            m_file.resize(kWav64HeaderBytes + m_written);
+        }
+    }
+    if (m_full || !m_file.data()) return PacedRender::periodTarget(frames);
+    return m_file.data() + kWav64HeaderBytes + m_written;
+}
+
+void WavFileRender::consume(const uint8_t*, uint32_t frames, bool silent) {
+    if (m_full || !m_file.data()) return;
+
+    // pull() rendered into the mapping already; a silent period may have
+    // left stale bytes there
+    const size_t bytes = static_cast<size_t>(frames) * m_format.blockAlign();
+    if (silent) std::memset(m_file.data() + kWav64HeaderBytes + m_written, 0, bytes);
+    m_written += bytes;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include "PacedEndpoint.h"
+#include "MappedFile.h"
+#include "WavFile.h"
+
+// Capture from a WAV or RF64 file, optionally looping.
+//
+// The file is memory-mapped and packets are delivered straight from the
+// mapping; only a packet that straddles the end of the data is assembled in
+// the period buffer. Read-ahead is requested a few seconds in front of the
+// play position. Without looping the stream ends after the last sample.
+class WavFileCapture : public PacedCapture {
+public:
+    ~WavFileCapture() override;
+
+    HRESULT init(const std::string& path, bool loop, RingBuffer* ringBuffer);
+
+protected:
+    const uint8_t* produce(uint32_t frames) override;
+
+private:
+    void prefetchAhead();
+
+    MappedFile m_file;
+    WavInfo    m_info;
+    uint64_t   m_position = 0;      // bytes into the data chunk
+    uint64_t   m_prefetched = 0;    // read-ahead requested up to here
+    uint64_t   m_prefetchBytes = 0;
+    bool       m_loop = true;
+};
+
+// Render into a WAV file (RF64 beyond 4 GB) through a writable mapping.
+//
+// Periods are rendered in place into the mapped file; the file grows in
+// large steps and is trimmed to the data and given its final header on stop().
+class WavFileRender : public PacedRender {
+public:
+    ~WavFileRender() override;
+
+    HRESULT init(const std::string& path, const AudioFormat& format, RingBuffer* ringBuffer,
+                 const AudioFormat* preferredFormat = nullptr);
+    void    stop() override;
+
+protected:
+    uint8_t* periodTarget(uint32_t frames) override;
+    void     consume(const uint8_t* data, uint32_t frames, bool silent) override;
+
+private:
+    MappedFile m_file;
+    uint64_t   m_written = 0;       // sample bytes after the header
+    bool       m_full = false;      // the file could not grow; periods are discarded
+};
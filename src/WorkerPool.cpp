@@ -0,0 +1,113 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#ifdef _WIN32
+#include "ComHelper.h"
+#endif
+
+// Upper bound on how long an idle worker sleeps before polling its jobs again
+static constexpr UINT32 kMaxIdleMs = 10;
+
+WorkerPool::WorkerPool(UINT32 threadCount, const RealtimePolicy& policy)
+    : m_policy(policy)
+{
+    if (threadCount == 0) {
+        // Half the cores, at least one and at most four: the jobs are light
+        // and should not compete with the realtime device threads
+        UINT32 cores = std::thread::hardware_concurrency();
+        threadCount = (std::min)((std::max)(cores / 2, 1u), 4u);
+    }
+    m_threadCount = threadCount;
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_threads)
+        if (t.joinable()) t.join();
+}
+
+WorkerPool::JobId WorkerPool::addJob(Job job) {
+    auto entry = std::make_shared<Entry>();
+    entry->job = std::move(job);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry->id = m_nextId++;
+        m_jobs.push_back(entry);
+        ++m_generation;
+
+        // Threads are only created once there is something to run
+        if (m_threads.empty()) {
+            for (UINT32 i = 0; i < m_threadCount; ++i)
+                m_threads.emplace_back(&WorkerPool::workerLoop, this, i);
+        }
+    }
+    m_wake.notify_all();
+    return entry->id;
+}
+
+void WorkerPool::removeJob(JobId id) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find_if(m_jobs.begin(), m_jobs.end(),
+                               [id](const std::shared_ptr<Entry>& e) { return e->id == id; });
+        if (it == m_jobs.end()) return;
+        entry = *it;
+        m_jobs.erase(it);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    // Workers may still hold a stale copy of the job list; once 'removed' is
+    // set under the run lock none of them will call the job again
+    std::lock_guard<std::mutex> run(entry->runLock);
+    entry->removed = true;
+}
+
+size_t WorkerPool::jobCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+void WorkerPool::workerLoop(UINT32 index) {
+#ifdef _WIN32
+    // The MF resampler runs on these threads
+    CoInitializeGuard comGuard(COINIT_MULTITHREADED);
+#endif
+    RealtimeThreadScope rt(m_policy, ThreadRole::Worker);
+    if (index == 0) m_threadReport.publish(rt.report());
+
+    std::vector<std::shared_ptr<Entry>> jobs;
+    UINT64 seen = ~0ull;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+            if (m_quit) return;
+            if (seen != m_generation) {
+                jobs = m_jobs;
+                seen = m_generation;
+            }
+        }
+
+        UINT32 waitMs = kMaxIdleMs;
+        for (auto& entry : jobs) {
+            // Busy on another worker: skip it this pass
+            std::unique_lock<std::mutex> run(entry->runLock, std::try_to_lock);
+            if (!run.owns_lock() || entry->removed) continue;
+            waitMs = (std::min)(waitMs, entry->job());
+        }
+
+        if (waitMs > 0) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(waitMs),
+                            [this, seen] { return m_quit || m_generation != seen; });
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Platform.h"
+#include "RealtimeThread.h"
+
+// Small fixed pool of threads shared by the non-realtime stages of all
+// routes (currently the resamplers).
+//
+// Work is registered as a polling job instead of a one-shot task: a job is
+// called over and over and returns 0 when it made progress, or the number of
+// milliseconds it is happy to wait before being polled again. A job never
+// runs on two workers at once, so it may keep single-consumer state.
+// With no jobs registered the workers block and cost nothing.
+class WorkerPool {
+public:
+    using Job   = std::function<UINT32()>;
+    using JobId = UINT64;
+
+    // 0 threads picks a default based on the number of cores. Workers run
+    // with the policy's Worker role (below the device threads).
+    explicit WorkerPool(UINT32 threadCount = 0, const RealtimePolicy& policy = RealtimePolicy());
+    ~WorkerPool();
+
+    JobId addJob(Job job);
+
+    // Unregisters a job and waits until no worker is executing it anymore
+    void removeJob(JobId id);
+
+    UINT32 threadCount() const { return m_threadCount; }
+    // What the first worker obtained (not applied until a job was added)
+    RealtimeReport threadReport() const { return m_threadReport.load(); }
+    size_t jobCount() const;
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+private:
+    struct Entry {
+        JobId      id;
+        Job        job;
+        std::mutex runLock;      // held while a worker executes the job
+        bool       removed = false;
+    };
+
+    void workerLoop(UINT32 index);
+
+    UINT32                   m_threadCount;
+    RealtimePolicy           m_policy;
+    RealtimeReportSlot       m_threadReport;
+    std::vector<std::thread> m_threads;
+
+    mutable std::mutex                  m_mutex;
+    std::condition_variable             m_wake;
+    std::vector<std::shared_ptr<Entry>> m_jobs;
+    UINT64                              m_generation = 0; // bumped on every add/remove
+    JobId                               m_nextId = 1;
+    bool                                m_quit = false;
+};